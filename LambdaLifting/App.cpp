@@ -5,9 +5,19 @@
 #include "stdafx.h"
 #include "App.h"
 
+#include <climits>
+
 #include "Map.h"
 #include "Simulator.h"
 #include "Controller.h"
+#include "SessionWriter.h"
+#include "Solver.h"
+#include "GeneticOptimizer.h"
+#include "RouteMinimizer.h"
+#include "Replay.h"
+#include "BeamSearch.h"
+#include "BackgroundSolver.h"
+#include "TaskPool.h"
 
 namespace {
 
@@ -15,6 +25,63 @@ namespace {
 
 	const s3d::wchar* CONFIG_FILE = L"config.ini";
 
+	const s3d::wchar* JOURNAL_FILE = L"commands.journal";
+
+	// Evolve{^ŉǂ鎞 [s]
+	const f64 EVOLVE_SECONDS = 5.0;
+
+	// Minimize{^ŒZ鎞Ԃ̏ [s]
+	const f64 MINIMIZE_SECONDS = 10.0;
+
+	// Solve{^ŒT鎞Ԃ̏ [s]BGUI͎~܂炸ArŒfł
+	const f64 SOLVE_SECONDS = 60.0;
+
+	// Solve{^̃r[T[`̕
+	const u32 SOLVE_WIDTH = 1000;
+
+	//-----------------------------------------------------------------------------
+	//! obNOEh̃\o[̃Xbh
+	//! `悪xȂ悤1RA󂯂Ă
+	//-----------------------------------------------------------------------------
+	u32 backgroundThreadNum()
+	{
+		return std::max(1u, app::TaskPool::defaultThreadNum() - 1);
+	}
+
+	//===================================================================================
+	//! @class MinimizeSolver
+	//! RouteMinimizer  BackgroundSolver ő点
+	//! Z[g1 publish Bfꂽ炻܂ł̌ʂԂ
+	//===================================================================================
+	class MinimizeSolver : public app::Solver
+	{
+	public:
+		MinimizeSolver(const s3d::String& route, u32 threadNum)
+			: mRoute(route)
+			, mThreadNum(threadNum)
+		{
+		}
+
+		const s3d::wchar* getName() const override { return L"minimize"; }
+
+		void solve(const app::Map& map, app::SolverContext& ctx) override
+		{
+			// Ԃ̏ ctx 
+			app::RouteMinimizer minimizer(mThreadNum);
+			minimizer.setCancelCallback([&ctx] { return ctx.isCancelled(); });
+			const s3d::String route = minimizer.minimize(map, mRoute);
+
+			app::Map replayed = map;
+			app::replayRoute(route, replayed);
+			ctx.publish(route, app::finalScore(replayed));
+			ctx.addNodeNum(minimizer.getCandidateNum());
+		}
+
+	private:
+		s3d::String mRoute;
+		u32 mThreadNum;
+	};
+
 }
 
 
@@ -29,6 +96,8 @@ namespace app
 		, mpInteractiveController(new InteractiveController)
 		, mpAutoController(new AutoController)
 		, mpGUI(new AppGUI(this))
+		, mpSessionWriter(new SessionWriter(CONFIG_FILE, JOURNAL_FILE))
+		, mpBackgroundSolver(new BackgroundSolver)
 	{
 	}
 
@@ -41,14 +110,16 @@ namespace app
 
 	//-----------------------------------------------------------------------------
 	//! INIt@Cۑ
+	//! ۂ̏oSessionWriter̃Xbhōs
 	//-----------------------------------------------------------------------------
 	void App::saveINI()
 	{
-		s3d::INIWriter ini(CONFIG_FILE);
-		ini.write(L"Map", L"filepath", mpSimulator->getFilePath());
-		ini.write(L"GUI", L"commands", mpGUI->getCommands());
-		ini.write(L"GUI", L"speed", mpGUI->getSpeed());
-		ini.write(L"GUI", L"trail", mpGUI->getTrail());
+		Session session;
+		session.filepath = mpSimulator->getFilePath();
+		session.commands = mpGUI->getCommands();
+		session.speed = mpGUI->getSpeed();
+		session.trail = mpGUI->getTrail();
+		mpSessionWriter->post(session);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -58,12 +129,18 @@ namespace app
 	{
 		s3d::INIReader ini(CONFIG_FILE);
 
+		// R}h̓W[iǂݍ (ΌÂ`INI)
+		auto commands = SessionWriter::readJournal(JOURNAL_FILE);
+		if (!commands)
+		{
+			commands = ini.getOpt<s3d::String>(L"GUI.commands");
+		}
+
 		// }bvt@Cǂݍ
 		const s3d::String filepath{ ini.getOr<s3d::String>(L"Map.filepath", s3d::String{ L"map\\map1.txt" }) };
 		loadMap(filepath);
 
-		// R}hǂݍ
-		const auto commands = ini.getOpt<s3d::String>(L"GUI.commands");
+		// R}hݒ
 		if (commands)
 		{
 			mpGUI->setCommands(commands.value());
@@ -99,6 +176,9 @@ namespace app
 		// GUI
 		mpGUI->initialize();
 
+		// ZbVۑXbhJn
+		mpSessionWriter->start();
+
 		// INIt@Cǂݍ
 		loadINI();
 
@@ -118,8 +198,12 @@ namespace app
 	//-----------------------------------------------------------------------------
 	void App::finalize()
 	{
+		// T~߂
+		mpBackgroundSolver->stop();
+
 		// INIt@Cۑ
 		saveINI();
+		mpSessionWriter->stop();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -203,6 +287,7 @@ namespace app
 			}
 
 			rect = mpSimulator->calcRect(ofs, scale);
+			mpInteractiveController->setViewRect(rect);
 		}
 
 		// R}h`
@@ -216,6 +301,9 @@ namespace app
 	//-----------------------------------------------------------------------------
 	bool App::loadMap(const s3d::String& filepath)
 	{
+		// Õ}bv̒Tʂ͎gȂ
+		mpGUI->cancelSolve(true);
+
 		mpGUI->setFileName(s3d::FileSystem::FileName(filepath));
 
 		if (mpSimulator->loadMap(filepath)) {
@@ -252,6 +340,8 @@ namespace app
 		, mDirtyScale(false)
 		, mDirtyPlay(false)
 		, mDirtySpeed(false)
+		, mSolving(false)
+		, mHasPendingRoute(false)
 	{
 	}
 
@@ -294,13 +384,22 @@ namespace app
 		gui.addln(L"textCommands", s3d::GUIText::Create(L"Commands:0"));
 		gui.addln(L"commands", s3d::GUITextArea::Create(4, 20));
 		gui.add(L"replace", s3d::GUIButton::Create(L"Replace"));
-		gui.addln(L"normalize", s3d::GUIButton::Create(L"Normalize"));
+		gui.add(L"normalize", s3d::GUIButton::Create(L"Normalize"));
+		gui.add(L"evolve", s3d::GUIButton::Create(L"Evolve"));
+		gui.addln(L"minimize", s3d::GUIButton::Create(L"Minimize"));
 
 		gui.add(L"play", s3d::GUIButton::Create(L"Play"));
 		gui.addln(L"stop", s3d::GUIButton::Create(L"Stop", false));
 		gui.add(L"textSpeed", s3d::GUIText::Create(L"Speed"));
 		gui.addln(L"speed", s3d::GUISlider::Create(1, 5, 3));
 		mDirtySpeed = true;
+
+		gui.add(L"hr3", s3d::GUIHorizontalLine::Create(1));
+		gui.horizontalLine(L"hr3").style.color = s3d::Palette::Gray;
+
+		gui.add(L"solve", s3d::GUIButton::Create(L"Solve"));
+		gui.addln(L"follow", s3d::GUICheckBox::Create({ L"Play Improvements" }, { 0u }));
+		gui.addln(L"textSolver", s3d::GUIText::Create(L"Solver:idle"));
 	}
 
 	//-----------------------------------------------------------------------------
@@ -397,6 +496,8 @@ namespace app
 
 			gui.textArea(L"commands").enabled = true;
 			gui.button(L"normalize").enabled = true;
+			gui.button(L"evolve").enabled = true;
+			gui.button(L"minimize").enabled = true;
 			gui.button(L"stop").enabled = false;
 
 			gui.button(L"play").text = L"Play";
@@ -418,6 +519,9 @@ namespace app
 			parent->mpAutoController->setInterval( static_cast<u32>(10 * norm) );
 		}
 
+		// solver
+		updateSolver();
+
 		//-----------------------------------------------------------------------------
 		// {^
 
@@ -447,6 +551,18 @@ namespace app
 				setCommands(cmds);
 			}
 		}
+		else if (gui.button(L"evolve").pushed)
+		{
+			evolve();
+		}
+		else if (gui.button(L"minimize").pushed)
+		{
+			minimize();
+		}
+		else if (gui.button(L"solve").pushed)
+		{
+			solve();
+		}
 		else if (gui.button(L"play").pushed)
 		{
 			play();
@@ -467,6 +583,8 @@ namespace app
 
 		gui.textArea(L"commands").enabled = false;
 		gui.button(L"normalize").enabled = false;
+		gui.button(L"evolve").enabled = false;
+		gui.button(L"minimize").enabled = false;
 		gui.button(L"stop").enabled = true;
 
 		s3d::String& text = gui.button(L"play").text;
@@ -486,6 +604,126 @@ namespace app
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	// R}h̃[g`IASYŉǂ
+	// SolveƓobNOEhő点AP[g̓R}hɓ
+	//-----------------------------------------------------------------------------
+	void AppGUI::evolve()
+	{
+		const Map& initial = parent->mpSimulator->getInitialMap();
+		if (initial.cell.width == 0)
+			return;
+
+		std::unique_ptr<GeneticOptimizer> optimizer(new GeneticOptimizer(backgroundThreadNum()));
+		optimizer->addSeed(getCommands());
+		startSolver(std::move(optimizer), EVOLVE_SECONDS);
+	}
+
+	//-----------------------------------------------------------------------------
+	// R}h̃[gAXRA𗎂ƂɖʂȃR}h菜
+	// obNOEhő点AIR}hɓ
+	//-----------------------------------------------------------------------------
+	void AppGUI::minimize()
+	{
+		const Map& initial = parent->mpSimulator->getInitialMap();
+		if (initial.cell.width == 0)
+			return;
+
+		const s3d::String& cmds = getCommands();
+		if (cmds.isEmpty)
+			return;
+
+		startSolver(std::unique_ptr<Solver>(new MinimizeSolver(cmds, backgroundThreadNum())), MINIMIZE_SECONDS);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ǂݍ񂾃}bvobNOEhŉBTȂ璆f
+	//-----------------------------------------------------------------------------
+	void AppGUI::solve()
+	{
+		if (mSolving) {
+			cancelSolve(false);
+			return;
+		}
+
+		const Map& initial = parent->mpSimulator->getInitialMap();
+		if (initial.cell.width == 0)
+			return;
+
+		startSolver(std::unique_ptr<Solver>(new BeamSearch(SOLVE_WIDTH, backgroundThreadNum())), SOLVE_SECONDS);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ǂݍ񂾃}bv solver ŃobNOEhŉ
+	// O̒TĂΒfAÎ҂ɖ߂BVT͑O̒TIĂn܂
+	// Solve{^Œfł
+	//-----------------------------------------------------------------------------
+	void AppGUI::startSolver(std::unique_ptr<Solver> solver, f64 seconds)
+	{
+		mSolverName = solver->getName();
+		parent->mpBackgroundSolver->start(parent->mpSimulator->getInitialMap(), std::move(solver), seconds);
+
+		mSolving = true;
+		mHasPendingRoute = false;
+		gui.button(L"solve").text = L"Cancel";
+	}
+
+	//-----------------------------------------------------------------------------
+	// T𒆒fBXbh̏I͑҂Ȃ
+	// discard Ȃ͂ĂȂ[ĝĂ
+	//-----------------------------------------------------------------------------
+	void AppGUI::cancelSolve(bool discard)
+	{
+		parent->mpBackgroundSolver->cancel(discard);
+
+		if (mSolving) {
+			gui.text(L"textSolver").text = L"Solver:cancelled";
+		}
+		mSolving = false;
+		if (discard) {
+			mHasPendingRoute = false;
+		}
+		gui.button(L"solve").text = L"Solve";
+	}
+
+	//-----------------------------------------------------------------------------
+	// T̉PR}hɓAi݋\
+	// Đɓ͂[ǵAĐIĂ
+	//-----------------------------------------------------------------------------
+	void AppGUI::updateSolver()
+	{
+		BackgroundSolver& solver = *parent->mpBackgroundSolver;
+
+		// 1t[ɓ͂ōŐV̂̂g
+		BackgroundSolver::Improvement improvement;
+		while (solver.poll(improvement)) {
+			mPendingRoute = std::move(improvement.route);
+			mHasPendingRoute = true;
+		}
+
+		if (mHasPendingRoute && parent->mpAutoController->isStop()) {
+			mHasPendingRoute = false;
+			setCommands(mPendingRoute);
+			if (gui.checkBox(L"follow").checked(0)) {
+				play();
+			}
+		}
+
+		if (!mSolving)
+			return;
+
+		const BackgroundSolver::Progress progress = solver.getProgress();
+		const s3d::String best = progress.bestScore == INT_MIN ? s3d::String(L"-") : s3d::Format(progress.bestScore);
+		gui.text(L"textSolver").text = s3d::Format(s3d::PyFmt, L"Solver:{} {} Best:{} {:.0f}k nodes/s {:.1f}s",
+			mSolverName, progress.running ? L"running" : L"done", best, progress.nodeRate / 1000, progress.elapsed);
+
+		if (!progress.running) {
+			mSolving = false;
+			gui.button(L"solve").text = L"Solve";
+			LOG(TAG, L"TI܂B", mSolverName, L" ", best, L"_ ", progress.nodeNum, L"m[h");
+		}
+	}
+
 	//-----------------------------------------------------------------------------
 	// Getter
 	//-----------------------------------------------------------------------------
@@ -37,6 +37,8 @@ namespace app
 		std::unique_ptr<class InteractiveController> mpInteractiveController;
 		std::unique_ptr<class AutoController> mpAutoController;
 		std::unique_ptr<class AppGUI> mpGUI;
+		std::unique_ptr<class SessionWriter> mpSessionWriter;
+		std::unique_ptr<class BackgroundSolver> mpBackgroundSolver;
 
 		friend class AppGUI;
 	};
@@ -71,6 +73,14 @@ namespace app
 		void setSpeed(f64 speed);
 
 		void play();
+		void evolve();
+		void minimize();
+		void solve();
+		void cancelSolve(bool discard);
+
+	private:
+		void startSolver(std::unique_ptr<class Solver> solver, f64 seconds);
+		void updateSolver();
 
 	private:
 		class App* parent;
@@ -78,6 +88,12 @@ namespace app
 		bool mDirtyScale;
 		bool mDirtyPlay;
 		bool mDirtySpeed;
+
+		// obNOEh̒T
+		bool mSolving;
+		s3d::String mSolverName;
+		s3d::String mPendingRoute;	// ĐIR}hɓ
+		bool mHasPendingRoute;
 	};
 
 }
\ No newline at end of file
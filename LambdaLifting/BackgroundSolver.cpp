@@ -0,0 +1,224 @@
+//
+// Background Solver
+//
+
+#include "stdafx.h"
+#include "BackgroundSolver.h"
+
+#include <chrono>
+
+namespace {
+
+	// GUI͖t[ôŁAꂾΈ邱Ƃ͂܂
+	static const size_t QUEUE_CAPACITY = 64;
+
+	// Tx𑪂蒼Ԋu [s]
+	static const f64 RATE_INTERVAL = 0.5;
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	BackgroundSolver::BackgroundSolver()
+		: mRunning(false)
+		, mQuit(false)
+		, mQueue(QUEUE_CAPACITY)
+		, mHasOverflow(false)
+		, mElapsed(0.0)
+		, mNextSeconds(0.0)
+		, mHasNext(false)
+		, mDiscard(false)
+		, mSampleTime(0.0)
+		, mSampleNodeNum(0)
+		, mNodeRate(0.0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	BackgroundSolver::~BackgroundSolver()
+	{
+		stop();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! TJn
+	//! O̒TIĂȂΒfwėaApoll ŏIɎn߂
+	//! \o[ɂĂ͒fɋCt܂ŎԂ̂ŁAGUĨXbhő҂Ȃ
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::start(const Map& initial, std::unique_ptr<Solver> solver, f64 seconds)
+	{
+		cancel(true);
+
+		mNextMapInfo = *initial.info;
+		mNextMap = initial;
+		mNextMap.info = &mNextMapInfo;
+		mpNextSolver = std::move(solver);
+		mNextSeconds = seconds;
+		mHasNext = true;
+
+		if (!mRunning) {
+			join();
+			launch();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! aT̃Xbh𗧂Ă
+	//! ÕXbh͏IĂ邱
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::launch()
+	{
+		mQueue.clear();
+		mHasOverflow = false;
+
+		mMapInfo = mNextMapInfo;
+		mMap = mNextMap;
+		mMap.info = &mMapInfo;
+		mpSolver = std::move(mpNextSolver);
+		mHasNext = false;
+
+		mpContext.reset(new SolverContext);
+		mpContext->setTimeLimit(mNextSeconds);
+		mpContext->setImproveCallback([this](const s3d::String& route, s32 score) {
+			Improvement improvement;
+			improvement.route = route;
+			improvement.score = score;
+			improvement.elapsed = mpContext->getElapsed();
+
+			// nȂ΍ŐV̂̂ĂBɓnP̕V
+			if (mQueue.push(improvement)) {
+				mHasOverflow = false;
+			} else {
+				mOverflow = improvement;
+				mHasOverflow = true;
+			}
+		});
+
+		mElapsed = 0.0;
+		mDiscard = false;
+		mSampleTime = 0.0;
+		mSampleNodeNum = 0;
+		mNodeRate = 0.0;
+
+		mQuit = false;
+		mRunning = true;
+		mThread = std::thread(&BackgroundSolver::run, this);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! fw
+	//! \o[Ct܂ŏ̂ŁA҂ɖ߂
+	//! discard ȂAL[tœnȂP҂Ɏ̂Ă
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::cancel(bool discard)
+	{
+		mpNextSolver.reset();
+		mHasNext = false;
+
+		if (mpContext) {
+			mpContext->cancel();
+		}
+		if (discard) {
+			mQuit = true;
+			mDiscard = true;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! fďÎ҂
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::stop()
+	{
+		cancel(true);
+		join();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! P1o
+	//! IXbh͂ŕЕtBIĂ̂ő҂Ȃ
+	//! aT΁AŎn߂
+	//-----------------------------------------------------------------------------
+	bool BackgroundSolver::poll(Improvement& improvement)
+	{
+		if (!mRunning) {
+			join();
+			if (mHasNext) {
+				launch();
+			}
+		}
+		if (mDiscard) {
+			mQueue.clear();
+			return false;
+		}
+		return mQueue.pop(improvement);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! i݋
+	//! Tx RATE_INTERVAL Ƃ̍狁߂
+	//-----------------------------------------------------------------------------
+	BackgroundSolver::Progress BackgroundSolver::getProgress()
+	{
+		Progress progress;
+		progress.running = isRunning();
+		if (!mpContext || mHasNext) {
+			progress.bestScore = 0;
+			progress.nodeNum = 0;
+			progress.nodeRate = 0.0;
+			progress.elapsed = 0.0;
+			return progress;
+		}
+
+		progress.bestScore = mpContext->getBestScore();
+		progress.nodeNum = mpContext->getNodeNum();
+		progress.elapsed = progress.running ? mpContext->getElapsed() : mElapsed;
+
+		if (!progress.running) {
+			mNodeRate = 0.0;
+		} else if (progress.elapsed - mSampleTime >= RATE_INTERVAL) {
+			mNodeRate = (progress.nodeNum - mSampleNodeNum) / (progress.elapsed - mSampleTime);
+			mSampleTime = progress.elapsed;
+			mSampleNodeNum = progress.nodeNum;
+		}
+		progress.nodeRate = mNodeRate;
+		return progress;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \o[̃Xbh
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::run()
+	{
+		mpSolver->solve(mMap, *mpContext);
+
+		// L[tœnȂṔAGUIoċ󂭂̂҂ēn
+		while (mHasOverflow && !mQuit) {
+			if (mQueue.push(mOverflow)) {
+				mHasOverflow = false;
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		}
+
+		mElapsed = mpContext->getElapsed();
+		mRunning = false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xbh̏I҂
+	//-----------------------------------------------------------------------------
+	void BackgroundSolver::join()
+	{
+		if (mThread.joinable()) {
+			mThread.join();
+		}
+	}
+
+}
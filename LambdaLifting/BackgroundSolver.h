@@ -0,0 +1,102 @@
+//
+// Background Solver
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "Map.h"
+#include "Solver.h"
+#include "SpscQueue.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class BackgroundSolver
+	//! \o[p̃Xbhő点AGUĨt[~߂Ȃ
+	//! ǂݍ񂾃}bv𕡐ĉAP[g SpscQueue GUĨXbhɓn
+	//! O̒TIO start AÎ҂ɗaApoll ŏIɎn߂
+	//! start, cancel, poll, getProgress GUĨXbhĂ
+	//===================================================================================
+	class BackgroundSolver
+	{
+	public:
+		//! P[g
+		struct Improvement
+		{
+			s3d::String route;
+			s32 score;
+			f64 elapsed;	// [s]
+		};
+
+		struct Progress
+		{
+			bool running;
+			s32 bestScore;
+			u64 nodeNum;
+			f64 nodeRate;	// ߂ [nodes/s]
+			f64 elapsed;	// [s]
+		};
+
+		BackgroundSolver();
+		~BackgroundSolver();
+
+		//! seconds 0ȉȂ cancel ܂őBO̒T𒆒fA҂ɖ߂
+		void start(const Map& initial, std::unique_ptr<Solver> solver, f64 seconds = 0.0);
+
+		//! fwĂɖ߂Bdiscard ȂA܂oĂȂP poll ŕԂȂ
+		//! n߂O̒T͎
+		void cancel(bool discard = false);
+
+		//! făXbh̏I҂
+		void stop();
+
+		//! P1oBfalse
+		bool poll(Improvement& improvement);
+
+		//! O̒T̏I҂ĂԂ܂
+		bool isRunning() const { return mRunning || mHasNext; }
+		Progress getProgress();
+
+	private:
+		BackgroundSolver(const BackgroundSolver&) = delete;
+		BackgroundSolver& operator=(const BackgroundSolver&) = delete;
+
+		void launch();
+		void run();
+		void join();
+
+	private:
+		// ĂԂ̓\o[̃XbhG
+		MapInfo mMapInfo;
+		Map mMap;
+		std::unique_ptr<Solver> mpSolver;
+		std::unique_ptr<SolverContext> mpContext;
+
+		std::thread mThread;
+		std::atomic<bool> mRunning;
+		std::atomic<bool> mQuit;
+
+		// P̒ʒm SolverContext ̃bN̒ŌĂ΂̂ŁA͏1
+		SpscQueue<Improvement> mQueue;
+		Improvement mOverflow;		// L[tœnȂŐV̉P
+		bool mHasOverflow;
+		f64 mElapsed;				// ǏoߎԁBmRunning  false ɂȂOɏ
+
+		// GUĨXbhG
+		MapInfo mNextMapInfo;		// O̒TIn߂T
+		Map mNextMap;
+		std::unique_ptr<Solver> mpNextSolver;
+		f64 mNextSeconds;
+		bool mHasNext;
+		bool mDiscard;
+		f64 mSampleTime;
+		u64 mSampleNodeNum;
+		f64 mNodeRate;
+	};
+
+}
@@ -0,0 +1,301 @@
+//
+// Batch Scorer
+//
+
+#include "stdafx.h"
+#include "BatchScorer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "Map.h"
+#include "Simulator.h"
+#include "Replay.h"
+#include "TaskPool.h"
+#include "MapCorpus.h"
+
+namespace {
+
+	//! @struct LoadedMap
+	struct LoadedMap
+	{
+		s3d::FilePath filepath;
+		app::MapInfo mapInfo;
+		app::Map map;
+		bool valid;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! JSONpɕGXP[v
+	//-----------------------------------------------------------------------------
+	std::string escapeJSON(const s3d::String& s)
+	{
+		std::string result;
+		for (const char c : s.narrow()) {
+			switch (c) {
+			case '"':	result += "\\\""; break;
+			case '\\':	result += "\\\\"; break;
+			case '\n':	result += "\\n"; break;
+			case '\r':	result += "\\r"; break;
+			case '\t':	result += "\\t"; break;
+			default:	result += c; break;
+			}
+		}
+		return result;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	BatchScorer::BatchScorer()
+		: mCacheMax(0)
+		, mpCorpus(nullptr)
+		, mMapNum(0)
+		, mCorpusHitNum(0)
+	{
+		std::memset(&mCacheStats, 0, sizeof(mCacheStats));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	BatchScorer::~BatchScorer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! }jtFXgǂݍ
+	//! 1s "}bv [g" 󔒋؂ŏB#ȍ~̓Rg
+	//-----------------------------------------------------------------------------
+	bool BatchScorer::loadManifest(const s3d::FilePath& manifestPath)
+	{
+		s3d::TextReader r(manifestPath);
+		if (!r.isOpened())
+			return false;
+
+		for (const auto& line : r.readContents().split(L'\n')) {
+			s3d::String s = line;
+			const size_t comment = s.find(L'#');
+			if (comment != s3d::String::npos) {
+				s = s.substr(0, comment);
+			}
+
+			s3d::Array<s3d::String> words;
+			s3d::String word;
+			for (const auto c : s) {
+				if (c == L' ' || c == L'\t' || c == L'\r') {
+					if (!word.isEmpty)
+						words.push_back(word);
+					word.clear();
+				} else {
+					word += c;
+				}
+			}
+			if (!word.isEmpty)
+				words.push_back(word);
+
+			if (words.size() >= 2) {
+				add(words[0], words[1]);
+			}
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! gǉ
+	//-----------------------------------------------------------------------------
+	void BatchScorer::add(const s3d::FilePath& mapPath, const s3d::FilePath& routePath)
+	{
+		BatchEntry e;
+		e.mapPath = mapPath;
+		e.routePath = routePath;
+		e.valid = false;
+		e.score = 0;
+		e.condition = Condition::Playing;
+		e.stepCount = 0;
+		e.lambdaCollected = 0;
+		e.lambda = 0;
+		e.commandCount = 0;
+		e.time = 0;
+		mEntries.push_back(e);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̓_
+	//! }bv͈xǂݍ݁Aeg̓[J[}bv𕡐Ďs
+	//-----------------------------------------------------------------------------
+	void BatchScorer::run(u32 threadNum)
+	{
+		TaskPool pool(threadNum);
+
+		// }bvǂݍ
+		std::unordered_map<std::wstring, u32> index;
+		std::vector<std::unique_ptr<LoadedMap>> maps;
+		std::vector<u32> mapOfEntry(mEntries.size());
+
+		for (size_t i = 0; i < mEntries.size(); ++i) {
+			const auto it = index.find(mEntries[i].mapPath.str());
+			if (it != index.end()) {
+				mapOfEntry[i] = it->second;
+				continue;
+			}
+
+			const u32 m = static_cast<u32>(maps.size());
+			maps.emplace_back(new LoadedMap);
+			maps.back()->filepath = mEntries[i].mapPath;
+			index[mEntries[i].mapPath.str()] = m;
+			mapOfEntry[i] = m;
+		}
+
+		std::atomic<u32> corpusHitNum(0);
+		pool.parallelFor(0, static_cast<u32>(maps.size()), [&](u32 i) {
+			LoadedMap& m = *maps[i];
+			m.map.info = &m.mapInfo;
+
+			if (mpCorpus) {
+				const auto index = mpCorpus->find(m.filepath);
+				if (index && mpCorpus->isCurrent(*index) && mpCorpus->loadMap(*index, m.mapInfo, m.map)) {
+					m.valid = true;
+					corpusHitNum++;
+					return;
+				}
+			}
+			m.valid = Simulator::loadMap(m.filepath, m.mapInfo, m.map);
+		});
+		mMapNum = static_cast<u32>(maps.size());
+		mCorpusHitNum = corpusHitNum;
+
+		std::memset(&mCacheStats, 0, sizeof(mCacheStats));
+
+		if (mCacheMax == 0) {
+			// ̓_
+			pool.parallelFor(0, static_cast<u32>(mEntries.size()), [&](u32 i) {
+				const LoadedMap& m = *maps[mapOfEntry[i]];
+				score(mEntries[i], m.valid ? &m.map : nullptr, nullptr);
+			});
+			return;
+		}
+
+		// }bvƂ̑g}jtFXg̏ɃXbhɕAPʂƂɃLbV
+		// LbV͓ɃXbĥŁA̍v mCacheMax Ɏ܂
+		std::vector<std::vector<u32>> groups;
+		{
+			std::vector<std::vector<u32>> entriesOfMap(maps.size());
+			for (u32 i = 0; i < mEntries.size(); ++i) {
+				entriesOfMap[mapOfEntry[i]].push_back(i);
+			}
+			for (const auto& entries : entriesOfMap) {
+				const size_t chunk = (entries.size() + pool.size() - 1) / pool.size();
+				for (size_t begin = 0; begin < entries.size(); begin += chunk) {
+					const size_t end = std::min(entries.size(), begin + chunk);
+					groups.emplace_back(entries.begin() + begin, entries.begin() + end);
+				}
+			}
+		}
+
+		std::mutex statsMutex;
+		pool.parallelFor(0, static_cast<u32>(groups.size()), [&](u32 g) {
+			const LoadedMap& m = *maps[mapOfEntry[groups[g].front()]];
+			if (!m.valid) {
+				for (const u32 i : groups[g]) {
+					score(mEntries[i], nullptr, nullptr);
+				}
+				return;
+			}
+
+			PrefixCache cache(m.map, mCacheMax / pool.size());
+			for (const u32 i : groups[g]) {
+				score(mEntries[i], &m.map, &cache);
+			}
+
+			const PrefixCache::Stats& stats = cache.getStats();
+			std::lock_guard<std::mutex> lock(statsMutex);
+			mCacheStats.routeNum += stats.routeNum;
+			mCacheStats.commandNum += stats.commandNum;
+			mCacheStats.hitNum += stats.hitNum;
+			mCacheStats.stepNum += stats.stepNum;
+			mCacheStats.evictNum += stats.evictNum;
+			mCacheStats.nodeNum += stats.nodeNum;
+			mCacheStats.snapshotNum += stats.snapshotNum;
+			mCacheStats.bytes += stats.bytes;
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 1g̓_
+	//! initial  nullptr Ȃ}bvǂݍ߂ȂBcache  nullptr Ȃ炻̂܂܎s
+	//-----------------------------------------------------------------------------
+	void BatchScorer::score(BatchEntry& e, const Map* initial, PrefixCache* cache)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		if (initial) {
+			RouteReader reader;
+			if (reader.open(e.routePath)) {
+				Map map;
+				ReplayResult result;
+				if (cache) {
+					result = cache->evaluate(reader, map);
+				} else {
+					map = *initial;
+					result = replayStream(reader, map);
+				}
+
+				e.valid = true;
+				e.score = finalScore(map);
+				e.condition = result.condition;
+				e.stepCount = result.stepCount;
+				e.lambdaCollected = result.lambdaCollected;
+				e.lambda = initial->lambda;
+				e.commandCount = result.commandCount;
+			}
+		}
+
+		const auto end = std::chrono::high_resolution_clock::now();
+		e.time = std::chrono::duration<f64, std::milli>(end - start).count();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! CSVŏo
+	//-----------------------------------------------------------------------------
+	bool BatchScorer::writeCSV(std::FILE* fp) const
+	{
+		std::fprintf(fp, "map,route,valid,score,condition,steps,lambdas,total_lambdas,commands,time_ms\n");
+		for (const auto& e : mEntries) {
+			std::fprintf(fp, "\"%s\",\"%s\",%d,%d,%s,%u,%u,%u,%llu,%.3f\n",
+				e.mapPath.narrow().c_str(), e.routePath.narrow().c_str(), e.valid ? 1 : 0,
+				e.score, s3d::String(stringOfCondition(e.condition)).narrow().c_str(),
+				e.stepCount, e.lambdaCollected, e.lambda, static_cast<unsigned long long>(e.commandCount), e.time);
+		}
+		return std::ferror(fp) == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! JSONŏo
+	//-----------------------------------------------------------------------------
+	bool BatchScorer::writeJSON(std::FILE* fp) const
+	{
+		std::fprintf(fp, "[\n");
+		for (size_t i = 0; i < mEntries.size(); ++i) {
+			const BatchEntry& e = mEntries[i];
+			std::fprintf(fp, "  {\"map\": \"%s\", \"route\": \"%s\", \"valid\": %s, \"score\": %d, \"condition\": \"%s\", "
+				"\"steps\": %u, \"lambdas\": %u, \"total_lambdas\": %u, \"commands\": %llu, \"time_ms\": %.3f}%s\n",
+				escapeJSON(e.mapPath).c_str(), escapeJSON(e.routePath).c_str(), e.valid ? "true" : "false",
+				e.score, s3d::String(stringOfCondition(e.condition)).narrow().c_str(),
+				e.stepCount, e.lambdaCollected, e.lambda, static_cast<unsigned long long>(e.commandCount), e.time,
+				i + 1 < mEntries.size() ? "," : "");
+		}
+		std::fprintf(fp, "]\n");
+		return std::ferror(fp) == 0;
+	}
+
+}
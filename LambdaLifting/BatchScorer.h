@@ -0,0 +1,80 @@
+//
+// Batch Scorer
+//
+
+#pragma once
+
+#include "PrefixCache.h"
+
+namespace app
+{
+
+	// Forward declaration
+	class MapCorpus;
+
+	//===================================================================================
+	//! @struct BatchEntry
+	//===================================================================================
+	struct BatchEntry
+	{
+		s3d::FilePath mapPath;
+		s3d::FilePath routePath;
+
+		// 
+		bool valid;
+		s32 score;
+		Condition condition;
+		u32 stepCount;
+		u32 lambdaCollected;
+		u32 lambda;
+		u64 commandCount;
+		f64 time;	// [ms]
+	};
+
+	//===================================================================================
+	//! @class BatchScorer
+	//! }bvƃ[g̑g܂Ƃ߂č̓_
+	//! LbVgꍇ́A}bṽ[g̋ʂ̐擪xs
+	//===================================================================================
+	class BatchScorer
+	{
+	public:
+		BatchScorer();
+		~BatchScorer();
+
+		bool loadManifest(const s3d::FilePath& manifestPath);
+		void add(const s3d::FilePath& mapPath, const s3d::FilePath& routePath);
+
+		void run(u32 threadNum = 0);
+
+		//! PrefixCache Ɏg̍vB0ȂLbVgȂ
+		void setCacheSize(size_t bytes){ mCacheMax = bytes; }
+		//! Ō run ŎgLbV̓v̍v
+		const PrefixCache::Stats& getCacheStats() const { return mCacheStats; }
+
+		//! }bv MapCorpus ͍̉ς݃f[^ǂݍށBڂĂȂύXꂽ}bv͓ǂݒ
+		void setCorpus(const MapCorpus* corpus){ mpCorpus = corpus; }
+		//! Ō run œǂݍ񂾃}bv̐ƁÂ MapCorpus ǂݍ񂾐
+		u32 getMapNum() const { return mMapNum; }
+		u32 getCorpusHitNum() const { return mCorpusHitNum; }
+
+		bool writeCSV(std::FILE* fp) const;
+		bool writeJSON(std::FILE* fp) const;
+
+		const s3d::Array<BatchEntry>& getEntries() const { return mEntries; }
+
+	private:
+		void score(BatchEntry& e, const Map* initial, PrefixCache* cache);
+
+	private:
+		s3d::Array<BatchEntry> mEntries;
+
+		size_t mCacheMax;
+		PrefixCache::Stats mCacheStats;
+
+		const MapCorpus* mpCorpus;
+		u32 mMapNum;
+		u32 mCorpusHitNum;
+	};
+
+}
@@ -0,0 +1,555 @@
+//
+// Beam Search
+//
+
+#include "stdafx.h"
+#include "BeamSearch.h"
+
+#include <algorithm>
+
+#include "Simulator.h"
+#include "Evaluator.h"
+#include "DistanceFields.h"
+#include "TaskPool.h"
+#include "Replay.h"
+#include "FloodModel.h"
+#include "MapAnalysis.h"
+#include "Checkpoint.h"
+#include "Hash.h"
+#include "ScoreBound.h"
+
+namespace {
+
+	static const app::Command COMMANDS[] = {
+		app::Command::Up,
+		app::Command::Down,
+		app::Command::Left,
+		app::Command::Right,
+		app::Command::Wait,
+		app::Command::Shave,
+	};
+	static const u32 COMMAND_NUM = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+	// o\̑傫B4Xbg̃oPbg 24MB 100Ֆ
+	static const size_t TABLE_BYTES = 96 << 20;
+
+	template<class T>
+	void put(std::vector<u8>& out, const T& value)
+	{
+		const u8* p = reinterpret_cast<const u8*>(&value);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	template<class T>
+	bool get(const u8*& p, const u8* end, T& value)
+	{
+		if (end - p < static_cast<ptrdiff_t>(sizeof(T)))
+			return false;
+		std::memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o\̋L^BR}hASCIIȂ̂1oCg
+	//-----------------------------------------------------------------------------
+	void putEntry(std::vector<u8>& out, const app::TranspositionTable::Entry& entry)
+	{
+		put(out, entry.hash);
+		put(out, entry.parent);
+		put(out, entry.score);
+		put(out, entry.depth);
+		put(out, static_cast<u8>(entry.cmd));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! putEntry ̋t
+	//-----------------------------------------------------------------------------
+	bool getEntry(const u8*& p, const u8* end, app::TranspositionTable::Entry& entry)
+	{
+		u8 c = 0;
+		if (!get(p, end, entry.hash) || !get(p, end, entry.parent) || !get(p, end, entry.score) || !get(p, end, entry.depth) || !get(p, end, c))
+			return false;
+		entry.cmd = static_cast<s3d::wchar>(c);
+		return true;
+	}
+
+	//===================================================================================
+	//! @struct Workspace
+	//! WJ郏[J[eƂɎ؂Ɨ̈
+	//===================================================================================
+	struct Workspace
+	{
+		app::DistanceFields fields;		// Ōɕ]ՖʂɍĂ
+		std::vector<s32> changed;		// fields 킹Ăq̓WJŏZ
+		s3d::Grid<app::Cell> scratch;
+
+		Workspace() : fields(0) {}
+	};
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	BeamSearch::BeamSearch(u32 width, u32 threadNum)
+		: mWidth(std::max(1u, width))
+		, mThreadNum(threadNum)
+		, mPositionLimit(0)
+		, mpEvaluator(std::make_shared<DefaultEvaluator>())
+		, mTableBytes(TABLE_BYTES)
+		, mPrunedNum(0)
+		, mCheckpointInterval(60.0)
+		, mTraceLogged(0)
+		, mJournalReset(false)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	BeamSearch::~BeamSearch()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! q̔Ֆʂ͑O̐[̃obt@ɏ㏑̂ŁAԂł̓mۂȂ
+	//! `FbN|Cg͐[̋؂Ŏ̂ŁAĊJƒfȂꍇƓʂɂȂ
+	//-----------------------------------------------------------------------------
+	void BeamSearch::solve(const Map& initial, SolverContext& ctx)
+	{
+		TaskPool pool(mThreadNum);
+		const Evaluator& evaluator = *mpEvaluator;
+
+		mTraces.clear();
+		mTraces.push_back(Trace{ 0, 0 });
+
+		std::vector<Node> beam(1);
+		beam[0].map = initial;
+		beam[0].trace = 0;
+		beam[0].cmd = 0;
+		beam[0].hash = hashOfMap(initial);
+		beam[0].valid = true;
+
+		std::vector<Node> children;
+		std::vector<u32> order;
+		std::vector<u32> cellCount;
+		std::vector<u32> expandOrder;
+
+		// o\͒Ťv悤Ɏc
+		mpSeen.reset();
+		mpSeen.reset(new TranspositionTable(mTableBytes));
+		TranspositionTable& seen = *mpSeen;
+
+		// ō_𒴂ȂՖʂ̂Ă
+		const ScoreBound bound(initial);
+		mPrunedNum = 0;
+
+		// ]Ɏg̕\́AWJ̃[J[1؂
+		std::vector<std::unique_ptr<Workspace>> workspaces;
+		std::vector<Workspace*> freeWorkspaces;
+		std::mutex workspaceMutex;
+		for (u32 i = 0; i < pool.size(); ++i) {
+			workspaces.emplace_back(new Workspace);
+			freeWorkspaces.push_back(workspaces.back().get());
+		}
+
+		const TranspositionTable::Entry root = { hashOfMap(initial), 0, initial.score, 0, 0 };
+		seen.store(root);
+
+		mTraceLogged = 0;
+		mSeenLog.clear();
+		mSeenLog.push_back(root);
+		mJournalReset = true;
+
+		// ŏAbortꍇ
+		ctx.publish(s3d::String(1, charOfCommand(Command::Abort)), finalScore(initial));
+
+		// `FbN|Cg΂̑
+		u32 depth = 0;
+		std::unique_ptr<CheckpointWriter> writer;
+		if (!mCheckpointPath.isEmpty) {
+			const bool resumed = loadCheckpoint(initial, beam, seen, depth, ctx);
+			writer.reset(new CheckpointWriter(mCheckpointPath));
+			writer->start(resumed);
+		}
+		f64 lastCheckpoint = ctx.getElapsed();
+
+		const u32 depthMax = depthMaxOf(initial);
+
+		for (; depth < depthMax && !beam.empty() && !ctx.isCancelled(); ++depth)
+		{
+			// o͗ōŝŁAȌoIĂȂΎ̐[ɉ
+			if (writer && ctx.getElapsed() - lastCheckpoint >= mCheckpointInterval && !writer->isBusy()) {
+				saveCheckpoint(*writer, initial, beam, seen, depth, ctx);
+				lastCheckpoint = ctx.getElapsed();
+			}
+
+			if (children.size() < beam.size() * COMMAND_NUM) {
+				children.resize(beam.size() * COMMAND_NUM);
+			}
+
+			// ō_͑I̎ɂςȂ̂ŁAWJ̑O1xǂ
+			const s32 bestScore = ctx.getBestScore();
+
+			// Z𑱂ēWJƁA؂肽̕\eɍ킹͈͂
+			expandOrder.resize(beam.size());
+			for (u32 i = 0; i < beam.size(); ++i) {
+				expandOrder[i] = i;
+			}
+			std::sort(expandOrder.begin(), expandOrder.end(), [&](u32 a, u32 b) {
+				return mTraces[beam[a].trace].parent < mTraces[beam[b].trace].parent;
+			});
+
+			// WJ
+			pool.parallelFor(0, static_cast<u32>(beam.size()), [&](u32 j) {
+				const u32 i = expandOrder[j];
+				const Node& parent = beam[i];
+				u64 prunedNum = 0;
+
+				Workspace* ws = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(workspaceMutex);
+					ws = freeWorkspaces.back();
+					freeWorkspaces.pop_back();
+				}
+
+				// \͑OɎ؂肽̔ՖʂɍĂ̂ŁAeƂ̈ႢŜT
+				// qǂ̈Ⴂ́AOɕ]qƍ̎qŏZɎ܂
+				ws->fields.update(parent.map);
+				ws->changed.clear();
+
+				for (u32 k = 0; k < COMMAND_NUM; ++k) {
+					Node& child = children[i * COMMAND_NUM + k];
+					child.valid = false;
+
+					const Command cmd = COMMANDS[k];
+					if (cmd == Command::Shave && parent.map.razor == 0)
+						continue;
+
+					// ɉ񂾊͓xƓAKȂ烉_ɂȂȂ
+					if (pushesIntoDeadCorner(parent.map, cmd))
+						continue;
+
+					child.map = parent.map;
+					const size_t mark = ws->changed.size();
+					if (!Simulator::step(cmd, child.map, ws->scratch, ws->changed) || child.map.condition == Condition::Losing)
+						continue;
+
+					// ǂĂɏoȂȂM邾
+					if (!FloodModel(child.map).canSurface(child.map.robotPos.y, child.map.waterproofCount))
+						continue;
+
+					// ̐ǂĂō_𒴂Ȃ
+					if (bound.upperBound(child.map) <= bestScore) {
+						prunedNum++;
+						continue;
+					}
+
+					// Ֆʂɂȉ̎萔œBς
+					// \͂̌̑IłȂ̂ŁAWJ͓ǂނōς
+					child.hash = hashOfMap(child.map);
+					TranspositionTable::Entry entry;
+					if (seen.probe(child.hash, entry) && entry.depth <= depth + 1)
+						continue;
+
+					child.trace = parent.trace;
+					child.cmd = charOfCommand(cmd);
+					child.parentHash = parent.hash;
+					ws->fields.update(child.map, ws->changed);
+					ws->changed.erase(ws->changed.begin(), ws->changed.begin() + mark);
+					child.eval = evaluator.evaluate(child.map, ws->fields);
+					child.valid = true;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(workspaceMutex);
+					freeWorkspaces.push_back(ws);
+				}
+				ctx.addNodeNum(COMMAND_NUM);
+				mPrunedNum += prunedNum;
+			});
+
+			// dĕ]ɕׂ
+			order.clear();
+			for (u32 i = 0; i < beam.size() * COMMAND_NUM; ++i) {
+				if (children[i].valid) {
+					order.push_back(i);
+				}
+			}
+
+			std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+				const Node& na = children[a];
+				const Node& nb = children[b];
+				return na.hash != nb.hash ? na.hash < nb.hash : na.eval > nb.eval;
+			});
+			order.erase(std::unique(order.begin(), order.end(), [&](u32 a, u32 b) {
+				return children[a].hash == children[b].hash;
+			}), order.end());
+
+			std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+				return children[a].eval > children[b].eval;
+			});
+
+			// ʒũ{bg΂ɂȂȂ悤AʒuƂ̐𐧌
+			const u32 cap = mPositionLimit > 0 ? mPositionLimit : std::max(1u, mWidth / 10);
+			cellCount.assign(initial.cell.width * initial.cell.height, 0);
+			size_t selectNum = 0;
+			for (size_t i = 0; i < order.size() && selectNum < mWidth; ++i) {
+				const Node& child = children[order[i]];
+				u32& count = cellCount[child.map.robotPos.y * initial.cell.width + child.map.robotPos.x];
+				if (count < cap && (!mVisitFilter || mVisitFilter(child.hash, depth + 1))) {
+					count++;
+					order[selectNum++] = order[i];
+				}
+			}
+			order.resize(selectNum);
+
+			// ̐[̃r[
+			beam.resize(selectNum);
+			seen.setGeneration(depth + 1);
+			for (size_t i = 0; i < selectNum; ++i)
+			{
+				Node& child = children[order[i]];
+				const TranspositionTable::Entry entry = { child.hash, child.parentHash, child.map.score, depth + 1, child.cmd };
+				seen.store(entry);
+
+				// oȂȂ獷𗭂߂Ȃ
+				if (writer) {
+					mSeenLog.push_back(entry);
+				}
+
+				const u32 trace = static_cast<u32>(mTraces.size());
+				mTraces.push_back(Trace{ child.trace, child.cmd });
+
+				// IՖʂ̓r[ɎcȂ
+				if (child.map.condition == Condition::Winning) {
+					ctx.publish(routeOf(trace), child.map.score);
+					child.valid = false;
+				} else {
+					const s32 abortScore = finalScore(child.map);
+					if (abortScore > ctx.getBestScore()) {
+						ctx.publish(routeOf(trace, charOfCommand(Command::Abort)), abortScore);
+					}
+				}
+
+				std::swap(beam[i].map, child.map);
+				beam[i].trace = trace;
+				beam[i].hash = child.hash;
+				beam[i].valid = child.valid;
+			}
+
+			beam.erase(std::remove_if(beam.begin(), beam.end(), [](const Node& n) { return !n.valid; }), beam.end());
+		}
+
+		// ~܂ĊJł悤ɏođ҂
+		if (writer) {
+			writer->flush();
+			saveCheckpoint(*writer, initial, beam, seen, depth, ctx);
+			writer->flush();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o\̓vBTO͋
+	//-----------------------------------------------------------------------------
+	TranspositionTable::Stats BeamSearch::getTableStats() const
+	{
+		if (!mpSeen) {
+			const TranspositionTable::Stats empty = {};
+			return empty;
+		}
+		return mpSeen->getStats();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `FbN|Cg̏ƍp̃L[
+	//! ՖʂƒT̐ݒ肪ĊJ
+	//-----------------------------------------------------------------------------
+	u64 BeamSearch::checkpointKey(const Map& initial) const
+	{
+		std::vector<u8> bytes;
+		packMapInfo(*initial.info, bytes);
+		packMap(initial, bytes);
+
+		u64 h = hashBytes(bytes.data(), bytes.size());
+		h = hashValue(mWidth, h);
+		h = hashValue(mPositionLimit, h);
+		h = hashValue(static_cast<u64>(mpSeen->getSlotNum()), h);
+		return h;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `FbN|CgTԂ𕜌
+	//! {̂͐[Aŗǃ[gAr[̔ՖʁBW[i͗Ɗo\̒ǉ̗
+	//-----------------------------------------------------------------------------
+	bool BeamSearch::loadCheckpoint(const Map& initial, std::vector<Node>& beam, TranspositionTable& seen, u32& depth, SolverContext& ctx)
+	{
+		Checkpoint checkpoint;
+		if (!CheckpointWriter::read(mCheckpointPath, checkpointKey(initial), checkpoint))
+			return false;
+
+		// rŉĂ牽ςȂ
+		std::vector<Node> newBeam;
+		std::vector<Trace> newTraces;
+		std::vector<TranspositionTable::Entry> newSeen;
+		u32 newDepth = 0;
+		s32 bestScore = 0;
+		s3d::String bestRoute;
+		{
+			const u8* p = checkpoint.state.data();
+			const u8* end = p + checkpoint.state.size();
+
+			u32 length = 0, beamNum = 0;
+			if (!get(p, end, newDepth) || !get(p, end, bestScore) || !get(p, end, length))
+				return false;
+			for (u32 i = 0; i < length; ++i) {
+				u8 c = 0;
+				if (!get(p, end, c))
+					return false;
+				bestRoute += static_cast<s3d::wchar>(c);
+			}
+
+			if (!get(p, end, beamNum))
+				return false;
+			newBeam.resize(beamNum);
+			for (auto& node : newBeam) {
+				node.map = initial;
+				if (!get(p, end, node.trace) || !unpackMap(p, end, node.map))
+					return false;
+				node.cmd = 0;
+				node.hash = hashOfMap(node.map);
+				node.valid = true;
+			}
+		}
+		{
+			const u8* p = checkpoint.journal.data();
+			const u8* end = p + checkpoint.journal.size();
+			while (p < end) {
+				u32 traceNum = 0, seenNum = 0;
+				if (!get(p, end, traceNum))
+					return false;
+				for (u32 i = 0; i < traceNum; ++i) {
+					Trace trace;
+					u8 c = 0;
+					if (!get(p, end, trace.parent) || !get(p, end, c))
+						return false;
+					trace.cmd = static_cast<s3d::wchar>(c);
+					newTraces.push_back(trace);
+				}
+
+				if (!get(p, end, seenNum))
+					return false;
+				for (u32 i = 0; i < seenNum; ++i) {
+					TranspositionTable::Entry r;
+					if (!getEntry(p, end, r))
+						return false;
+					newSeen.push_back(r);
+				}
+			}
+		}
+		for (const auto& node : newBeam) {
+			if (node.trace >= newTraces.size())
+				return false;
+		}
+
+		// ɓ꒼΁Aǂo܂߂ĒfOƓ\ɂȂ
+		seen.clear();
+		for (const auto& r : newSeen) {
+			seen.setGeneration(r.depth);
+			seen.store(r);
+		}
+
+		beam.swap(newBeam);
+		mTraces.swap(newTraces);
+		depth = newDepth;
+
+		mTraceLogged = static_cast<u32>(mTraces.size());
+		mSeenLog.clear();
+		mJournalReset = false;
+
+		if (!bestRoute.isEmpty) {
+			ctx.publish(bestRoute, bestScore);
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! TԂoXbhɓn
+	//! Ɗo\͑O񂩂̒ǉnBo\̂Ă⏑oɎs͑Ŝn
+	//! R}hׂ͂ASCIIȂ̂1oCgŎ
+	//-----------------------------------------------------------------------------
+	void BeamSearch::saveCheckpoint(CheckpointWriter& writer, const Map& initial, const std::vector<Node>& beam, const TranspositionTable& seen, u32 depth, SolverContext& ctx)
+	{
+		Checkpoint checkpoint;
+		checkpoint.key = checkpointKey(initial);
+		checkpoint.resetJournal = mJournalReset || writer.needsReset();
+
+		std::vector<u8>& state = checkpoint.state;
+		const s3d::String bestRoute = ctx.getBestRoute();
+		put(state, depth);
+		put(state, ctx.getBestScore());
+		put(state, static_cast<u32>(bestRoute.length));
+		for (auto c : bestRoute) {
+			put(state, static_cast<u8>(c));
+		}
+		put(state, static_cast<u32>(beam.size()));
+		for (const auto& node : beam) {
+			put(state, node.trace);
+			packMap(node.map, state);
+		}
+
+		std::vector<u8>& journal = checkpoint.journal;
+		const u32 traceBegin = checkpoint.resetJournal ? 0 : mTraceLogged;
+		put(journal, static_cast<u32>(mTraces.size() - traceBegin));
+		for (size_t i = traceBegin; i < mTraces.size(); ++i) {
+			put(journal, mTraces[i].parent);
+			put(journal, static_cast<u8>(mTraces[i].cmd));
+		}
+		if (checkpoint.resetJournal) {
+			// ͐IĂ疄߂
+			const size_t countPos = journal.size();
+			u32 count = 0;
+			put(journal, count);
+			seen.forEach([&](const TranspositionTable::Entry& entry) {
+				putEntry(journal, entry);
+				count++;
+			});
+			std::memcpy(&journal[countPos], &count, sizeof(count));
+		} else {
+			put(journal, static_cast<u32>(mSeenLog.size()));
+			for (const auto& r : mSeenLog) {
+				putEntry(journal, r);
+			}
+		}
+
+		const u32 traceNum = static_cast<u32>(mTraces.size());
+		if (writer.post(checkpoint)) {
+			mTraceLogged = traceNum;
+			mSeenLog.clear();
+			mJournalReset = false;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 烋[ggݗĂ
+	//-----------------------------------------------------------------------------
+	s3d::String BeamSearch::routeOf(u32 trace, s3d::wchar cmd) const
+	{
+		s3d::String route;
+		for (u32 t = trace; t != 0; t = mTraces[t].parent) {
+			route += mTraces[t].cmd;
+		}
+		std::reverse(route.begin(), route.end());
+		if (cmd) {
+			route += cmd;
+		}
+		return route;
+	}
+
+}
@@ -0,0 +1,104 @@
+//
+// Beam Search
+//
+
+#pragma once
+
+#include <atomic>
+
+#include "Map.h"
+#include "Solver.h"
+#include "TranspositionTable.h"
+
+namespace app
+{
+
+	// Forward declaration
+	class Evaluator;
+	class CheckpointWriter;
+
+	//===================================================================================
+	//! @class BeamSearch
+	//! [Ƃɕ]l̏ width cēWJ
+	//===================================================================================
+	class BeamSearch : public Solver
+	{
+	public:
+		explicit BeamSearch(u32 width = 1000, u32 threadNum = 0);
+		~BeamSearch();
+
+		//! r[ɎcՖʂOɖ₢킹Bfalse Ȃ̂Ă
+		using VisitFilter = std::function<bool(u64 hash, u32 depth)>;
+
+		const s3d::wchar* getName() const override { return L"beam"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		void setEvaluator(const std::shared_ptr<const Evaluator>& evaluator){ mpEvaluator = evaluator; }
+		void setWidth(u32 width){ mWidth = std::max(1u, width); }
+
+		//! {bg̈ʒuƂɎc̏ (0ŕ1/10)
+		void setPositionLimit(u32 limit){ mPositionLimit = limit; }
+
+		//! ̃vZXƋLu\ȂǂŁAɒׂՖʂ
+		void setVisitFilter(const VisitFilter& filter){ mVisitFilter = filter; }
+
+		//! o̔Ֆʂo\̑傫B܂Â[̔ՖʂY
+		void setTableSize(size_t bytes){ mTableBytes = bytes; }
+		TranspositionTable::Stats getTableStats() const;
+
+		//! XRȀ̍ō_ɓ͂̂ĂՖʂ̐
+		u64 getPrunedNum() const { return mPrunedNum; }
+
+		//! interval bƂɒTԂ path ɏoBpath ɂ΂̑T
+		void setCheckpoint(const s3d::FilePath& path, f64 interval){ mCheckpointPath = path; mCheckpointInterval = interval; }
+
+		//! WJ[̏ ([̎萔)BԂ[g͂Abort𑫂܂
+		static u32 depthMaxOf(const Map& map){ return map.cell.width * map.cell.height; }
+
+	private:
+		//! WJՖ
+		struct Node
+		{
+			Map map;
+			u32 trace;		// e̗
+			s3d::wchar cmd;
+			f64 eval;
+			u64 hash;
+			u64 parentHash;
+			bool valid;
+		};
+
+		//! [g̗B[ƂɑI΂ꂽm[hς
+		struct Trace
+		{
+			u32 parent;
+			s3d::wchar cmd;
+		};
+
+		s3d::String routeOf(u32 trace, s3d::wchar cmd = 0) const;
+
+		u64 checkpointKey(const Map& initial) const;
+		bool loadCheckpoint(const Map& initial, std::vector<Node>& beam, TranspositionTable& seen, u32& depth, SolverContext& ctx);
+		void saveCheckpoint(CheckpointWriter& writer, const Map& initial, const std::vector<Node>& beam, const TranspositionTable& seen, u32 depth, SolverContext& ctx);
+
+	private:
+		u32 mWidth;
+		u32 mThreadNum;
+		u32 mPositionLimit;
+		std::shared_ptr<const Evaluator> mpEvaluator;
+		VisitFilter mVisitFilter;
+		size_t mTableBytes;
+
+		std::vector<Trace> mTraces;
+		std::unique_ptr<TranspositionTable> mpSeen;
+		std::atomic<u64> mPrunedNum;
+
+		s3d::FilePath mCheckpointPath;
+		f64 mCheckpointInterval;
+		u32 mTraceLogged;									// W[iɏ̐
+		std::vector<TranspositionTable::Entry> mSeenLog;	// W[iɂ܂ĂȂo\̒ǉ
+		bool mJournalReset;									// ŏT̂ŁA̓W[i
+	};
+
+}
@@ -0,0 +1,320 @@
+//
+// Checkpoint
+//
+
+#include "stdafx.h"
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <io.h>
+
+#include "FileUtil.h"
+#include "Hash.h"
+
+namespace {
+
+	const u32 kCheckpointMagic = 0x54504B43;	// "CKPT"
+	const u32 kCheckpointVersion = 1;
+
+	//! @struct CheckpointHeader
+	struct CheckpointHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 key;
+		u32 generation;		// W[i̐B̂Ă邽тɐi߂
+		u32 reserved;
+		u64 journalSize;	// W[i̗LȒ
+		u64 journalHash;	// W[i̗Lȕ̃nbV
+		u64 stateSize;
+		u64 stateHash;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! W[ĩpX
+	//-----------------------------------------------------------------------------
+	s3d::FilePath journalPathOf(const s3d::FilePath& path, u32 generation)
+	{
+		return s3d::Format(s3d::PyFmt, L"{}.{}.log", path, generation);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŃfBXN܂Ŕf
+	//-----------------------------------------------------------------------------
+	bool writeAll(std::FILE* fp, const void* data, size_t size)
+	{
+		if (size > 0 && std::fwrite(data, 1, size, fp) != size)
+			return false;
+		if (std::fflush(fp) != 0)
+			return false;
+		return ::_commit(::_fileno(fp)) == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@C̐擪 size oCgǂ
+	//-----------------------------------------------------------------------------
+	bool readAll(const s3d::FilePath& path, std::vector<u8>& out, u64 size)
+	{
+		std::FILE* fp = ::_wfopen(path.c_str(), L"rb");
+		if (!fp)
+			return false;
+
+		out.resize(static_cast<size_t>(size));
+		const bool result = size == 0 || std::fread(out.data(), 1, out.size(), fp) == out.size();
+		std::fclose(fp);
+		return result;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	CheckpointWriter::CheckpointWriter(const s3d::FilePath& path)
+		: mPath(path)
+		, mDirty(false)
+		, mWriting(false)
+		, mQuit(false)
+		, mNeedsReset(true)
+		, mGeneration(0)
+		, mJournalSize(0)
+		, mJournalHash(FNV_OFFSET_BASIS)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	CheckpointWriter::~CheckpointWriter()
+	{
+		stop();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oXbhJn
+	//! resume Ȃ̃`FbN|Cg̃W[ȋɏ
+	//-----------------------------------------------------------------------------
+	void CheckpointWriter::start(bool resume)
+	{
+		if (mThread.joinable())
+			return;
+
+		mNeedsReset = !resume;
+
+		std::FILE* fp = ::_wfopen(mPath.c_str(), L"rb");
+		if (fp) {
+			CheckpointHeader h;
+			if (std::fread(&h, sizeof(h), 1, fp) == 1 && h.magic == kCheckpointMagic && h.version == kCheckpointVersion) {
+				mGeneration = h.generation;
+				mJournalSize = h.journalSize;
+				mJournalHash = h.journalHash;
+			}
+			std::fclose(fp);
+		}
+
+		mQuit = false;
+		mThread = std::thread(&CheckpointWriter::run, this);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! coăXbhI
+	//-----------------------------------------------------------------------------
+	void CheckpointWriter::stop()
+	{
+		if (!mThread.joinable())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mCondition.notify_all();
+		mThread.join();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `FbN|Cgo^
+	//! W[i͍Ȃ̂ŁAȌoI܂ł͎󂯕tfalseԂ
+	//! 󂯕tꍇAcheckpoint ̒g͏oɈڂ
+	//-----------------------------------------------------------------------------
+	bool CheckpointWriter::post(Checkpoint& checkpoint)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mDirty || mWriting)
+				return false;
+			if (mNeedsReset && !checkpoint.resetJournal)
+				return false;
+
+			mPending.key = checkpoint.key;
+			mPending.resetJournal = checkpoint.resetJournal;
+			mPending.state.swap(checkpoint.state);
+			mPending.journal.swap(checkpoint.journal);
+			checkpoint.state.clear();
+			checkpoint.journal.clear();
+			mDirty = true;
+		}
+		mCondition.notify_all();
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o^ς݂̃`FbN|Cgo܂ő҂
+	//-----------------------------------------------------------------------------
+	void CheckpointWriter::flush()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (!mThread.joinable()) {
+			if (mDirty) {
+				mDirty = false;
+				mNeedsReset = !write(mPending) || (mNeedsReset && !mPending.resetJournal);
+			}
+			return;
+		}
+		mCondition.notify_all();
+		mFlushed.wait(lock, [this]{ return !mDirty && !mWriting; });
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ͍ł͂ȂŜW[iɏKv邩
+	//! Vn߂ƁAoɎs
+	//-----------------------------------------------------------------------------
+	bool CheckpointWriter::needsReset() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mNeedsReset;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o
+	//-----------------------------------------------------------------------------
+	bool CheckpointWriter::isBusy() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mDirty || mWriting;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oXbh
+	//-----------------------------------------------------------------------------
+	void CheckpointWriter::run()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (;;) {
+			mCondition.wait(lock, [this]{ return mDirty || mQuit; });
+
+			if (!mDirty && mQuit)
+				break;
+
+			mDirty = false;
+			mWriting = true;
+
+			lock.unlock();
+			const bool result = write(mPending);
+			lock.lock();
+
+			// ŝ͎ŁA͑ŜĂ炤
+			if (!result) {
+				mNeedsReset = true;
+			} else if (mPending.resetJournal) {
+				mNeedsReset = false;
+			}
+			mWriting = false;
+			mFlushed.notify_all();
+		}
+		mFlushed.notify_all();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o
+	//! W[iɃfBXN܂ŔfĂ{̂u
+	//-----------------------------------------------------------------------------
+	bool CheckpointWriter::write(const Checkpoint& checkpoint)
+	{
+		// W[îĂ鎞͐Ṽt@CɏA{̂uĂÂ
+		const u32 prevGeneration = mGeneration;
+		if (checkpoint.resetJournal) {
+			mGeneration++;
+			mJournalSize = 0;
+			mJournalHash = FNV_OFFSET_BASIS;
+		}
+
+		const s3d::FilePath journalPath = journalPathOf(mPath, mGeneration);
+		std::FILE* fp = ::_wfopen(journalPath.c_str(), mJournalSize > 0 ? L"r+b" : L"wb");
+		if (!fp)
+			return false;
+
+		// O̗LȒ̌ɏB̏͏㏑
+		bool result = ::_fseeki64(fp, static_cast<s64>(mJournalSize), SEEK_SET) == 0 &&
+			writeAll(fp, checkpoint.journal.data(), checkpoint.journal.size());
+		std::fclose(fp);
+		if (!result)
+			return false;
+		mJournalSize += checkpoint.journal.size();
+		mJournalHash = hashBytes(checkpoint.journal.data(), checkpoint.journal.size(), mJournalHash);
+
+		CheckpointHeader h;
+		h.magic = kCheckpointMagic;
+		h.version = kCheckpointVersion;
+		h.key = checkpoint.key;
+		h.generation = mGeneration;
+		h.reserved = 0;
+		h.journalSize = mJournalSize;
+		h.journalHash = mJournalHash;
+		h.stateSize = checkpoint.state.size();
+		h.stateHash = hashBytes(checkpoint.state.data(), checkpoint.state.size());
+
+		const s3d::FilePath tmpPath = mPath + L".tmp";
+		fp = ::_wfopen(tmpPath.c_str(), L"wb");
+		if (!fp)
+			return false;
+
+		result = std::fwrite(&h, sizeof(h), 1, fp) == 1 &&
+			writeAll(fp, checkpoint.state.data(), checkpoint.state.size());
+		std::fclose(fp);
+
+		if (!result || !replaceFile(tmpPath, mPath))
+			return false;
+
+		if (mGeneration != prevGeneration) {
+			removeFile(journalPathOf(mPath, prevGeneration));
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `FbN|Cgǂݍ
+	//! key ႤAĂfalseԂ
+	//-----------------------------------------------------------------------------
+	bool CheckpointWriter::read(const s3d::FilePath& path, u64 key, Checkpoint& checkpoint)
+	{
+		std::FILE* fp = ::_wfopen(path.c_str(), L"rb");
+		if (!fp)
+			return false;
+
+		CheckpointHeader h;
+		bool result = std::fread(&h, sizeof(h), 1, fp) == 1 &&
+			h.magic == kCheckpointMagic && h.version == kCheckpointVersion && h.key == key;
+		if (result) {
+			checkpoint.state.resize(static_cast<size_t>(h.stateSize));
+			result = h.stateSize == 0 || std::fread(checkpoint.state.data(), 1, checkpoint.state.size(), fp) == checkpoint.state.size();
+		}
+		std::fclose(fp);
+
+		if (!result || hashBytes(checkpoint.state.data(), checkpoint.state.size()) != h.stateHash)
+			return false;
+
+		if (!readAll(journalPathOf(path, h.generation), checkpoint.journal, h.journalSize) ||
+			hashBytes(checkpoint.journal.data(), checkpoint.journal.size()) != h.journalHash)
+			return false;
+
+		checkpoint.key = key;
+		checkpoint.resetJournal = false;
+		return true;
+	}
+
+}
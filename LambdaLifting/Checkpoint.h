@@ -0,0 +1,79 @@
+//
+// Checkpoint
+//
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct Checkpoint
+	//! \o[̒TԁBu镔ƁAO񂩂瑝ɕ
+	//===================================================================================
+	struct Checkpoint
+	{
+		u64 key;					// }bvƃ\o[ݒ̃nbVBႦ΍ĊJȂ
+		std::vector<u8> state;		// u镔 (teBAAŗǃ[gȂ)
+		std::vector<u8> journal;	// O񂩂瑝 (Ao\Ȃ)
+		bool resetJournal;			// W[îĂĂ珑
+
+	public:
+		Checkpoint() : key(0), resetJournal(false) {}
+	};
+
+	//===================================================================================
+	//! @class CheckpointWriter
+	//! `FbN|CgobNOEhŏo
+	//! {͈̂ꎞt@C̃l[ŒuAW[i͒ǋL
+	//! {̂ɂ̓W[i̗LȒ̂ŁAǋL̓rŗĂȌԂɖ߂
+	//===================================================================================
+	class CheckpointWriter
+	{
+	public:
+		explicit CheckpointWriter(const s3d::FilePath& path);
+		~CheckpointWriter();
+
+		void start(bool resume);
+		void stop();
+
+		bool post(Checkpoint& checkpoint);
+		void flush();
+
+		//! ͍ł͂ȂŜW[iɏKv邩
+		bool needsReset() const;
+
+		//! oB̊Ԃ post Ă󂯕tȂ
+		bool isBusy() const;
+
+		static bool read(const s3d::FilePath& path, u64 key, Checkpoint& checkpoint);
+
+	private:
+		void run();
+		bool write(const Checkpoint& checkpoint);
+
+	private:
+		s3d::FilePath mPath;
+
+		std::thread mThread;
+		mutable std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::condition_variable mFlushed;
+
+		Checkpoint mPending;
+		bool mDirty;
+		bool mWriting;
+		bool mQuit;
+		bool mNeedsReset;
+
+		// oXbĥ݂G
+		u32 mGeneration;
+		u64 mJournalSize;
+		u64 mJournalHash;
+	};
+
+}
@@ -0,0 +1,873 @@
+//
+// Command Line
+//
+
+#include "stdafx.h"
+#include "CommandLine.h"
+
+#include <cstdio>
+#include <chrono>
+
+#ifndef LL_HEADLESS
+#include <io.h>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+
+#include "Map.h"
+#include "Simulator.h"
+#include "Replay.h"
+#include "BatchScorer.h"
+#include "MapCorpus.h"
+#include "FileUtil.h"
+#include "TerminalViewer.h"
+
+#ifndef LL_HEADLESS
+#include "JudgeServer.h"
+#include "FrameRenderer.h"
+#include "BeamSearch.h"
+#include "MCTSSolver.h"
+#include "GeneticOptimizer.h"
+#include "ExhaustiveSolver.h"
+#include "TourPlanner.h"
+#include "Portfolio.h"
+#include "DistributedSolver.h"
+#include "RouteMinimizer.h"
+#include "ScoreBound.h"
+#endif
+
+namespace {
+
+	using Args = s3d::Array<s3d::String>;
+
+	//-----------------------------------------------------------------------------
+	//! g\
+	//-----------------------------------------------------------------------------
+	int usage()
+	{
+		app::print(L"usage:\n");
+		app::print(L"  LambdaLifting -replay <map> <route|-> [interval]\n");
+		app::print(L"  LambdaLifting -index <mapdir> <cache>\n");
+		app::print(L"  LambdaLifting -batch <manifest> [output.csv|output.json|-] [threads] [cacheMB] [corpus]\n");
+		app::print(L"  LambdaLifting -view <map> <route|->\n");
+#ifndef LL_HEADLESS
+		app::print(L"  LambdaLifting -judge [socket]\n");
+		app::print(L"  LambdaLifting -render <map> <route|-> <outdir|output.rgba|-> [scale] [trail] [threads]\n");
+		app::print(L"  LambdaLifting -solve <map> [seconds] [width] [threads] [checkpoint] [interval]\n");
+		app::print(L"  LambdaLifting -mcts <map> [seconds] [threads]\n");
+		app::print(L"  LambdaLifting -evolve <map> <seconds> [route|- ...]\n");
+		app::print(L"  LambdaLifting -exhaustive <map> [seconds] [memoryMB] [spilldir] [threads]\n");
+		app::print(L"  LambdaLifting -tour <map> [restarts] [threads]\n");
+		app::print(L"  LambdaLifting -portfolio <map> <seconds> [threads]\n");
+		app::print(L"  LambdaLifting -distributed <map> <seconds> [workers] [width] [tableMB]\n");
+		app::print(L"  LambdaLifting -minimize <map> <route|-> [threads]\n");
+		app::print(L"  LambdaLifting -checkbound <map> [seconds] [samples] [threads]\n");
+#endif
+		return 1;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ʂ\
+	//-----------------------------------------------------------------------------
+	void printResult(const app::ReplayResult& r)
+	{
+		app::print(s3d::Format(s3d::PyFmt, L"score={} condition={} steps={} lambdas={} commands={}\n",
+			r.score, app::stringOfCondition(r.condition), r.stepCount, r.lambdaCollected, r.commandCount));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -replay <map> <route|-> [interval]
+	//! [gǂݍ݂ȂsAŏIXRA\
+	//-----------------------------------------------------------------------------
+	int replay(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(args[0], mapInfo, map)) {
+			print(L"failed to load map: " + args[0] + L"\n");
+			return 1;
+		}
+
+		RouteReader reader;
+		if (!reader.open(args[1])) {
+			print(L"failed to open route: " + args[1] + L"\n");
+			return 1;
+		}
+
+		const u64 interval = args.size() > 2 ? s3d::Parse<u64>(args[2]) : 0;
+		const ReplayResult result = replayStream(reader, map, [](const Map& m, u64 count) {
+			print(s3d::Format(s3d::PyFmt, L"progress commands={} steps={} score={}\n", count, m.stepCount, m.score));
+		}, interval);
+
+		printResult(result);
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -index <mapdir> <cache>
+	//! fBNg̃}bv͂ăLbVBO񂩂ς}bv͂
+	//-----------------------------------------------------------------------------
+	int indexCorpus(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		const auto start = std::chrono::steady_clock::now();
+
+		MapCorpus corpus;
+		if (!corpus.update(args[0], args[1])) {
+			print(L"failed to update corpus: " + args[1] + L"\n");
+			return 1;
+		}
+
+		static const u32 FLAGS[] = { CORPUS_FLOODING, CORPUS_BEARD, CORPUS_TRAMPOLINE, CORPUS_HOROCK };
+		u32 flagNum[4] = {};
+		for (u32 i = 0; i < corpus.size(); ++i) {
+			for (u32 f = 0; f < 4; ++f) {
+				if (corpus.entry(i).flags & FLAGS[f])
+					flagNum[f]++;
+			}
+		}
+
+		for (const auto& path : corpus.getFailedPaths()) {
+			std::fputs(s3d::Format(L"failed to parse: ", path, L"\n").narrow().c_str(), stderr);
+		}
+
+		const f64 elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+		print(s3d::Format(s3d::PyFmt, L"maps={} parsed={} failed={} flooding={} beard={} trampoline={} horock={} time={:.2f}s\n",
+			corpus.size(), corpus.getParsedNum(), corpus.getFailedPaths().size(), flagNum[0], flagNum[1], flagNum[2], flagNum[3], elapsed));
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -batch <manifest> [output] [threads] [cacheMB] [corpus]
+	//! }jtFXgɕ񂾃}bvƃ[g̑gSRAō̓_
+	//! }bṽ[g PrefixCache ŋʂ̐擪g񂷁BcacheMB 0ȂgȂ
+	//! corpus  -index ōLbVw肷ƁA}bv͂ɓǂݍ
+	//-----------------------------------------------------------------------------
+	int batch(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		BatchScorer scorer;
+		if (!scorer.loadManifest(args[0])) {
+			print(L"failed to load manifest: " + args[0] + L"\n");
+			return 1;
+		}
+
+		const s3d::FilePath output = args.size() > 1 ? args[1] : s3d::FilePath(L"-");
+		const u32 threadNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 0;
+		const size_t cacheMB = args.size() > 3 ? s3d::Parse<u32>(args[3]) : 256;
+
+		MapCorpus corpus;
+		if (args.size() > 4) {
+			if (!corpus.open(args[4])) {
+				print(L"failed to open corpus: " + args[4] + L"\n");
+				return 1;
+			}
+			scorer.setCorpus(&corpus);
+		}
+
+		scorer.setCacheSize(cacheMB << 20);
+		scorer.run(threadNum);
+
+		// ʂWo͂ɏƂ̂ŁAv͕WG[o͂ɏ
+		if (args.size() > 4) {
+			const std::string str = s3d::Format(s3d::PyFmt, L"corpus maps={} hit={}\n", scorer.getMapNum(), scorer.getCorpusHitNum()).narrow();
+			std::fputs(str.c_str(), stderr);
+		}
+		if (cacheMB > 0) {
+			const PrefixCache::Stats& stats = scorer.getCacheStats();
+			const std::string str = s3d::Format(s3d::PyFmt, L"cache routes={} commands={} hit={:.3f} steps={} evicted={} nodes={} snapshots={} memory={:.1f}MB\n",
+				stats.routeNum, stats.commandNum, stats.hitRate(), stats.stepNum, stats.evictNum,
+				stats.nodeNum, stats.snapshotNum, stats.bytes / 1048576.0).narrow();
+			std::fputs(str.c_str(), stderr);
+		}
+
+		std::FILE* fp = output == L"-" ? stdout : openFile(output, L"w");
+		if (!fp) {
+			print(L"failed to open output: " + output + L"\n");
+			return 1;
+		}
+
+		const bool json = s3d::FileSystem::Extension(output).lowercased() == L"json";
+		const bool result = json ? scorer.writeJSON(fp) : scorer.writeCSV(fp);
+
+		if (fp != stdout) {
+			std::fclose(fp);
+		}
+		return result ? 0 : 1;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -view <map> <route|->
+	//! [gR\[ōĐ
+	//-----------------------------------------------------------------------------
+	int view(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		RouteReader reader;
+		if (!reader.open(args[1])) {
+			print(L"failed to open route: " + args[1] + L"\n");
+			return 1;
+		}
+
+		s3d::String cmds;
+		Command cmd;
+		while (reader.read(cmd)) {
+			cmds += charOfCommand(cmd);
+		}
+
+		TerminalViewer viewer;
+		if (!viewer.load(args[0], cmds)) {
+			print(L"failed to load map: " + args[0] + L"\n");
+			return 1;
+		}
+
+		viewer.run();
+		return 0;
+	}
+
+#ifndef LL_HEADLESS
+	//-----------------------------------------------------------------------------
+	//! -judge [socket]
+	//! \PbgȗƕWo͂1ZbV
+	//-----------------------------------------------------------------------------
+	int judge(const Args& args)
+	{
+		using namespace app;
+
+		JudgeServer server;
+		if (args.empty()) {
+			server.serve(stdin, stdout);
+			return 0;
+		}
+
+		if (!server.listen(args[0])) {
+			print(L"failed to listen: " + args[0] + L"\n");
+			return 1;
+		}
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -render <map> <route|-> <outdir|output.rgba|-> [scale] [trail] [threads]
+	//! vCAPNGRGBAXg[ɏo
+	//-----------------------------------------------------------------------------
+	int render(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 3)
+			return usage();
+
+		RouteReader reader;
+		if (!reader.open(args[1])) {
+			print(L"failed to open route: " + args[1] + L"\n");
+			return 1;
+		}
+
+		s3d::String cmds;
+		Command cmd;
+		while (reader.read(cmd)) {
+			cmds += charOfCommand(cmd);
+		}
+
+		RenderSettings settings;
+		if (args.size() > 3)
+			settings.scale = s3d::Parse<u32>(args[3]);
+		if (args.size() > 4)
+			settings.trailLength = s3d::Parse<s32>(args[4]);
+		if (args.size() > 5)
+			settings.threadNum = s3d::Parse<u32>(args[5]);
+
+		RenderResult result;
+		if (!renderReplay(args[0], cmds, args[2], settings, result)) {
+			print(L"failed to render: " + args[0] + L"\n");
+			return 1;
+		}
+
+		// Wo͂Ƀt[𗬂Ăꍇ͉\Ȃ
+		if (args[2] != L"-") {
+			print(s3d::Format(s3d::PyFmt, L"size={}x{} frames={} dirty={} time={:.1f}ms\n",
+				result.width, result.height, result.frameNum, result.dirtyNum, result.time));
+		}
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \o[sAŗǂ̃[g\
+	//-----------------------------------------------------------------------------
+	int runSolver(const s3d::FilePath& mapPath, f64 seconds, app::Solver& solver)
+	{
+		using namespace app;
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(mapPath, mapInfo, map)) {
+			print(L"failed to load map: " + mapPath + L"\n");
+			return 1;
+		}
+
+		SolverContext ctx;
+		ctx.setTimeLimit(seconds);
+		ctx.setImproveCallback([&ctx](const s3d::String& route, s32 score) {
+			print(s3d::Format(s3d::PyFmt, L"improve score={} length={} time={:.2f}s\n", score, route.length, ctx.getElapsed()));
+		});
+
+		solver.solve(map, ctx);
+
+		print(s3d::Format(s3d::PyFmt, L"score={} nodes={} time={:.2f}s\n", ctx.getBestScore(), ctx.getNodeNum(), ctx.getElapsed()));
+		print(ctx.getBestRoute() + L"\n");
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -solve <map> [seconds] [width] [threads] [checkpoint] [interval]
+	//! r[T[`Ń[gT
+	//! checkpoint w肷 interval bƂɒTԂoA͂̑T
+	//-----------------------------------------------------------------------------
+	int solve(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		const f64 seconds = args.size() > 1 ? s3d::Parse<f64>(args[1]) : 150.0;
+		const u32 width = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 1000;
+		const u32 threadNum = args.size() > 3 ? s3d::Parse<u32>(args[3]) : 0;
+
+		BeamSearch solver(width, threadNum);
+		if (args.size() > 4) {
+			const f64 interval = args.size() > 5 ? s3d::Parse<f64>(args[5]) : 60.0;
+			solver.setCheckpoint(args[4], interval);
+		}
+		const int result = runSolver(args[0], seconds, solver);
+
+		const TranspositionTable::Stats stats = solver.getTableStats();
+		print(s3d::Format(s3d::PyFmt, L"table hit={:.1f}% load={:.1f}% collisions={} torn={} pruned={}\n",
+			stats.hitRate() * 100.0, stats.load() * 100.0, stats.collisionNum, stats.tornNum, solver.getPrunedNum()));
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -mcts <map> [seconds] [threads]
+	//! eJؒTŃ[gTBb[AEgƖ؂̑傫\
+	//-----------------------------------------------------------------------------
+	int mcts(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		const f64 seconds = args.size() > 1 ? s3d::Parse<f64>(args[1]) : 150.0;
+		const u32 threadNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 0;
+
+		MCTSSolver solver(threadNum);
+		solver.setReportCallback([](u64 rolloutNum, u32 treeSize, f64 rolloutRate) {
+			print(s3d::Format(s3d::PyFmt, L"rollouts={} tree={} rate={:.0f}/s\n", rolloutNum, treeSize, rolloutRate));
+		});
+		return runSolver(args[0], seconds, solver);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -evolve <map> <seconds> [route|- ...]
+	//! ^[g`IASYŉǂ
+	//-----------------------------------------------------------------------------
+	int evolve(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		const f64 seconds = s3d::Parse<f64>(args[1]);
+
+		GeneticOptimizer solver;
+		for (size_t i = 2; i < args.size(); ++i) {
+			RouteReader reader;
+			if (!reader.open(args[i])) {
+				print(L"failed to open route: " + args[i] + L"\n");
+				return 1;
+			}
+
+			s3d::String route;
+			Command cmd;
+			while (reader.read(cmd)) {
+				route += charOfCommand(cmd);
+			}
+			solver.addSeed(route);
+		}
+
+		solver.setReportCallback([](u32 generation, u64 simulatedSteps, u64 reusedSteps, size_t cacheBytes) {
+			print(s3d::Format(s3d::PyFmt, L"generation={} simulated={} reused={} cache={}KB\n", generation, simulatedSteps, reusedSteps, cacheBytes / 1024));
+		});
+		return runSolver(args[0], seconds, solver);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -exhaustive <map> [seconds] [memoryMB] [spilldir] [threads]
+	//! SԂ𕝗DŒׂčœKȃXRA߂B}bvp
+	//-----------------------------------------------------------------------------
+	int exhaustive(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		const f64 seconds = args.size() > 1 ? s3d::Parse<f64>(args[1]) : 0.0;
+		const u64 memoryMax = (args.size() > 2 ? s3d::Parse<u64>(args[2]) : 1024) << 20;
+		const u32 threadNum = args.size() > 4 ? s3d::Parse<u32>(args[4]) : 0;
+
+		ExhaustiveSolver solver(threadNum, memoryMax);
+		if (args.size() > 3) {
+			solver.setSpillDirectory(args[3]);
+		}
+		solver.setReportCallback([](u32 depth, u64 frontierNum, u64 stateNum, u64 spilledBytes) {
+			print(s3d::Format(s3d::PyFmt, L"depth={} frontier={} states={} spilled={}MB\n", depth, frontierNum, stateNum, spilledBytes >> 20));
+		});
+
+		const int result = runSolver(args[0], seconds, solver);
+		if (result == 0) {
+			print(solver.isOptimal() ? L"optimal\n" : L"not proven optimal\n");
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -tour <map> [restarts] [threads]
+	//! _鏇ԂœKAۂɓ[g\
+	//-----------------------------------------------------------------------------
+	int tour(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		const u32 restartNum = args.size() > 1 ? s3d::Parse<u32>(args[1]) : 64;
+		const u32 threadNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 0;
+
+		TourPlanner solver(threadNum, restartNum);
+		return runSolver(args[0], 0.0, solver);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -portfolio <map> <seconds> [threads]
+	//! ̃\o[𓯎ɑ点AԂ Ctrl+C ōŗǂ̃[gWo͂ɏo
+	//! threads ̓\o[Ƃ̃XbhBo߂͕WG[o͂ɏo
+	//-----------------------------------------------------------------------------
+	int portfolio(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		const f64 seconds = s3d::Parse<f64>(args[1]);
+		const u32 threadNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 1;
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(args[0], mapInfo, map)) {
+			print(L"failed to load map: " + args[0] + L"\n");
+			return 1;
+		}
+
+		Portfolio runner;
+		runner.add(std::unique_ptr<Solver>(new BeamSearch(1000, threadNum)));
+		runner.add(std::unique_ptr<Solver>(new MCTSSolver(threadNum)));
+		runner.add(std::unique_ptr<Solver>(new GeneticOptimizer(threadNum)));
+		runner.add(std::unique_ptr<Solver>(new TourPlanner(threadNum, 1 << 16)));
+
+		runner.setImproveCallback([](const s3d::wchar* name, s32 score, f64 elapsed) {
+			const std::string str = s3d::Format(s3d::PyFmt, L"improve solver={} score={} time={:.2f}s\n", name, score, elapsed).narrow();
+			std::fputs(str.c_str(), stderr);
+		});
+
+		runner.run(map, seconds, [](const s3d::String& route, s32 score, bool interrupted) {
+			print(route + L"\n");
+			std::fflush(stdout);
+
+			const std::string str = s3d::Format(s3d::PyFmt, L"score={}{}\n", score, interrupted ? L" (interrupted)" : L"").narrow();
+			std::fputs(str.c_str(), stderr);
+		});
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -distributed <map> <seconds> [workers] [width] [tableMB]
+	//! [J[vZXNAL̒u\găr[T[`𕪒S
+	//-----------------------------------------------------------------------------
+	int distributed(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		const f64 seconds = s3d::Parse<f64>(args[1]);
+		const u32 workerNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 0;
+		const u32 width = args.size() > 3 ? s3d::Parse<u32>(args[3]) : 1000;
+		const u64 tableBytes = (args.size() > 4 ? s3d::Parse<u64>(args[4]) : 256) << 20;
+
+		DistributedSolver solver(workerNum, width, tableBytes);
+		return runSolver(args[0], seconds, solver);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -worker <name>
+	//! -distributed N郏[J[
+	//-----------------------------------------------------------------------------
+	int worker(const Args& args)
+	{
+		if (args.size() < 1)
+			return usage();
+
+		return app::DistributedSolver::runWorker(args[0]);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -minimize <map> <route|-> [threads]
+	//! XRA𗎂ƂɃ[gZBpXƂɒƃXRA\
+	//-----------------------------------------------------------------------------
+	int minimize(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 2)
+			return usage();
+
+		const u32 threadNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 0;
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(args[0], mapInfo, map)) {
+			print(L"failed to load map: " + args[0] + L"\n");
+			return 1;
+		}
+
+		RouteReader reader;
+		if (!reader.open(args[1])) {
+			print(L"failed to open route: " + args[1] + L"\n");
+			return 1;
+		}
+
+		s3d::String route;
+		Command cmd;
+		while (reader.read(cmd)) {
+			route += charOfCommand(cmd);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		auto elapsed = [&start]() { return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count(); };
+
+		RouteMinimizer minimizer(threadNum);
+		minimizer.setReportCallback([&elapsed](u32 pass, u32 length, s32 score) {
+			print(s3d::Format(s3d::PyFmt, L"pass={} length={} score={} time={:.2f}s\n", pass, length, score, elapsed()));
+		});
+
+		const s3d::String result = minimizer.minimize(map, route);
+
+		Map replayed = map;
+		replayRoute(result, replayed);
+		print(s3d::Format(s3d::PyFmt, L"score={} length={} candidates={} time={:.2f}s\n", finalScore(replayed), result.length, minimizer.getCandidateNum(), elapsed()));
+		print(result + L"\n");
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! -checkbound <map> [seconds] [samples] [threads]
+	//! }bvŁAXRȀST̍œKȂm߂
+	//! œK[g̓r̔ՖʂƁA_ɓՖʂ𒲂ׂBΏIR[h1
+	//-----------------------------------------------------------------------------
+	int checkBound(const Args& args)
+	{
+		using namespace app;
+
+		if (args.size() < 1)
+			return usage();
+
+		const f64 seconds = args.size() > 1 ? s3d::Parse<f64>(args[1]) : 10.0;
+		const u32 sampleNum = args.size() > 2 ? s3d::Parse<u32>(args[2]) : 32;
+		const u32 threadNum = args.size() > 3 ? s3d::Parse<u32>(args[3]) : 0;
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(args[0], mapInfo, map)) {
+			print(L"failed to load map: " + args[0] + L"\n");
+			return 1;
+		}
+
+		const ScoreBound bound(map);
+
+		// Ֆʂ̍œKBԓɒאsȂfalse
+		auto solveExactly = [&](const Map& state, s32& optimum, s3d::String& route) {
+			ExhaustiveSolver solver(threadNum);
+			SolverContext ctx;
+			ctx.setTimeLimit(seconds);
+			solver.solve(state, ctx);
+			optimum = ctx.getBestScore();
+			route = ctx.getBestRoute();
+			return solver.isOptimal();
+		};
+
+		std::vector<Map> states;
+		u32 violationNum = 0;
+		u32 unsolvedNum = 0;
+		auto check = [&](const Map& state, s32 optimum) {
+			const s32 upper = bound.upperBound(state);
+			if (upper < optimum) {
+				violationNum++;
+				print(s3d::Format(s3d::PyFmt, L"violation steps={} bound={} optimum={}\n", state.stepCount, upper, optimum));
+			}
+			states.push_back(state);
+		};
+
+		s32 optimum;
+		s3d::String route;
+		if (!solveExactly(map, optimum, route)) {
+			print(L"not proven optimal: " + args[0] + L"\n");
+			return 1;
+		}
+
+		// œK[g̓r̔ՖʂAXRA͎
+		const s3d::String optimalRoute = route;
+		Map state = map;
+		check(state, optimum);
+		for (size_t i = 0; i < optimalRoute.length && state.condition == Condition::Playing; ++i) {
+			const Command cmd = commandOfChar(optimalRoute[i]);
+			if (cmd == Command::Abort)
+				break;
+			Simulator::step(cmd, state);
+			check(state, optimum);
+		}
+
+		// _ɓՖʁAœK[g̓rő҂ՖʁA蓹ՖʂST
+		// ҂Ɗ蓹ł͐ʂɐiނ̂ŁApȂƓ͂ȂՖʂׂ
+		static const Command MOVES[] = { Command::Up, Command::Down, Command::Left, Command::Right, Command::Wait };
+		static const Command OPPOSITE[] = { Command::Down, Command::Up, Command::Right, Command::Left };
+		u64 random = 0x9E3779B97F4A7C15ull;
+		auto nextRandom = [&random]() {
+			random ^= random << 13;
+			random ^= random >> 7;
+			random ^= random << 17;
+			return random;
+		};
+
+		// IȂԂi߂
+		auto advance = [&](Command cmd) {
+			Map next = state;
+			Simulator::step(cmd, next);
+			if (next.condition != Condition::Playing)
+				return false;
+			state = next;
+			return true;
+		};
+
+		const u32 walkMax = static_cast<u32>(map.cell.width + map.cell.height) * 2;
+		for (u32 i = 0; i < sampleNum; ++i)
+		{
+			state = map;
+			const u32 walk = static_cast<u32>(nextRandom() % walkMax) + 1;
+			if (i % 3 == 0) {
+				for (u32 k = 0; k < walk && advance(MOVES[nextRandom() % 5]); ++k)
+					;
+			} else {
+				// œK[g̓r܂Ői߂ĂA҂AɍsĖ߂
+				const size_t prefix = static_cast<size_t>(nextRandom() % (optimalRoute.length + 1));
+				for (size_t k = 0; k < prefix; ++k) {
+					const Command cmd = commandOfChar(optimalRoute[k]);
+					if (cmd == Command::Abort || !advance(cmd))
+						break;
+				}
+				if (i % 3 == 1) {
+					for (u32 k = 0; k < walk && advance(Command::Wait); ++k)
+						;
+				} else {
+					const u32 dir = static_cast<u32>(nextRandom() % 4);
+					u32 k = 0;
+					for (; k < walk / 2 + 1 && advance(MOVES[dir]); ++k)
+						;
+					while (k-- > 0 && advance(OPPOSITE[dir]))
+						;
+				}
+			}
+
+			s32 stateOptimum;
+			if (!solveExactly(state, stateOptimum, route)) {
+				unsolvedNum++;
+				continue;
+			}
+			check(state, stateOptimum);
+		}
+
+		// 1XebṽV~[VƏ̌vZׂ̑
+		const u32 repeat = std::max<u32>(1, 100000 / static_cast<u32>(states.size()));
+		// vZȂ悤Ɍʂ̂Ăɑ
+		volatile s32 sink = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (u32 r = 0; r < repeat; ++r) {
+			for (const Map& m : states) {
+				sink += bound.upperBound(m);
+			}
+		}
+		const f64 boundTime = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (u32 r = 0; r < repeat; ++r) {
+			for (const Map& m : states) {
+				Map next = m;
+				Simulator::step(MOVES[r % 5], next);
+				sink += next.score;
+			}
+		}
+		const f64 stepTime = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		const f64 callNum = static_cast<f64>(repeat) * states.size();
+		print(s3d::Format(s3d::PyFmt, L"optimum={} checked={} violations={} unsolved={} bound={:.0f}ns step={:.0f}ns\n",
+			optimum, states.size(), violationNum, unsolvedNum, boundTime / callNum, stepTime / callNum));
+		return violationNum > 0 ? 1 : 0;
+	}
+
+#endif // LL_HEADLESS
+} // unnamed namespace
+
+
+namespace app
+{
+
+#ifndef LL_HEADLESS
+	//-----------------------------------------------------------------------------
+	//! R}hC[hs
+	//! "-" Ŏn܂IvVw肳ĂȂfalseԂAGUIN
+	//-----------------------------------------------------------------------------
+	bool runCommandLine(const s3d::Array<s3d::String>& argv)
+	{
+		if (argv.size() < 2 || !argv[1].startsWith(L"-"))
+			return false;
+
+		attachConsole();
+
+		const int result = runCommand(argv);
+
+		// IR[hԂ߂ɂŃvZXI
+		std::fflush(stdout);
+		std::fflush(stderr);
+		::ExitProcess(static_cast<UINT>(result));
+		return true;
+	}
+#endif
+
+	//-----------------------------------------------------------------------------
+	//! argv[1] ̃[hsďIR[hԂ
+	//! wbhXłł̓EBhE Windows ̋@\gȂ[h󂯕t
+	//-----------------------------------------------------------------------------
+	int runCommand(const s3d::Array<s3d::String>& argv)
+	{
+		if (argv.size() < 2)
+			return usage();
+
+		const s3d::String& mode = argv[1];
+		const Args args(argv.begin() + 2, argv.end());
+
+		if (mode == L"-replay") {
+			return replay(args);
+		} else if (mode == L"-index") {
+			return indexCorpus(args);
+		} else if (mode == L"-batch") {
+			return batch(args);
+		} else if (mode == L"-view") {
+			return view(args);
+		}
+#ifndef LL_HEADLESS
+		else if (mode == L"-judge") {
+			return judge(args);
+		} else if (mode == L"-render") {
+			return render(args);
+		} else if (mode == L"-solve") {
+			return solve(args);
+		} else if (mode == L"-mcts") {
+			return mcts(args);
+		} else if (mode == L"-evolve") {
+			return evolve(args);
+		} else if (mode == L"-exhaustive") {
+			return exhaustive(args);
+		} else if (mode == L"-tour") {
+			return tour(args);
+		} else if (mode == L"-portfolio") {
+			return portfolio(args);
+		} else if (mode == L"-distributed") {
+			return distributed(args);
+		} else if (mode == L"-minimize") {
+			return minimize(args);
+		} else if (mode == L"-checkbound") {
+			return checkBound(args);
+		} else if (mode == L"-worker") {
+			return worker(args);
+		}
+#endif
+		return usage();
+	}
+
+#ifndef LL_HEADLESS
+	//-----------------------------------------------------------------------------
+	//! evZX̃R\[ɐڑ
+	//! Wo͂_CNgĂꍇ͂̂܂܎g
+	//-----------------------------------------------------------------------------
+	void attachConsole()
+	{
+		const bool redirectedOut = ::_fileno(stdout) >= 0 && ::_get_osfhandle(::_fileno(stdout)) >= 0;
+		const bool redirectedIn = ::_fileno(stdin) >= 0 && ::_get_osfhandle(::_fileno(stdin)) >= 0;
+
+		if (redirectedOut && redirectedIn)
+			return;
+
+		if (!::AttachConsole(ATTACH_PARENT_PROCESS))
+			return;
+
+		if (!redirectedOut) {
+			std::freopen("CONOUT$", "w", stdout);
+			std::freopen("CONOUT$", "w", stderr);
+		}
+		if (!redirectedIn) {
+			std::freopen("CONIN$", "r", stdin);
+		}
+	}
+#endif
+
+	//-----------------------------------------------------------------------------
+	//! Wo͂ɏo
+	//-----------------------------------------------------------------------------
+	void print(const s3d::String& s)
+	{
+		const std::string str = s.narrow();
+		std::fwrite(str.data(), 1, str.size(), stdout);
+	}
+
+}
@@ -0,0 +1,20 @@
+//
+// Command Line
+//
+
+#pragma once
+
+namespace app
+{
+
+#ifndef LL_HEADLESS
+	bool runCommandLine(const s3d::Array<s3d::String>& argv);
+
+	void attachConsole();
+#endif
+
+	int runCommand(const s3d::Array<s3d::String>& argv);
+
+	void print(const s3d::String& s);
+
+}
@@ -7,6 +7,7 @@
 
 #include "Map.h"
 #include "Simulator.h"
+#include "MacroAction.h"
 
 namespace app
 {
@@ -37,6 +38,9 @@ namespace app
 	//-----------------------------------------------------------------------------
 	void InteractiveController::update(class Simulator& simulator)
 	{
+		if (moveToClicked(simulator))
+			return;
+
 		Command cmd = readCommand();
 		if (cmd != Command::None && simulator.isPlaying()) {
 			if (!simulator.step(cmd)) {
@@ -45,6 +49,31 @@ namespace app
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//! NbN}X܂Ń{bg𓮂
+	//! ȂꍇAr܂œ炻̕ς
+	//-----------------------------------------------------------------------------
+	bool InteractiveController::moveToClicked(class Simulator& simulator)
+	{
+		if (!s3d::Input::MouseL.clicked || !simulator.isPlaying())
+			return false;
+
+		const s3d::Vec2 mouse{ s3d::Mouse::Pos() };
+		if (mViewRect.w <= 0 || !mViewRect.intersects(mouse))
+			return false;
+
+		const Map& map = simulator.getMap();
+		const s3d::Vec2 cellSize{ mViewRect.w / map.cell.width, mViewRect.h / map.cell.height };
+		const int2 target{
+			std::min(static_cast<s32>((mouse.x - mViewRect.x) / cellSize.x), map.cell.width - 1),
+			std::min(static_cast<s32>((mouse.y - mViewRect.y) / cellSize.y), map.cell.height - 1) };
+
+		MoveResult result;
+		moveTo(map, target, result);
+		simulator.stepMacro(result.commands, result.map);
+		return true;
+	}
+
 	//-----------------------------------------------------------------------------
 	//! R}hǂݍ
 	//-----------------------------------------------------------------------------
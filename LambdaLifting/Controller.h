@@ -35,7 +35,15 @@ namespace app
 
 		Command readCommand();
 
+		//! }bv`悵`BNbN}Xւ̈ړɎg
+		void setViewRect(const s3d::RectF& rect){ mViewRect = rect; }
+
+	private:
+		bool moveToClicked(class Simulator& simulator);
+
 	private:
+		s3d::RectF mViewRect;
+
 		u32 mInitialDelay;
 		u32 mInterval;
 
@@ -0,0 +1,504 @@
+//
+// Distance Fields
+//
+
+#include "stdafx.h"
+#include "DistanceFields.h"
+
+#include "MapAnalysis.h"
+
+namespace {
+
+	using app::Cell;
+
+	static const s32 DX[] = { 0, 0, -1, 1 };
+	static const s32 DY[] = { -1, 1, 0, 0 };
+	static const app::Command MOVES[] = { app::Command::Up, app::Command::Down, app::Command::Left, app::Command::Right };
+
+	// ςZ葽΁A蒼
+	static const u32 REBUILD_RATIO = 8;
+
+	//-----------------------------------------------------------------------------
+	//! {bgĂāA瓮Z
+	//! ^[Qbgɂ͕ēȂAWvŒ
+	//-----------------------------------------------------------------------------
+	inline bool isPassable(Cell c)
+	{
+		switch (app::cellType(c)) {
+		case Cell::Empty:
+		case Cell::Robot:
+		case Cell::Earth:
+		case Cell::Razor:
+		case Cell::Lambda:
+		case Cell::Target:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ׂēZBtg͍sƂĂ
+	//-----------------------------------------------------------------------------
+	inline bool isEnterable(Cell c)
+	{
+		switch (app::cellType(c)) {
+		case Cell::Empty:
+		case Cell::Robot:
+		case Cell::Earth:
+		case Cell::Razor:
+		case Cell::Lambda:
+		case Cell::ClosedLift:
+		case Cell::OpenLift:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̎̏ŋʂȂĂ悢Z
+	//! {bg̈ړy@ȂAǂ̕\ςȂ
+	//-----------------------------------------------------------------------------
+	inline bool isOpen(Cell c)
+	{
+		return c == Cell::Empty || c == Cell::Robot || c == Cell::Earth || c == Cell::Razor;
+	}
+
+	inline bool isEquivalent(Cell a, Cell b)
+	{
+		return a == b || (isOpen(a) && isOpen(b));
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	DistanceFields::DistanceFields(size_t memoryMax)
+		: mMemoryMax(memoryMax)
+		, mWidth(0)
+		, mHeight(0)
+		, mpInfo(nullptr)
+		, mStampValue(0)
+		, mRepairNum(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	DistanceFields::~DistanceFields()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! map N_ɂׂĂ̕\
+	//! e_̕\́A̔Ֆʂɂ郉_ɂč
+	//-----------------------------------------------------------------------------
+	void DistanceFields::reset(const Map& map)
+	{
+		mWidth = map.cell.width;
+		mHeight = map.cell.height;
+		mpInfo = map.info;
+		mCells = map.cell;
+
+		const size_t cellNum = static_cast<size_t>(mWidth) * mHeight;
+		mStamp.assign(cellNum, 0);
+		mStampValue = 0;
+
+		mSites.clear();
+		for (s32 y = 0; y < mHeight; ++y) {
+			for (s32 x = 0; x < mWidth; ++x) {
+				if (map.cell[y][x] == Cell::Lambda) {
+					mSites.push_back(int2{ x, y });
+				}
+			}
+		}
+
+		// ^[Qbg̈ʒuƁA֔ԃg|̈ʒu
+		mJumpSources.clear();
+		for (u32 i = 0; i < MAX_TRAMPOLINE; ++i) {
+			const u8 target = mpInfo->jump[i];
+			if (target >= MAX_TRAMPOLINE || cellType(map.cell[mpInfo->trampolinePos[i].y][mpInfo->trampolinePos[i].x]) != Cell::Trampoline)
+				continue;
+			const s32 to = indexOf(mpInfo->targetPos[target]);
+			const s32 from = indexOf(mpInfo->trampolinePos[i]);
+			auto it = std::find_if(mJumpSources.begin(), mJumpSources.end(), [to](const std::vector<s32>& v) { return v[0] == to; });
+			if (it == mJumpSources.end()) {
+				mJumpSources.push_back(std::vector<s32>{ to, from });
+			} else {
+				it->push_back(from);
+			}
+		}
+
+		const size_t layerNum = (FIXED_LAYER_NUM + mSites.size()) * cellNum * sizeof(u32) <= mMemoryMax
+			? FIXED_LAYER_NUM + mSites.size() : FIXED_LAYER_NUM;
+		mLayers.resize(layerNum);
+		for (size_t i = 0; i < layerNum; ++i) {
+			Layer& layer = mLayers[i];
+			layer.site = i < FIXED_LAYER_NUM ? -1 : static_cast<s32>(i - FIXED_LAYER_NUM);
+			layer.active = isWanted(layer);
+			if (layer.active) {
+				build(layer);
+			}
+		}
+		mRepairNum = cellNum * layerNum;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \ map ɍ킹
+	//! O̔ՖʂƈႤZTA̎肩狗̕ςZ𒼂
+	//-----------------------------------------------------------------------------
+	void DistanceFields::update(const Map& map)
+	{
+		if (map.info != mpInfo || map.cell.width != mWidth || map.cell.height != mHeight) {
+			reset(map);
+			return;
+		}
+
+		mChanged.clear();
+		for (s32 y = 0; y < mHeight; ++y) {
+			const Cell* src = map.cell[y];
+			Cell* dst = mCells[y];
+			for (s32 x = 0; x < mWidth; ++x) {
+				if (src[x] != dst[x]) {
+					if (!isEquivalent(src[x], dst[x])) {
+						mChanged.push_back(y * mWidth + x);
+					}
+					dst[x] = src[x];
+				}
+			}
+		}
+		repairChanged();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \ map ɍ킹
+	//! ׂ̂ changed ̃ZBdAČɖ߂Z܂܂ĂĂ悢
+	//-----------------------------------------------------------------------------
+	void DistanceFields::update(const Map& map, const std::vector<s32>& changed)
+	{
+		if (map.info != mpInfo || map.cell.width != mWidth || map.cell.height != mHeight) {
+			reset(map);
+			return;
+		}
+
+		mChanged.clear();
+		const Cell* src = map.cell.data();
+		Cell* dst = mCells.data();
+		for (const s32 index : changed) {
+			if (src[index] != dst[index]) {
+				if (!isEquivalent(src[index], dst[index])) {
+					mChanged.push_back(index);
+				}
+				dst[index] = src[index];
+			}
+		}
+		repairChanged();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! mChanged ̃ZƂ̏㉺EA̕ςZ𒼂
+	//-----------------------------------------------------------------------------
+	void DistanceFields::repairChanged()
+	{
+		mRepairNum = 0;
+		if (mChanged.empty())
+			return;
+
+		// ςZƂ̏㉺ÉA̎̓͂ς
+		if (++mStampValue == 0) {
+			std::fill(mStamp.begin(), mStamp.end(), 0);
+			mStampValue = 1;
+		}
+		mSeeds.clear();
+		auto seed = [this](s32 index) {
+			if (mStamp[index] != mStampValue) {
+				mStamp[index] = mStampValue;
+				mSeeds.push_back(index);
+			}
+		};
+		for (const s32 index : mChanged) {
+			seed(index);
+			const s32 x = index % mWidth, y = index / mWidth;
+			for (u32 k = 0; k < 4; ++k) {
+				const s32 nx = x + DX[k], ny = y + DY[k];
+				if (0 <= nx && nx < mWidth && 0 <= ny && ny < mHeight) {
+					seed(ny * mWidth + nx);
+				}
+			}
+		}
+
+		const bool rebuild = mChanged.size() * REBUILD_RATIO > static_cast<size_t>(mWidth) * mHeight;
+		for (Layer& layer : mLayers)
+		{
+			// ς݂̃_̕\ƁAJÕtg̕\͒Ȃ
+			// _߂ (O̔Ֆʂɖ߂) ⃊tgJɍ蒼
+			if (!isWanted(layer)) {
+				layer.active = false;
+				continue;
+			}
+			if (!layer.active) {
+				layer.active = true;
+				build(layer);
+				continue;
+			}
+
+			if (rebuild) {
+				build(layer);
+			} else {
+				repair(layer, mSeeds);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŏ炠 index Ԗڂ̃_܂ł̋
+	//-----------------------------------------------------------------------------
+	u32 DistanceFields::toLambda(u32 index, int2 pos) const
+	{
+		const size_t layer = FIXED_LAYER_NUM + index;
+		if (layer >= mLayers.size() || !mLayers[layer].active)
+			return UNREACHABLE;
+		return mLayers[layer].dist[indexOf(pos)];
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̖ڕWɋ߂Âړ
+	//! ߂ÂȂ (_ɓ͂AtgJĂȂȂ)  Wait
+	//-----------------------------------------------------------------------------
+	Command DistanceFields::descend(const Map& map) const
+	{
+		const s32 robot = indexOf(map.robotPos);
+		const bool lambdaLeft = map.lambdaCollected < map.lambda && mLayers[NEAREST].dist[robot] != UNREACHABLE;
+		const Layer& layer = mLayers[lambdaLeft ? NEAREST : LIFT];
+		if (!layer.active)
+			return Command::Wait;
+		const std::vector<u32>& dist = layer.dist;
+
+		Command best = Command::Wait;
+		u32 bestDist = dist[robot];
+		for (u32 k = 0; k < 4; ++k) {
+			const s32 nx = map.robotPos.x + DX[k], ny = map.robotPos.y + DY[k];
+			if (nx < 0 || nx >= mWidth || ny < 0 || ny >= mHeight)
+				continue;
+
+			const s32 dest = destinationOf(ny * mWidth + nx);
+			if (dest >= 0 && dist[dest] < bestDist) {
+				bestDist = dist[dest];
+				best = MOVES[k];
+			}
+		}
+		return best;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̔Ֆʂŕ\𒼂ĂKv邩
+	//! e_̕\͂̃_cĂԁAtg̕\̓tgJĂԂg
+	//-----------------------------------------------------------------------------
+	bool DistanceFields::isWanted(const Layer& layer) const
+	{
+		if (layer.site >= 0) {
+			const int2 pos = mSites[layer.site];
+			return mCells[pos.y][pos.x] == Cell::Lambda;
+		}
+		if (&layer == &mLayers[LIFT])
+			return mCells[mpInfo->liftPos.y][mpInfo->liftPos.x] == Cell::OpenLift;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 0̃Z
+	//-----------------------------------------------------------------------------
+	bool DistanceFields::isSource(const Layer& layer, s32 index) const
+	{
+		const Cell c = mCells.data()[index];
+		if (layer.site >= 0)
+			return c == Cell::Lambda && index == indexOf(mSites[layer.site]);
+		if (&layer == &mLayers[LIFT])
+			return index == indexOf(mpInfo->liftPos) && (c == Cell::ClosedLift || c == Cell::OpenLift);
+		return (c == Cell::Lambda || c == Cell::HORock) && !isDeadLambda(*mpInfo, c, index % mWidth, index / mWidth);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ׂ̋ÃZ̋߂
+	//-----------------------------------------------------------------------------
+	u32 DistanceFields::compute(const Layer& layer, s32 index) const
+	{
+		if (isSource(layer, index))
+			return 0;
+		if (!isPassable(mCells.data()[index]))
+			return UNREACHABLE;
+
+		u32 best = UNREACHABLE;
+		const s32 x = index % mWidth, y = index / mWidth;
+		for (u32 k = 0; k < 4; ++k) {
+			const s32 nx = x + DX[k], ny = y + DY[k];
+			if (nx < 0 || nx >= mWidth || ny < 0 || ny >= mHeight)
+				continue;
+
+			// ȂڕW (K) ׂ͗ɒΓ͂Ă
+			const s32 next = ny * mWidth + nx;
+			const s32 dest = destinationOf(next);
+			if (dest >= 0 && layer.dist[dest] != UNREACHABLE) {
+				best = std::min(best, layer.dist[dest] + 1);
+			} else if (dest < 0 && layer.dist[next] == 0) {
+				best = 1;
+			}
+		}
+		return best;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Zɓ낤ƂɒZBȂ-1
+	//-----------------------------------------------------------------------------
+	s32 DistanceFields::destinationOf(s32 index) const
+	{
+		const Cell c = mCells.data()[index];
+		if (isEnterable(c))
+			return index;
+		if (cellType(c) == Cell::Trampoline) {
+			const u8 target = mpInfo->jump[cellLabel(c)];
+			if (target < MAX_TRAMPOLINE)
+				return indexOf(mpInfo->targetPos[target]);
+		}
+		return -1;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 1 index ɒZ񋓂
+	//! ēׂ̃ZƁA֔ԃg|ׂ̗̃ZBKׂ͗ɒZ
+	//-----------------------------------------------------------------------------
+	template<class Func>
+	void DistanceFields::forEachPredecessor(s32 index, Func func) const
+	{
+		auto neighbors = [&](s32 center) {
+			const s32 x = center % mWidth, y = center / mWidth;
+			for (u32 k = 0; k < 4; ++k) {
+				const s32 nx = x + DX[k], ny = y + DY[k];
+				if (0 <= nx && nx < mWidth && 0 <= ny && ny < mHeight) {
+					func(ny * mWidth + nx);
+				}
+			}
+		};
+
+		const Cell c = mCells.data()[index];
+		if (isEnterable(c) || c == Cell::HORock) {
+			neighbors(index);
+		}
+
+		for (const auto& jump : mJumpSources) {
+			if (jump[0] != index)
+				continue;
+			for (size_t i = 1; i < jump.size(); ++i) {
+				if (cellType(mCells.data()[jump[i]]) == Cell::Trampoline) {
+					neighbors(jump[i]);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 0̃Z畝Dō蒼
+	//-----------------------------------------------------------------------------
+	void DistanceFields::build(Layer& layer)
+	{
+		const s32 cellNum = mWidth * mHeight;
+		layer.dist.assign(cellNum, static_cast<u32>(UNREACHABLE));
+
+		std::vector<s32> queue;
+		for (s32 i = 0; i < cellNum; ++i) {
+			if (isSource(layer, i)) {
+				layer.dist[i] = 0;
+				queue.push_back(i);
+			}
+		}
+
+		for (size_t head = 0; head < queue.size(); ++head) {
+			const s32 index = queue[head];
+			const u32 d = layer.dist[index] + 1;
+			forEachPredecessor(index, [&](s32 prev) {
+				if (layer.dist[prev] == UNREACHABLE && isPassable(mCells.data()[prev])) {
+					layer.dist[prev] = d;
+					queue.push_back(prev);
+				}
+			});
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! seeds ̎肾𒼂
+	//! ܂߂ɁAxċLтZTĖɂ
+	//! ɖ̃Z seeds ׂ̋狁ߒAk񂾕߂ɍL
+	//-----------------------------------------------------------------------------
+	void DistanceFields::repair(Layer& layer, const std::vector<s32>& seeds)
+	{
+		std::vector<u32>& dist = layer.dist;
+		MinQueue& queue = mQueue;
+		std::vector<s32>& invalid = mInvalid;
+		invalid.clear();
+
+		for (const s32 index : seeds) {
+			if (dist[index] != UNREACHABLE) {
+				queue.push(Item(dist[index], index));
+			}
+		}
+
+		while (!queue.empty())
+		{
+			const Item item = queue.top();
+			queue.pop();
+			const u32 d = item.first;
+			const s32 index = item.second;
+			if (dist[index] != d || compute(layer, index) <= d)
+				continue;
+
+			dist[index] = UNREACHABLE;
+			invalid.push_back(index);
+			forEachPredecessor(index, [&](s32 prev) {
+				if (dist[prev] == d + 1) {
+					queue.push(Item(d + 1, prev));
+				}
+			});
+		}
+
+		auto settle = [&](s32 index) {
+			const u32 d = compute(layer, index);
+			if (d < dist[index]) {
+				dist[index] = d;
+				queue.push(Item(d, index));
+			}
+		};
+		for (const s32 index : seeds) {
+			settle(index);
+		}
+		for (const s32 index : invalid) {
+			settle(index);
+		}
+
+		while (!queue.empty())
+		{
+			const Item item = queue.top();
+			queue.pop();
+			const u32 d = item.first;
+			const s32 index = item.second;
+			if (dist[index] != d)
+				continue;
+
+			mRepairNum++;
+			forEachPredecessor(index, [&](s32 prev) {
+				if (d + 1 < dist[prev] && isPassable(mCells.data()[prev])) {
+					dist[prev] = d + 1;
+					queue.push(Item(d + 1, prev));
+				}
+			});
+		}
+		mRepairNum += invalid.size();
+	}
+
+}
@@ -0,0 +1,115 @@
+//
+// Distance Fields
+//
+
+#pragma once
+
+#include <climits>
+#include <functional>
+#include <queue>
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class DistanceFields
+	//! eZAŊ̃_AtgAŏ炠e_܂ł̍ŒZ萔
+	//! Ŋ̃_ɂ͍K܂߁AׂɒΓ͂Ƃ݂ȂBxƉłȂ̂͏
+	//! ͓Ȃ̂ƂAg|̓Wvւ1ƂĐ
+	//! ՖʂςAςZ̎肾𒼂BO̔Ֆʂɖ߂
+	//! T1{̌oHHȂgBXbhƂ1
+	//===================================================================================
+	class DistanceFields
+	{
+	public:
+		static const u32 UNREACHABLE = UINT_MAX;
+
+		//! e_܂ł̕\ memoryMax Ɏ܂鎞
+		explicit DistanceFields(size_t memoryMax = 16 << 20);
+		~DistanceFields();
+
+		void reset(const Map& map);
+
+		//! O̔ՖʂƈႤZŜTĒ
+		void update(const Map& map);
+
+		//! changed ɋZO̔ՖʂƔׂĒ
+		//! Simulator::step ŏZAO update Ăׂ̕ēn
+		void update(const Map& map, const std::vector<s32>& changed);
+
+		u32 toNearestLambda(int2 pos) const { return mLayers[NEAREST].dist[indexOf(pos)]; }
+		//! tgJĂȂ UNREACHABLE
+		u32 toLift(int2 pos) const { return mLayers[LIFT].active ? mLayers[LIFT].dist[indexOf(pos)] : UNREACHABLE; }
+
+		//! ŏ炠 index Ԗڂ̃_܂ŁB\ĂȂAς݂Ȃ UNREACHABLE
+		u32 toLambda(u32 index, int2 pos) const;
+		u32 getLambdaNum() const { return static_cast<u32>(mSites.size()); }
+		int2 getLambdaPos(u32 index) const { return mSites[index]; }
+		bool hasLambdaFields() const { return mLayers.size() > FIXED_LAYER_NUM; }
+
+		//! ̖ڕW (_cĂ΍Ŋ̃_A΃tg) ɋ߂Âړ
+		//! ߂ÂȂ Wait
+		Command descend(const Map& map) const;
+
+		//! Ō update ŋ𒼂Z̐
+		u64 getRepairNum() const { return mRepairNum; }
+
+	private:
+		enum LayerIndex
+		{
+			NEAREST,
+			LIFT,
+			FIXED_LAYER_NUM,
+		};
+
+		//! ̏ɎoƃL[
+		using Item = std::pair<u32, s32>;
+		using MinQueue = std::priority_queue<Item, std::vector<Item>, std::greater<Item>>;
+
+		struct Layer
+		{
+			std::vector<u32> dist;
+			s32 site;		// e_̕\Ȃ mSites ̔ԍBȊO-1
+			bool active;	// _AtgJO͒Ȃ
+		};
+
+		s32 indexOf(int2 pos) const { return pos.y * mWidth + pos.x; }
+
+		bool isWanted(const Layer& layer) const;
+		bool isSource(const Layer& layer, s32 index) const;
+		u32 compute(const Layer& layer, s32 index) const;
+		s32 destinationOf(s32 index) const;
+		template<class Func>
+		void forEachPredecessor(s32 index, Func func) const;
+
+		void build(Layer& layer);
+		void repair(Layer& layer, const std::vector<s32>& seeds);
+		void repairChanged();
+
+	private:
+		size_t mMemoryMax;
+		s32 mWidth;
+		s32 mHeight;
+		const MapInfo* mpInfo;
+
+		s3d::Grid<Cell> mCells;		// 킹Ֆ
+		std::vector<int2> mSites;
+		std::vector<Layer> mLayers;
+
+		// ^[QbgƂ́A֔ԃg|̈ʒu
+		std::vector<std::vector<s32>> mJumpSources;
+
+		// Ɨ̈BL[͖ɂȂ܂ŎôŁAmۂg
+		MinQueue mQueue;
+		std::vector<s32> mInvalid;
+		std::vector<s32> mChanged;
+		std::vector<s32> mSeeds;
+		std::vector<u32> mStamp;
+		u32 mStampValue;
+
+		u64 mRepairNum;
+	};
+
+}
@@ -0,0 +1,615 @@
+//
+// Distributed Solver
+//
+
+#include "stdafx.h"
+#include "DistributedSolver.h"
+
+#include <thread>
+#include <unordered_set>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+
+#include "Map.h"
+#include "Simulator.h"
+#include "MapAnalysis.h"
+#include "Evaluator.h"
+#include "DistanceFields.h"
+#include "BeamSearch.h"
+#include "Replay.h"
+
+namespace {
+
+	using namespace app;
+
+	static const u32 SHARED_MAGIC = 0x53444c4c;	// "LLDS"
+	static const u32 SHARED_VERSION = 2;
+
+	// dɂ郋[g̍ő咷
+	static const u32 JOB_ROUTE_MAX = 32;
+
+	// [J[̎d̐
+	static const u32 JOBS_PER_WORKER = 8;
+
+	// u\ŒTXbg
+	static const u32 TABLE_PROBE = 16;
+
+	// ԂȂ̎d̎ [s]
+	static const f64 DEFAULT_SLICE = 10.0;
+
+	// IwĂ҂ [ms]
+	static const DWORD STOP_TIMEOUT = 2000;
+
+	// ŗǃ[gɍsԊu [ms]
+	static const DWORD POLL_INTERVAL = 10;
+
+	// ŗǃ[g̃bN񐔂ƁA傪Ă邩ׂԊu
+	static const u32 LOCK_SPIN_MAX = 1 << 16;
+	static const u32 LOCK_CHECK_INTERVAL = 1 << 10;
+
+	static const Command COMMANDS[] = { Command::Up, Command::Down, Command::Left, Command::Right, Command::Wait, Command::Shave };
+
+	//===================================================================================
+	//! ǂݍݐp̔Ֆ
+	//===================================================================================
+	struct SharedMapHeader
+	{
+		u32 magic;
+		u32 infoLength;
+		u32 mapLength;
+		u32 analysisLength;
+	};
+
+	//===================================================================================
+	//! ǂݏ鋤Lf[^̐擪
+	//===================================================================================
+	struct SharedHeader
+	{
+		u32 magic;
+		u32 version;
+		u32 workerNum;
+		u32 beamWidth;
+		f64 sliceSeconds;
+
+		volatile LONG stop;
+
+		// d̃L[Bd͋NOɂׂĐςނ̂ŁAo͐擪i߂邾
+		volatile LONG jobHead;
+		u32 jobNum;
+
+		// u\
+		u32 tableMask;
+
+		// ŗǃ[gB݂ bestLock ŔrAbNɂ͎̃vZXID
+		// bestSeq ͏ݒ͊AIƋɂȂ
+		volatile LONG bestLock;
+		volatile LONG bestScore;
+		volatile LONG bestSeq;
+		u32 bestLength;
+		u32 routeCapacity;
+
+		u64 jobOffset;
+		u64 tableOffset;
+		u64 routeOffset;
+		u64 totalSize;
+	};
+
+	struct SharedJob
+	{
+		u32 length;
+		s3d::wchar cmds[JOB_ROUTE_MAX];
+	};
+
+	//! Ֆʂ̃nbVƂɒŏ̎萔
+	struct SharedEntry
+	{
+		volatile LONG64 key;
+		volatile LONG depth;
+		u32 reserved;
+	};
+
+	//===================================================================================
+	//! L̃r[
+	//===================================================================================
+	class SharedView
+	{
+	public:
+		SharedView() : mMapping(nullptr), mpData(nullptr) {}
+		~SharedView() { close(); }
+
+		bool create(const s3d::String& name, u64 size)
+		{
+			mMapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name.c_str());
+			if (!mMapping || ::GetLastError() == ERROR_ALREADY_EXISTS) {
+				close();
+				return false;
+			}
+			return map(FILE_MAP_ALL_ACCESS);
+		}
+
+		bool open(const s3d::String& name, bool writable)
+		{
+			const DWORD access = writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+			mMapping = ::OpenFileMappingW(access, FALSE, name.c_str());
+			if (!mMapping)
+				return false;
+			return map(access);
+		}
+
+		void close()
+		{
+			if (mpData) {
+				::UnmapViewOfFile(mpData);
+				mpData = nullptr;
+			}
+			if (mMapping) {
+				::CloseHandle(mMapping);
+				mMapping = nullptr;
+			}
+		}
+
+		u8* data() const { return mpData; }
+
+	private:
+		SharedView(const SharedView&) = delete;
+		SharedView& operator=(const SharedView&) = delete;
+
+		bool map(DWORD access)
+		{
+			mpData = static_cast<u8*>(::MapViewOfFile(mMapping, access, 0, 0, 0));
+			if (!mpData) {
+				close();
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		HANDLE mMapping;
+		u8* mpData;
+	};
+
+	inline s3d::String mapNameOf(const s3d::String& name) { return name + L".map"; }
+	inline s3d::String stateNameOf(const s3d::String& name) { return name + L".state"; }
+
+	inline SharedJob* jobsOf(SharedHeader* header) { return reinterpret_cast<SharedJob*>(reinterpret_cast<u8*>(header) + header->jobOffset); }
+	inline SharedEntry* tableOf(SharedHeader* header) { return reinterpret_cast<SharedEntry*>(reinterpret_cast<u8*>(header) + header->tableOffset); }
+	inline s3d::wchar* routeOf(SharedHeader* header) { return reinterpret_cast<s3d::wchar*>(reinterpret_cast<u8*>(header) + header->routeOffset); }
+
+	//-----------------------------------------------------------------------------
+	//! vZXIĂȂ
+	//-----------------------------------------------------------------------------
+	bool isProcessAlive(DWORD pid)
+	{
+		const HANDLE h = ::OpenProcess(SYNCHRONIZE, FALSE, pid);
+		if (!h)
+			return ::GetLastError() == ERROR_ACCESS_DENIED;
+
+		const bool alive = ::WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+		::CloseHandle(h);
+		return alive;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŗǃ[g̃bN
+	//! 傪IĂ΃bN󂵂Ď蒼BspinMax 񎎂ĎȂΒ߂
+	//-----------------------------------------------------------------------------
+	bool lockBest(SharedHeader* header, u32 spinMax = LOCK_SPIN_MAX)
+	{
+		const LONG self = static_cast<LONG>(::GetCurrentProcessId());
+		for (u32 i = 1; i <= spinMax; ++i) {
+			const LONG owner = ::InterlockedCompareExchange(&header->bestLock, self, 0);
+			if (owner == 0)
+				return true;
+
+			if (i % LOCK_CHECK_INTERVAL == 0 && !isProcessAlive(static_cast<DWORD>(owner))) {
+				::InterlockedCompareExchange(&header->bestLock, 0, owner);
+				continue;
+			}
+			::Sleep(0);
+		}
+		return false;
+	}
+
+	void unlockBest(SharedHeader* header)
+	{
+		::InterlockedExchange(&header->bestLock, 0);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŗǃ[go^
+	//! ݒɗĂꂽ[gǂ܂Ȃ悤AbestSeq ɂĂ珑
+	//-----------------------------------------------------------------------------
+	void offerBest(SharedHeader* header, const s3d::String& route, s32 score)
+	{
+		if (score <= header->bestScore || route.length > header->routeCapacity)
+			return;
+
+		if (!lockBest(header))
+			return;
+		if (score > header->bestScore) {
+			const LONG seq = header->bestSeq | 1;
+			::InterlockedExchange(&header->bestSeq, seq);
+			std::memcpy(routeOf(header), route.c_str(), route.length * sizeof(s3d::wchar));
+			header->bestLength = route.length;
+			::InterlockedExchange(&header->bestScore, score);
+			::InterlockedExchange(&header->bestSeq, seq + 1);
+		}
+		unlockBest(header);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! u\ɔՖʂo^
+	//! ̃[J[菭Ȃ萔ŒĂfalseԂ
+	//! \܂Ăēo^łȂׂ͒ƂɂAtrueԂ
+	//-----------------------------------------------------------------------------
+	bool visitShared(SharedHeader* header, u64 hash, u32 depth)
+	{
+		SharedEntry* table = tableOf(header);
+		const LONG64 key = hash ? static_cast<LONG64>(hash) : 1;
+
+		for (u32 i = 0; i < TABLE_PROBE; ++i) {
+			SharedEntry& entry = table[(hash + i) & header->tableMask];
+
+			LONG64 cur = entry.key;
+			if (cur == 0) {
+				cur = ::InterlockedCompareExchange64(&entry.key, key, 0);
+				if (cur == 0) {
+					::InterlockedExchange(&entry.depth, static_cast<LONG>(depth) + 1);
+					return true;
+				}
+			}
+			if (cur != key)
+				continue;
+
+			// 萔1𑫂ĎB0͑̃[J[o^
+			const LONG d = static_cast<LONG>(depth) + 1;
+			LONG old = entry.depth;
+			while (old != 0 && d < old) {
+				const LONG prev = ::InterlockedCompareExchange(&entry.depth, d, old);
+				if (prev == old)
+					return true;
+				old = prev;
+			}
+			return false;
+		}
+		return true;
+	}
+
+	//===================================================================================
+	//! d鎞̔Ֆ
+	//===================================================================================
+	struct JobNode
+	{
+		Map map;
+		s3d::String route;
+		f64 eval;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! Ֆʂ畝DœWJAقȂՖʂɎZ[gdɂ
+	//! IՖʂ͂̏œo^
+	//-----------------------------------------------------------------------------
+	void makeJobs(const Map& initial, u32 jobMax, SolverContext& ctx, std::vector<JobNode>& jobs)
+	{
+		const DefaultEvaluator evaluator;
+		DistanceFields fields(0);
+		std::unordered_set<u64> seen;
+		seen.insert(hashOfMap(initial));
+
+		std::vector<JobNode> frontier(1), next;
+		frontier[0].map = initial;
+		frontier[0].eval = 0.0;
+
+		for (u32 depth = 0; depth < JOB_ROUTE_MAX && frontier.size() < jobMax && !frontier.empty(); ++depth)
+		{
+			next.clear();
+			for (const auto& node : frontier) {
+				for (const auto cmd : COMMANDS) {
+					if (cmd == Command::Shave && node.map.razor == 0)
+						continue;
+
+					JobNode child;
+					child.map = node.map;
+					if (!Simulator::step(cmd, child.map) || child.map.condition == Condition::Losing)
+						continue;
+					if (!seen.insert(hashOfMap(child.map)).second)
+						continue;
+
+					child.route = node.route + charOfCommand(cmd);
+					if (child.map.condition == Condition::Winning) {
+						ctx.publish(child.route, child.map.score);
+						continue;
+					}
+
+					fields.update(child.map);
+					child.eval = evaluator.evaluate(child.map, fields);
+					next.push_back(std::move(child));
+				}
+			}
+
+			// WJłȂȂO̐[̂܂܎dɂ
+			if (next.empty())
+				break;
+			frontier.swap(next);
+		}
+
+		std::sort(frontier.begin(), frontier.end(), [](const JobNode& a, const JobNode& b) { return a.eval > b.eval; });
+		jobs.swap(frontier);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! g[J[ƂċN
+	//-----------------------------------------------------------------------------
+	HANDLE spawnWorker(const s3d::String& name)
+	{
+		wchar_t path[MAX_PATH];
+		if (!::GetModuleFileNameW(nullptr, path, MAX_PATH))
+			return nullptr;
+
+		s3d::String cmdline = s3d::Format(s3d::PyFmt, L"\"{}\" -worker {}", path, name);
+
+		STARTUPINFOW si = {};
+		si.cb = sizeof(si);
+		PROCESS_INFORMATION pi = {};
+		if (!::CreateProcessW(path, &cmdline[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi))
+			return nullptr;
+
+		::CloseHandle(pi.hThread);
+		return pi.hProcess;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	DistributedSolver::DistributedSolver(u32 workerNum, u32 beamWidth, u64 tableBytes)
+		: mWorkerNum(workerNum > 0 ? workerNum : std::max(1u, std::thread::hardware_concurrency()))
+		, mBeamWidth(std::max(1u, beamWidth))
+		, mTableBytes(tableBytes)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	DistributedSolver::~DistributedSolver()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! dċLɒuA[J[Nčŗǃ[g
+	//-----------------------------------------------------------------------------
+	void DistributedSolver::solve(const Map& initial, SolverContext& ctx)
+	{
+		ctx.publish(s3d::String(1, charOfCommand(Command::Abort)), finalScore(initial));
+
+		std::vector<JobNode> jobs;
+		makeJobs(initial, mWorkerNum * JOBS_PER_WORKER, ctx, jobs);
+		if (jobs.empty() || ctx.isCancelled())
+			return;
+
+		const s3d::String name = s3d::Format(s3d::PyFmt, L"Local\\LambdaLifting.{}.{}", ::GetCurrentProcessId(), ::GetTickCount());
+
+		// ՖʂƉ͌ʂuB[J[͉͂Ȃ
+		MapInfo analyzed;
+		const MapInfo* info = initial.info;
+		if (!info->isAnalyzed()) {
+			analyzed = *info;
+			analyzeMap(initial, analyzed);
+			info = &analyzed;
+		}
+
+		std::vector<u8> infoBytes, mapBytes, analysisBytes;
+		packMapInfo(*info, infoBytes);
+		packMap(initial, mapBytes);
+		packAnalysis(*info, analysisBytes);
+
+		SharedView mapView;
+		if (!mapView.create(mapNameOf(name), sizeof(SharedMapHeader) + infoBytes.size() + mapBytes.size() + analysisBytes.size()))
+			return;
+		{
+			SharedMapHeader* header = reinterpret_cast<SharedMapHeader*>(mapView.data());
+			header->magic = SHARED_MAGIC;
+			header->infoLength = static_cast<u32>(infoBytes.size());
+			header->mapLength = static_cast<u32>(mapBytes.size());
+			header->analysisLength = static_cast<u32>(analysisBytes.size());
+			u8* p = mapView.data() + sizeof(SharedMapHeader);
+			std::memcpy(p, infoBytes.data(), infoBytes.size());
+			std::memcpy(p + infoBytes.size(), mapBytes.data(), mapBytes.size());
+			std::memcpy(p + infoBytes.size() + mapBytes.size(), analysisBytes.data(), analysisBytes.size());
+		}
+
+		// u\AdAŗǃ[gu
+		u32 tableSlots = 1;
+		while (static_cast<u64>(tableSlots) * 2 * sizeof(SharedEntry) <= mTableBytes && tableSlots < (1u << 30))
+			tableSlots *= 2;
+		// d̎A[J[̃r[T[`̎AŌAbort
+		const u32 routeCapacity = JOB_ROUTE_MAX + BeamSearch::depthMaxOf(initial) + 1;
+
+		const u64 jobOffset = sizeof(SharedHeader);
+		const u64 tableOffset = (jobOffset + jobs.size() * sizeof(SharedJob) + 63) & ~63ull;
+		const u64 routeOffset = tableOffset + static_cast<u64>(tableSlots) * sizeof(SharedEntry);
+		const u64 totalSize = routeOffset + routeCapacity * sizeof(s3d::wchar);
+
+		SharedView stateView;
+		if (!stateView.create(stateNameOf(name), totalSize))
+			return;
+
+		// Ot̃}bsO̓[ŏĂ
+		SharedHeader* header = reinterpret_cast<SharedHeader*>(stateView.data());
+		header->magic = SHARED_MAGIC;
+		header->version = SHARED_VERSION;
+		header->workerNum = mWorkerNum;
+		header->beamWidth = mBeamWidth;
+		header->sliceSeconds = ctx.hasDeadline() ? std::max(0.1, ctx.getRemaining() * mWorkerNum / jobs.size()) : DEFAULT_SLICE;
+		header->jobNum = static_cast<u32>(jobs.size());
+		header->tableMask = tableSlots - 1;
+		header->bestScore = ctx.getBestScore();
+		header->routeCapacity = routeCapacity;
+		header->jobOffset = jobOffset;
+		header->tableOffset = tableOffset;
+		header->routeOffset = routeOffset;
+		header->totalSize = totalSize;
+
+		SharedJob* sharedJobs = jobsOf(header);
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			sharedJobs[i].length = jobs[i].route.length;
+			std::memcpy(sharedJobs[i].cmds, jobs[i].route.c_str(), jobs[i].route.length * sizeof(s3d::wchar));
+			visitShared(header, hashOfMap(jobs[i].map), jobs[i].route.length);
+		}
+		jobs.clear();
+
+		// [J[N
+		std::vector<HANDLE> workers;
+		for (u32 i = 0; i < mWorkerNum; ++i) {
+			const HANDLE h = spawnWorker(name);
+			if (h) {
+				workers.push_back(h);
+			}
+		}
+
+		// ŗǃ[g̍XVEBݒɗ[J[̃[g͓ǂ܂Ȃ
+		LONG seq = 0;
+		s3d::String route;
+		auto collect = [&] {
+			if (header->bestSeq == seq || !lockBest(header))
+				return;
+			const LONG cur = header->bestSeq;
+			if (cur == seq || (cur & 1)) {
+				unlockBest(header);
+				return;
+			}
+			seq = cur;
+			const s32 score = header->bestScore;
+			route = std::wstring(routeOf(header), header->bestLength);
+			unlockBest(header);
+			ctx.publish(route, score);
+		};
+
+		while (!ctx.isCancelled()) {
+			collect();
+
+			bool running = false;
+			for (const auto h : workers) {
+				running |= ::WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+			}
+			if (!running)
+				break;
+
+			::Sleep(POLL_INTERVAL);
+		}
+
+		// ~߂BȂ[J[͋I
+		::InterlockedExchange(&header->stop, 1);
+		const DWORD until = ::GetTickCount() + STOP_TIMEOUT;
+		for (const auto h : workers) {
+			const DWORD now = ::GetTickCount();
+			if (::WaitForSingleObject(h, until > now ? until - now : 0) == WAIT_TIMEOUT) {
+				::TerminateProcess(h, 1);
+				::WaitForSingleObject(h, INFINITE);
+			}
+			::CloseHandle(h);
+		}
+
+		// I[J[܂܂̃bN lockBest 
+		collect();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [J[
+	//! doăr[T[`𑖂点AʂL̍ŗǃ[gɓo^
+	//-----------------------------------------------------------------------------
+	int DistributedSolver::runWorker(const s3d::String& name)
+	{
+		SharedView mapView, stateView;
+		if (!mapView.open(mapNameOf(name), false) || !stateView.open(stateNameOf(name), true))
+			return 1;
+
+		const SharedMapHeader* mapHeader = reinterpret_cast<const SharedMapHeader*>(mapView.data());
+		SharedHeader* header = reinterpret_cast<SharedHeader*>(stateView.data());
+		if (mapHeader->magic != SHARED_MAGIC || header->magic != SHARED_MAGIC || header->version != SHARED_VERSION)
+			return 1;
+
+		// Ֆʂ͎dƂɓǂݍݐp̃r[璼ړWJA茳ɎʂȂ
+		MapInfo mapInfo;
+		Map map;
+		const u8* p = mapView.data() + sizeof(SharedMapHeader);
+		if (!unpackMapInfo(p, p + mapHeader->infoLength, mapInfo))
+			return 1;
+		const u8* mapBegin = p;
+		const u8* mapEnd = p + mapHeader->mapLength;
+		if (!unpackMap(p, mapEnd, map) || !unpackAnalysis(p, p + mapHeader->analysisLength, map, mapInfo))
+			return 1;
+
+		// I̎wAs̒T~߂
+		std::mutex mutex;
+		SolverContext* current = nullptr;
+		std::atomic<bool> done(false);
+		std::thread watcher([&] {
+			while (!done) {
+				if (header->stop) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (current) {
+						current->cancel();
+					}
+				}
+				::Sleep(POLL_INTERVAL);
+			}
+		});
+
+		const SharedJob* jobs = jobsOf(header);
+		while (!header->stop)
+		{
+			const LONG k = ::InterlockedIncrement(&header->jobHead) - 1;
+			if (k < 0 || static_cast<u32>(k) >= header->jobNum)
+				break;
+
+			const s3d::String prefix(std::wstring(jobs[k].cmds, jobs[k].length));
+			const u8* q = mapBegin;
+			if (!unpackMap(q, mapEnd, map))
+				break;
+			map.info = &mapInfo;
+			replayRoute(prefix, map);
+			if (map.condition != Condition::Playing)
+				continue;
+
+			SolverContext ctx;
+			ctx.setTimeLimit(header->sliceSeconds);
+			ctx.setImproveCallback([header, &prefix](const s3d::String& route, s32 score) {
+				offerBest(header, prefix + route, score);
+			});
+
+			BeamSearch solver(header->beamWidth, 1);
+			solver.setVisitFilter([header, &prefix](u64 hash, u32 depth) {
+				return visitShared(header, hash, prefix.length + depth);
+			});
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				current = &ctx;
+			}
+			if (!header->stop) {
+				solver.solve(map, ctx);
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				current = nullptr;
+			}
+		}
+
+		done = true;
+		watcher.join();
+		return 0;
+	}
+
+}
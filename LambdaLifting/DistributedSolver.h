@@ -0,0 +1,38 @@
+//
+// Distributed Solver
+//
+
+#pragma once
+
+#include "Solver.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class DistributedSolver
+	//! }Vɕ̃[J[vZXNăr[T[`𕪒S
+	//! Ֆʂ͈xǂݍœǂݍݐp̋LɒuAe[J[͂Ďg
+	//! u\Ad̃L[Aŗǃ[g͕ʂ̋LɒuAInterlocked 삾ł肷
+	//! L̃f[^͌Œ蒷̃R[hȂ̂ŁAŃlbg[Nzɂ
+	//===================================================================================
+	class DistributedSolver : public Solver
+	{
+	public:
+		explicit DistributedSolver(u32 workerNum = 0, u32 beamWidth = 1000, u64 tableBytes = 256ull << 20);
+		~DistributedSolver();
+
+		const s3d::wchar* getName() const override { return L"distributed"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		//! -worker ŋNꂽvZX̖{
+		static int runWorker(const s3d::String& name);
+
+	private:
+		u32 mWorkerNum;
+		u32 mBeamWidth;
+		u64 mTableBytes;
+	};
+
+}
@@ -0,0 +1,79 @@
+//
+// Evaluator
+//
+
+#include "stdafx.h"
+#include "Evaluator.h"
+
+#include "Map.h"
+#include "DistanceFields.h"
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	DefaultEvaluator::DefaultEvaluator(const EvaluatorWeights& weights)
+		: mWeights(weights)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ]
+	//-----------------------------------------------------------------------------
+	f64 DefaultEvaluator::evaluate(const Map& map, const DistanceFields& fields) const
+	{
+		switch (map.condition) {
+		case Condition::Winning:
+			return 1e9 + map.score;
+		case Condition::Losing:
+			return -1e9;
+		default:
+			break;
+		}
+
+		return map.score
+			+ mWeights.lambda * map.lambdaCollected
+			- mWeights.distance * distanceToTarget(map, fields)
+			- mWeights.danger * dangerOf(map);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̖ڕW܂ł̋
+	//! ̃_ (K܂) cĂ΂̍ŊAȂ΃tg
+	//! ͓Ȃ̂Ƃ̕\A͂ȂΑ傫ȒlԂ
+	//-----------------------------------------------------------------------------
+	s32 distanceToTarget(const Map& map, const DistanceFields& fields)
+	{
+		const bool lambdaLeft = map.lambdaCollected < map.lambda;
+		const u32 d = lambdaLeft ? fields.toNearestLambda(map.robotPos) : fields.toLift(map.robotPos);
+		if (d == DistanceFields::UNREACHABLE)
+			return (map.cell.width + map.cell.height) * 2;
+		return static_cast<s32>(d);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 댯x
+	//! ^̋󂫃}X̏Ɋ₪AŖh̎c肪Ȃ
+	//-----------------------------------------------------------------------------
+	f64 dangerOf(const Map& map)
+	{
+		f64 danger = 0.0;
+
+		const int2 pos = map.robotPos;
+		if (pos.y >= 2 && map.cell[pos.y - 1][pos.x] == Cell::Empty) {
+			const Cell c = map.cell[pos.y - 2][pos.x];
+			if (c == Cell::Rock || c == Cell::HORock)
+				danger += 1.0;
+		}
+
+		const u32 waterproof = map.info->waterproof;
+		if (map.cell.height - static_cast<s32>(map.water) <= pos.y) {
+			danger += static_cast<f64>(waterproof - map.waterproofCount + 1) / (waterproof + 1);
+		}
+
+		return danger;
+	}
+
+}
@@ -0,0 +1,60 @@
+//
+// Evaluator
+//
+
+#pragma once
+
+namespace app
+{
+
+	// Forward declaration
+	struct Map;
+	class DistanceFields;
+
+	//===================================================================================
+	//! @class Evaluator
+	//! T̔Ֆʂ̗ǂB̃Xbh瓯ɌĂ΂
+	//! fields ͌ĂяoXbhƂɎAmap ɍ킹Ăn
+	//===================================================================================
+	class Evaluator
+	{
+	public:
+		Evaluator(){}
+		virtual ~Evaluator(){}
+
+		virtual f64 evaluate(const Map& map, const DistanceFields& fields) const = 0;
+	};
+
+	//===================================================================================
+	//! @struct EvaluatorWeights
+	//===================================================================================
+	struct EvaluatorWeights
+	{
+		f64 lambda;		// ς݃_1
+		f64 distance;	// ̖ڕW (_tg) ܂ł̋1
+		f64 danger;		// ΂␅v̊댯x1
+
+		EvaluatorWeights() : lambda(50.0), distance(1.0), danger(20.0) {}
+	};
+
+	//===================================================================================
+	//! @class DefaultEvaluator
+	//! XRA + ς݃_ - ڕW܂ł̋ - 댯x
+	//===================================================================================
+	class DefaultEvaluator : public Evaluator
+	{
+	public:
+		explicit DefaultEvaluator(const EvaluatorWeights& weights = EvaluatorWeights());
+
+		f64 evaluate(const Map& map, const DistanceFields& fields) const override;
+
+		const EvaluatorWeights& getWeights() const { return mWeights; }
+
+	private:
+		EvaluatorWeights mWeights;
+	};
+
+	s32 distanceToTarget(const Map& map, const DistanceFields& fields);
+	f64 dangerOf(const Map& map);
+
+}
@@ -0,0 +1,587 @@
+//
+// Exhaustive Solver
+//
+
+#include "stdafx.h"
+#include "ExhaustiveSolver.h"
+
+#include <cstring>
+
+#include "Map.h"
+#include "Simulator.h"
+#include "TaskPool.h"
+#include "MappedFile.h"
+#include "FileUtil.h"
+#include "Replay.h"
+#include "Hash.h"
+#include "MapAnalysis.h"
+
+namespace {
+
+	static const app::Command COMMANDS[] = {
+		app::Command::Up,
+		app::Command::Down,
+		app::Command::Left,
+		app::Command::Right,
+		app::Command::Wait,
+		app::Command::Shave,
+	};
+	static const u32 COMMAND_NUM = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+	// \̓nbV̏ʃrbgŕAƂɕʃXbhő}
+	static const u32 SHARD_BITS = 4;
+	static const u32 SHARD_NUM = 1 << SHARD_BITS;
+
+	static const size_t SEGMENT_BYTES = 4 << 20;
+
+	// ̒lBʂɃnbV̈ꕔAʂɔԍ+1
+	static const u64 INDEX_ID_MASK = (1ull << 40) - 1;
+	static const u64 INDEX_TAG_MASK = ~INDEX_ID_MASK;
+
+	static const u64 NO_PARENT = ~0ull;
+
+	// R[h̔zu
+	// [hash:8][parent:8][stepCount:4][score:4][depth:4][cmd:1][packMapŋl߂Ֆ]
+	// depth ͍ŌɃteBAɓꂽw
+	static const size_t RECORD_HASH = 0;
+	static const size_t RECORD_PARENT = 8;
+	static const size_t RECORD_STEP = 16;
+	static const size_t RECORD_SCORE = 20;
+	static const size_t RECORD_DEPTH = 24;
+	static const size_t RECORD_CMD = 28;
+	static const size_t RECORD_KEY = 29;
+
+	template <class T>
+	inline T load(const u8* p)
+	{
+		T v;
+		std::memcpy(&v, p, sizeof(T));
+		return v;
+	}
+
+	template <class T>
+	inline void store(u8* p, const T& v)
+	{
+		std::memcpy(p, &v, sizeof(T));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ֆʂrp̃oCgɂ
+	//! 萔ƃXRA͌oHƂɈႤ̂0ɂċl߂
+	//-----------------------------------------------------------------------------
+	void packKey(app::Map& map, std::vector<u8>& key)
+	{
+		const u32 stepCount = map.stepCount;
+		const s32 score = map.score;
+		map.stepCount = 0;
+		map.score = 0;
+
+		key.clear();
+		app::packMap(map, key);
+
+		map.stepCount = stepCount;
+		map.score = score;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! packKey ̌ʂ̃nbV
+	//! ʃrbgŕ߂̂ōŌɂ悭
+	//-----------------------------------------------------------------------------
+	u64 hashKey(const std::vector<u8>& key)
+	{
+		u64 h = app::hashBytes(key.data(), key.size());
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 瓾XRȀ
+	//! c̃_ׂĎ萔ȂŏW߂ĒEoꍇ
+	//! ͂ŉłȂƕ_͐AcĂ΃tg͊JȂ̂Abort
+	//! ɉ܂ꂽK͔ՖʂȂƕȂ̂ŁAł͐Ȃ
+	//-----------------------------------------------------------------------------
+	s32 upperBound(const app::Map& map)
+	{
+		const app::MapInfo& info = *map.info;
+		const s32 rest = static_cast<s32>(map.lambda - map.lambdaCollected - info.deadLambda);
+		if (info.deadLambda > 0 || !info.liftReachable)
+			return map.score + 25 * rest + 25 * static_cast<s32>(map.lambdaCollected + rest);
+		return map.score + 25 * rest + 50 * static_cast<s32>(map.lambda);
+	}
+
+	//===================================================================================
+	//! @class StateTable
+	//! oԂ̕\BR[h͌Œ蒷ŒǋL̂
+	//! ܂ł͕ʂɊmۂAȍ~̃ZOg̓}bvgt@Cɒu
+	//! 18oCgŏɃɂ
+	//===================================================================================
+	class StateTable
+	{
+	public:
+		StateTable(u32 keySize, u64 memoryMax, const s3d::FilePath& spillDirectory);
+		~StateTable();
+
+		static u32 shardOf(u64 hash){ return static_cast<u32>(hash >> (64 - SHARD_BITS)); }
+
+		bool insert(u32 shard, const u8* record, u64& ref);
+
+		const u8* record(u64 ref) const;
+
+		u32 getRecordSize() const { return mRecordSize; }
+		u32 getKeySize() const { return mKeySize; }
+		u64 size() const;
+		u64 getSpilledBytes() const { return mSpilledBytes; }
+		bool isFailed() const { return mFailed; }
+
+	private:
+		struct Segment
+		{
+			std::unique_ptr<u8[]> memory;
+			std::unique_ptr<app::MappedFile> file;
+			s3d::FilePath path;
+			u8* data;
+		};
+
+		struct Shard
+		{
+			std::vector<u64> index;
+			std::vector<std::unique_ptr<Segment>> segments;
+			u64 num;
+		};
+
+		u8* at(const Shard& shard, u64 id) const;
+		u8* allocate(u32 shardNo, u64 id);
+		void grow(Shard& shard);
+
+	private:
+		u32 mKeySize;
+		u32 mRecordSize;
+		u64 mRecordPerSegment;
+		u64 mMemoryMax;
+		s3d::FilePath mSpillDirectory;
+
+		Shard mShards[SHARD_NUM];
+
+		std::atomic<u64> mMemoryUsed;
+		std::atomic<u64> mSpilledBytes;
+		std::atomic<bool> mFailed;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	StateTable::StateTable(u32 keySize, u64 memoryMax, const s3d::FilePath& spillDirectory)
+		: mKeySize(keySize)
+		, mRecordSize(static_cast<u32>(RECORD_KEY) + keySize)
+		, mRecordPerSegment(std::max<u64>(1, SEGMENT_BYTES / (RECORD_KEY + keySize)))
+		, mMemoryMax(memoryMax)
+		, mSpillDirectory(spillDirectory)
+		, mMemoryUsed(0)
+		, mSpilledBytes(0)
+		, mFailed(false)
+	{
+		for (auto& shard : mShards) {
+			shard.index.assign(1024, 0);
+			shard.num = 0;
+		}
+		mMemoryUsed += SHARD_NUM * 1024 * sizeof(u64);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//! ot@C͏
+	//-----------------------------------------------------------------------------
+	StateTable::~StateTable()
+	{
+		for (auto& shard : mShards) {
+			for (auto& seg : shard.segments) {
+				if (seg->file) {
+					seg->file->close();
+					app::removeFile(seg->path);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ԃo^
+	//! VԂAȍԂɂ荂XRAŒȂtrueԂAref ɎQƂ
+	//! ȍԂ͐eEE萔EXRABwŊtrueԂĂfalse
+	//!  shard 𕡐̃Xbh瓯ɐGĂ͂Ȃ
+	//-----------------------------------------------------------------------------
+	bool StateTable::insert(u32 shardNo, const u8* rec, u64& ref)
+	{
+		Shard& shard = mShards[shardNo];
+		if ((shard.num + 1) * 2 > shard.index.size()) {
+			grow(shard);
+		}
+
+		const u64 hash = load<u64>(rec + RECORD_HASH);
+		const u64 tag = hash & INDEX_TAG_MASK;
+		const size_t mask = shard.index.size() - 1;
+		for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask)
+		{
+			const u64 slot = shard.index[i];
+			if (slot == 0) {
+				const u64 id = shard.num;
+				u8* dst = allocate(shardNo, id);
+				if (!dst)
+					return false;
+
+				std::memcpy(dst, rec, mRecordSize);
+				shard.num++;
+				shard.index[i] = tag | (id + 1);
+				ref = (static_cast<u64>(shardNo) << 48) | id;
+				return true;
+			}
+
+			if ((slot & INDEX_TAG_MASK) == tag) {
+				const u64 id = (slot & INDEX_ID_MASK) - 1;
+				u8* other = at(shard, id);
+				if (std::memcmp(other + RECORD_KEY, rec + RECORD_KEY, mKeySize) != 0)
+					continue;
+
+				// Wait͎萔ɐȂ̂ŁAՖʂłoHɂăXRAႤ
+				if (load<s32>(rec + RECORD_SCORE) <= load<s32>(other + RECORD_SCORE))
+					return false;
+
+				const bool queued = load<u32>(other + RECORD_DEPTH) == load<u32>(rec + RECORD_DEPTH);
+				std::memcpy(other, rec, RECORD_KEY);
+				ref = (static_cast<u64>(shardNo) << 48) | id;
+				return !queued;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! QƂ烌R[h𓾂
+	//-----------------------------------------------------------------------------
+	const u8* StateTable::record(u64 ref) const
+	{
+		return at(mShards[ref >> 48], ref & ((1ull << 48) - 1));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o^ς݂̏Ԑ
+	//-----------------------------------------------------------------------------
+	u64 StateTable::size() const
+	{
+		u64 n = 0;
+		for (const auto& shard : mShards) {
+			n += shard.num;
+		}
+		return n;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ԍ烌R[h𓾂
+	//-----------------------------------------------------------------------------
+	u8* StateTable::at(const Shard& shard, u64 id) const
+	{
+		const Segment& seg = *shard.segments[static_cast<size_t>(id / mRecordPerSegment)];
+		return seg.data + (id % mRecordPerSegment) * mRecordSize;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! R[ḧ̗m
+	//! ZOgȂΒǉA𒴂Ă΃t@Cɒu
+	//-----------------------------------------------------------------------------
+	u8* StateTable::allocate(u32 shardNo, u64 id)
+	{
+		Shard& shard = mShards[shardNo];
+		const size_t segNo = static_cast<size_t>(id / mRecordPerSegment);
+		if (segNo == shard.segments.size())
+		{
+			const u64 bytes = mRecordPerSegment * mRecordSize;
+
+			std::unique_ptr<Segment> seg(new Segment);
+			if (mMemoryUsed + bytes <= mMemoryMax) {
+				seg->memory.reset(new(std::nothrow) u8[static_cast<size_t>(bytes)]);
+				seg->data = seg->memory.get();
+				if (seg->data) {
+					mMemoryUsed += bytes;
+				}
+			}
+			else {
+				seg->path = mSpillDirectory + s3d::Format(s3d::PyFmt, L"/exhaustive_{}_{}.tmp", shardNo, segNo);
+				seg->file.reset(new app::MappedFile);
+				seg->data = seg->file->create(seg->path, bytes) ? seg->file->data() : nullptr;
+				if (seg->data) {
+					mSpilledBytes += bytes;
+				}
+			}
+
+			if (!seg->data) {
+				mFailed = true;
+				return nullptr;
+			}
+			shard.segments.push_back(std::move(seg));
+		}
+		return at(shard, id);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! {ɂ
+	//-----------------------------------------------------------------------------
+	void StateTable::grow(Shard& shard)
+	{
+		std::vector<u64> index(shard.index.size() * 2, 0);
+		const size_t mask = index.size() - 1;
+
+		for (u64 id = 0; id < shard.num; ++id) {
+			const u64 hash = load<u64>(at(shard, id) + RECORD_HASH);
+			size_t i = static_cast<size_t>(hash) & mask;
+			while (index[i] != 0) {
+				i = (i + 1) & mask;
+			}
+			index[i] = (hash & INDEX_TAG_MASK) | (id + 1);
+		}
+
+		mMemoryUsed += shard.index.size() * sizeof(u64);
+		shard.index.swap(index);
+	}
+
+	//===================================================================================
+	//! @struct Best
+	//! ŗǂ̏IBparent ̏Ԃ cmd sA܂ĂAbort
+	//===================================================================================
+	struct Best
+	{
+		s32 score;
+		u64 parent;
+		s3d::wchar cmd;
+		bool abort;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! ̃[g𕜌
+	//-----------------------------------------------------------------------------
+	s3d::String routeOf(const StateTable& table, const Best& best)
+	{
+		s3d::String route;
+		if (best.cmd != 0) {
+			route += best.cmd;
+		}
+		for (u64 ref = best.parent; ref != NO_PARENT;) {
+			const u8* rec = table.record(ref);
+			const u8 cmd = rec[RECORD_CMD];
+			if (cmd != 0) {
+				route += static_cast<s3d::wchar>(cmd);
+			}
+			ref = load<u64>(rec + RECORD_PARENT);
+		}
+		std::reverse(route.begin(), route.end());
+
+		if (best.abort) {
+			route += app::charOfCommand(app::Command::Abort);
+		}
+		return route;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	ExhaustiveSolver::ExhaustiveSolver(u32 threadNum, u64 memoryMax)
+		: mThreadNum(threadNum)
+		, mMemoryMax(memoryMax)
+		, mSpillDirectory(L".")
+		, mOptimal(false)
+		, mStateNum(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	ExhaustiveSolver::~ExhaustiveSolver()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! 1肸wLBՖʂ́A荂XRAŒƂWJ
+	//! w̓WJ̓teBA𕪊ĕɍsAo^͕\̕Ƃɕɍs
+	//-----------------------------------------------------------------------------
+	void ExhaustiveSolver::solve(const Map& initial, SolverContext& ctx)
+	{
+		mOptimal = false;
+		mStateNum = 0;
+
+		Map root = initial;
+		std::vector<u8> key;
+		packKey(root, key);
+
+		StateTable table(static_cast<u32>(key.size()), mMemoryMax, mSpillDirectory);
+		const u32 recordSize = table.getRecordSize();
+
+		Best best = { finalScore(initial), NO_PARENT, 0, initial.condition == Condition::Playing };
+		ctx.publish(routeOf(table, best), best.score);
+
+		if (initial.condition != Condition::Playing) {
+			mOptimal = true;
+			return;
+		}
+
+		std::vector<u8> rec(recordSize);
+		const u64 rootHash = hashKey(key);
+		store(&rec[RECORD_HASH], rootHash);
+		store(&rec[RECORD_PARENT], NO_PARENT);
+		store(&rec[RECORD_STEP], root.stepCount);
+		store(&rec[RECORD_SCORE], root.score);
+		store(&rec[RECORD_DEPTH], 0u);
+		rec[RECORD_CMD] = 0;
+		std::memcpy(&rec[RECORD_KEY], key.data(), key.size());
+
+		std::vector<u64> frontier(1);
+		table.insert(StateTable::shardOf(rootHash), rec.data(), frontier[0]);
+
+		TaskPool pool(mThreadNum);
+
+		struct Chunk
+		{
+			std::vector<u8> shards[SHARD_NUM];
+			Best best;
+			u64 expanded;
+		};
+		std::vector<Chunk> chunks;
+
+		for (u32 depth = 0; !frontier.empty(); ++depth)
+		{
+			if (ctx.isCancelled() || table.isFailed())
+				return;
+
+			// Ȏw܂ł̍ŗǓ_𒴂ȂԂ͎̂Ă
+			const s32 bound = best.score;
+
+			const u32 chunkNum = static_cast<u32>(std::min<size_t>(frontier.size(), pool.size() * 4));
+			const size_t chunkSize = (frontier.size() + chunkNum - 1) / chunkNum;
+			chunks.resize(chunkNum);
+
+			pool.parallelFor(0, chunkNum, [&](u32 c) {
+				Chunk& chunk = chunks[c];
+				for (auto& out : chunk.shards) {
+					out.clear();
+				}
+				chunk.best = best;
+				chunk.expanded = 0;
+
+				Map map, child;
+				map.info = initial.info;
+				s3d::Grid<Cell> scratch;
+				std::vector<u8> childKey;
+				const u32 keySize = table.getKeySize();
+
+				const size_t last = std::min(frontier.size(), (c + 1) * chunkSize);
+				for (size_t i = c * chunkSize; i < last; ++i)
+				{
+					// w傫ƎԂ̂œrł~߂
+					if ((i & 0xFF) == 0 && ctx.isCancelled())
+						break;
+
+					const u64 ref = frontier[i];
+					const u8* src = table.record(ref);
+					const u8* p = src + RECORD_KEY;
+					unpackMap(p, p + keySize, map);
+					map.stepCount = load<u32>(src + RECORD_STEP);
+					map.score = load<s32>(src + RECORD_SCORE);
+
+					for (u32 k = 0; k < COMMAND_NUM; ++k)
+					{
+						child = map;
+						Simulator::step(COMMANDS[k], child, scratch);
+
+						// ςȂ͐eɗ̂ŒHȂ
+						// step̖߂l͕E؂ƂȂǂɔՖʂςĂfalseȂ̂ŁAՖʂŔׂ
+						packKey(child, childKey);
+						if (std::memcmp(childKey.data(), src + RECORD_KEY, keySize) == 0)
+							continue;
+						chunk.expanded++;
+
+						const s32 score = finalScore(child);
+						if (score > chunk.best.score) {
+							chunk.best.score = score;
+							chunk.best.parent = ref;
+							chunk.best.cmd = charOfCommand(COMMANDS[k]);
+							chunk.best.abort = child.condition == Condition::Playing;
+						}
+
+						if (child.condition != Condition::Playing || upperBound(child) <= bound)
+							continue;
+
+						const u64 hash = hashKey(childKey);
+
+						std::vector<u8>& out = chunk.shards[StateTable::shardOf(hash)];
+						const size_t offset = out.size();
+						out.resize(offset + recordSize);
+						u8* dst = &out[offset];
+						store(dst + RECORD_HASH, hash);
+						store(dst + RECORD_PARENT, ref);
+						store(dst + RECORD_STEP, child.stepCount);
+						store(dst + RECORD_SCORE, child.score);
+						store(dst + RECORD_DEPTH, depth + 1);
+						dst[RECORD_CMD] = static_cast<u8>(charOfCommand(COMMANDS[k]));
+						std::memcpy(dst + RECORD_KEY, childKey.data(), childKey.size());
+					}
+				}
+			});
+
+			if (ctx.isCancelled())
+				return;
+
+			u64 expanded = 0;
+			for (const auto& chunk : chunks) {
+				expanded += chunk.expanded;
+				if (chunk.best.score > best.score) {
+					best = chunk.best;
+				}
+			}
+			ctx.addNodeNum(expanded);
+			if (best.score > ctx.getBestScore()) {
+				ctx.publish(routeOf(table, best), best.score);
+			}
+
+			// Ƃɓo^AVԂƃXRAオԂ̑wɂ
+			std::vector<u64> next[SHARD_NUM];
+			pool.parallelFor(0, SHARD_NUM, [&](u32 s) {
+				u32 count = 0;
+				for (const auto& chunk : chunks) {
+					const std::vector<u8>& in = chunk.shards[s];
+					for (size_t offset = 0; offset < in.size(); offset += recordSize) {
+						// o܂Ɠo^̂œrł~߂
+						if ((++count & 0xFF) == 0 && ctx.isCancelled())
+							return;
+
+						u64 ref;
+						if (table.insert(s, &in[offset], ref)) {
+							next[s].push_back(ref);
+						}
+					}
+				}
+			});
+
+			if (ctx.isCancelled())
+				return;
+
+			frontier.clear();
+			for (const auto& refs : next) {
+				frontier.insert(frontier.end(), refs.begin(), refs.end());
+			}
+			mStateNum = table.size();
+
+			if (mReportCallback) {
+				mReportCallback(depth + 1, frontier.size(), mStateNum, table.getSpilledBytes());
+			}
+		}
+
+		mOptimal = !table.isFailed();
+	}
+
+}
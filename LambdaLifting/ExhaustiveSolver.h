@@ -0,0 +1,48 @@
+//
+// Exhaustive Solver
+//
+
+#pragma once
+
+#include "Solver.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class ExhaustiveSolver
+	//! ԋԂ𕝗DłׂĒׁAœKȃXRAƃ[g߂
+	//! }bvŃq[XeBbNȃ\o[̐ƂĎg
+	//! oԂ̕\𒴂Aȍ~̓}bvgt@Cɏo
+	//===================================================================================
+	class ExhaustiveSolver : public Solver
+	{
+	public:
+		using ReportCallback = std::function<void(u32 depth, u64 frontierNum, u64 stateNum, u64 spilledBytes)>;
+
+		explicit ExhaustiveSolver(u32 threadNum = 0, u64 memoryMax = 1ull << 30);
+		~ExhaustiveSolver();
+
+		const s3d::wchar* getName() const override { return L"exhaustive"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		void setSpillDirectory(const s3d::FilePath& dir){ mSpillDirectory = dir; }
+		void setReportCallback(const ReportCallback& callback){ mReportCallback = callback; }
+
+		//! TsčœKm肵
+		bool isOptimal() const { return mOptimal; }
+		u64 getStateNum() const { return mStateNum; }
+
+	private:
+		u32 mThreadNum;
+		u64 mMemoryMax;
+		s3d::FilePath mSpillDirectory;
+
+		bool mOptimal;
+		u64 mStateNum;
+
+		ReportCallback mReportCallback;
+	};
+
+}
@@ -0,0 +1,109 @@
+//
+// File Utility
+//
+
+#include "stdafx.h"
+#include "FileUtil.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace app
+{
+
+#ifdef _WIN32
+
+	//-----------------------------------------------------------------------------
+	//! t@C̃TCYƍXV擾
+	//-----------------------------------------------------------------------------
+	bool statFile(const s3d::FilePath& filepath, FileStat& stat)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!::GetFileAttributesExW(filepath.c_str(), GetFileExInfoStandard, &data))
+			return false;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			return false;
+
+		stat.size = (static_cast<u64>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+		stat.writeTime = (static_cast<u64>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@Cu
+	//! oς݂̈ꎞt@Cl[̂ŁArŗĂꂽt@C͎cȂ
+	//-----------------------------------------------------------------------------
+	bool replaceFile(const s3d::FilePath& from, const s3d::FilePath& to)
+	{
+		return ::MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@C폜
+	//-----------------------------------------------------------------------------
+	bool removeFile(const s3d::FilePath& filepath)
+	{
+		return ::DeleteFileW(filepath.c_str()) != FALSE;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@CJ
+	//-----------------------------------------------------------------------------
+	std::FILE* openFile(const s3d::FilePath& filepath, const s3d::wchar* mode)
+	{
+		return ::_wfopen(filepath.c_str(), mode);
+	}
+
+#else
+
+	//-----------------------------------------------------------------------------
+	//! t@C̃TCYƍXV擾
+	//-----------------------------------------------------------------------------
+	bool statFile(const s3d::FilePath& filepath, FileStat& stat)
+	{
+		struct ::stat st;
+		if (::stat(filepath.narrow().c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+			return false;
+
+		stat.size = static_cast<u64>(st.st_size);
+		stat.writeTime = static_cast<u64>(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@Cu
+	//! oς݂̈ꎞt@Cl[̂ŁArŗĂꂽt@C͎cȂ
+	//-----------------------------------------------------------------------------
+	bool replaceFile(const s3d::FilePath& from, const s3d::FilePath& to)
+	{
+		return std::rename(from.narrow().c_str(), to.narrow().c_str()) == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@C폜
+	//-----------------------------------------------------------------------------
+	bool removeFile(const s3d::FilePath& filepath)
+	{
+		return ::unlink(filepath.narrow().c_str()) == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@CJ
+	//-----------------------------------------------------------------------------
+	std::FILE* openFile(const s3d::FilePath& filepath, const s3d::wchar* mode)
+	{
+		return std::fopen(filepath.narrow().c_str(), s3d::String(mode).narrow().c_str());
+	}
+
+#endif
+
+}
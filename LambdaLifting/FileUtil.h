@@ -0,0 +1,29 @@
+//
+// File Utility
+//
+
+#pragma once
+
+#include <cstdio>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct FileStat
+	//===================================================================================
+	struct FileStat
+	{
+		u64 size;
+		u64 writeTime;
+	};
+
+	bool statFile(const s3d::FilePath& filepath, FileStat& stat);
+
+	bool replaceFile(const s3d::FilePath& from, const s3d::FilePath& to);
+
+	bool removeFile(const s3d::FilePath& filepath);
+
+	std::FILE* openFile(const s3d::FilePath& filepath, const s3d::wchar* mode);
+
+}
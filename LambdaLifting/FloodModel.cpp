@@ -0,0 +1,87 @@
+//
+// Flood Model
+//
+
+#include "stdafx.h"
+#include "FloodModel.h"
+
+#include "Map.h"
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	FloodModel::FloodModel(const Map& map)
+		: mHeight(map.cell.height)
+		, mWater(map.water)
+		, mFlooding(map.info->flooding)
+		, mFloodingCount(map.floodingCount)
+		, mWaterproof(map.info->waterproof)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t Xebv̐
+	//! Simulator::updateFlooding ƓAJE^0̃Xebv1オ
+	//! オ̂ floodingCount + 1 XebvځAȍ~ flooding Xebv
+	//-----------------------------------------------------------------------------
+	u32 FloodModel::waterAt(u32 t) const
+	{
+		if (mFlooding == 0 || t <= mFloodingCount)
+			return mWater;
+
+		const u32 rise = (t - mFloodingCount - 1) / mFlooding + 1;
+		return std::min(mWater + rise, static_cast<u32>(mHeight));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! s y ߂ĐvXebv
+	//! ɐvĂ0AvȂ NEVER
+	//-----------------------------------------------------------------------------
+	u32 FloodModel::submergeStep(s32 y) const
+	{
+		if (y < 0 || y >= mHeight)
+			return NEVER;
+
+		const u32 need = static_cast<u32>(mHeight - y);
+		if (mWater >= need)
+			return 0;
+		if (mFlooding == 0)
+			return NEVER;
+
+		const u64 t = static_cast<u64>(mFloodingCount) + 1 + static_cast<u64>(need - mWater - 1) * mFlooding;
+		return t < NEVER ? static_cast<u32>(t) : NEVER;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! s y ɋĂ悢Ō̃Xebv
+	//! v钼O܂Ŗh^ꍇBvȂ NEVER
+	//! ̃Xebvs y ȉŏIƓM
+	//-----------------------------------------------------------------------------
+	u32 FloodModel::deadline(s32 y) const
+	{
+		const u32 s = submergeStep(y);
+		if (s == NEVER)
+			return NEVER;
+
+		const u64 t = static_cast<u64>(s) + mWaterproof;
+		if (t == 0)
+			return 0;
+		return t - 1 < NEVER ? static_cast<u32>(t - 1) : NEVER;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! s y Ŏc̖h air ̎AMOɐɏo\邩
+	//! ǂ𖳎ĖXebv1sꍇl
+	//! ʂ1XebvɍX1オȂ̂ŁAxɏoΈȍ~o
+	//! čŌɊԂɍXebv air + 1 ׂ΂悢
+	//-----------------------------------------------------------------------------
+	bool FloodModel::canSurface(s32 y, u32 air) const
+	{
+		const u32 t = air + 1;
+		return y - static_cast<s32>(t) < mHeight - static_cast<s32>(waterAt(t));
+	}
+
+}
@@ -0,0 +1,46 @@
+//
+// Flood Model
+//
+
+#pragma once
+
+#include <climits>
+
+namespace app
+{
+
+	// Forward declaration
+	struct Map;
+
+	//===================================================================================
+	//! @class FloodModel
+	//! ʂ͎ԂŌ܂̂ŁAՖʂ t Xebv̐ʂ O(1) ŋ߂
+	//! t ͔Ֆʂ̎_̃XebvŁAt Xebvڂ̍XV̒lԂ
+	//===================================================================================
+	class FloodModel
+	{
+	public:
+		static const u32 NEVER = UINT_MAX;
+
+		explicit FloodModel(const Map& map);
+
+		u32 waterAt(u32 t) const;
+
+		bool isUnderwater(s32 y, u32 t) const { return mHeight - static_cast<s32>(waterAt(t)) <= y; }
+
+		u32 submergeStep(s32 y) const;
+		u32 deadline(s32 y) const;
+
+		bool canSurface(s32 y, u32 air) const;
+
+		bool isFlooding() const { return mFlooding > 0; }
+
+	private:
+		s32 mHeight;
+		u32 mWater;
+		u32 mFlooding;
+		u32 mFloodingCount;
+		u32 mWaterproof;
+	};
+
+}
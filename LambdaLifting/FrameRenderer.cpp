@@ -0,0 +1,419 @@
+//
+// Frame Renderer
+//
+
+#include "stdafx.h"
+#include "FrameRenderer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <io.h>
+#include <Windows.h>
+
+#include "Simulator.h"
+#include "TaskPool.h"
+
+namespace {
+
+	// PNGɏoہAxɕێt[̏
+	static const u64 FRAME_BUDGET = 256 * 1024 * 1024;
+
+	//-----------------------------------------------------------------------------
+	//! At@uh
+	//-----------------------------------------------------------------------------
+	inline void blendAlpha(s3d::Color& dst, const s3d::Color& src)
+	{
+		const u32 a = src.a, ia = 255 - a;
+		dst.r = static_cast<u8>((src.r * a + dst.r * ia + 127) / 255);
+		dst.g = static_cast<u8>((src.g * a + dst.g * ia + 127) / 255);
+		dst.b = static_cast<u8>((src.b * a + dst.b * ia + 127) / 255);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Zuh
+	//-----------------------------------------------------------------------------
+	inline void blendAdditive(s3d::Color& dst, const s3d::Color& src)
+	{
+		const u32 a = src.a;
+		dst.r = static_cast<u8>(std::min(255u, dst.r + (src.r * a + 127) / 255));
+		dst.g = static_cast<u8>(std::min(255u, dst.g + (src.g * a + 127) / 255));
+		dst.b = static_cast<u8>(std::min(255u, dst.b + (src.b * a + 127) / 255));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ƃ̋2
+	//-----------------------------------------------------------------------------
+	inline f64 distanceSq(f64 px, f64 py, f64 ax, f64 ay, f64 bx, f64 by)
+	{
+		const f64 dx = bx - ax, dy = by - ay;
+		const f64 len = dx * dx + dy * dy;
+		f64 t = len > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / len : 0.0;
+		t = std::max(0.0, std::min(1.0, t));
+		const f64 qx = ax + dx * t - px, qy = ay + dy * t - py;
+		return qx * qx + qy * qy;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `
+	//! s3d::Line::drawArrow ƓAI_ɒ headLengthE headWidth ̎Op`u
+	//-----------------------------------------------------------------------------
+	void drawArrow(s3d::Image& image, f64 x0, f64 y0, f64 x1, f64 y1, f64 thickness, f64 headWidth, f64 headLength, const s3d::Color& color)
+	{
+		const f64 dx = x1 - x0, dy = y1 - y0;
+		const f64 len = std::sqrt(dx * dx + dy * dy);
+		if (len <= 0.0)
+			return;
+
+		const f64 ux = dx / len, uy = dy / len;
+		const f64 head = std::min(headLength, len);
+		const f64 bx = x1 - ux * head, by = y1 - uy * head;
+		const f64 r = thickness * 0.5;
+		const f64 margin = std::max(r, headWidth * 0.5) + 1.0;
+
+		const s32 left = std::max(0, static_cast<s32>(std::floor(std::min(x0, x1) - margin)));
+		const s32 top = std::max(0, static_cast<s32>(std::floor(std::min(y0, y1) - margin)));
+		const s32 right = std::min(static_cast<s32>(image.width) - 1, static_cast<s32>(std::ceil(std::max(x0, x1) + margin)));
+		const s32 bottom = std::min(static_cast<s32>(image.height) - 1, static_cast<s32>(std::ceil(std::max(y0, y1) + margin)));
+
+		for (s32 y = top; y <= bottom; ++y) {
+			for (s32 x = left; x <= right; ++x) {
+				const f64 px = x + 0.5, py = y + 0.5;
+
+				bool inside = distanceSq(px, py, x0, y0, bx, by) <= r * r;
+				if (!inside) {
+					// Op`̓
+					const f64 along = (px - bx) * ux + (py - by) * uy;
+					const f64 across = std::abs((px - bx) * -uy + (py - by) * ux);
+					inside = along >= 0.0 && along <= head && across <= headWidth * 0.5 * (1.0 - along / head);
+				}
+
+				if (inside) {
+					blendAdditive(image[y][x], color);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `
+	//-----------------------------------------------------------------------------
+	s3d::Color lerpColor(const s3d::Color& a, const s3d::Color& b, f64 t)
+	{
+		return s3d::Color(
+			static_cast<u32>(a.r + (b.r - a.r) * t),
+			static_cast<u32>(a.g + (b.g - a.g) * t),
+			static_cast<u32>(a.b + (b.b - a.b) * t),
+			static_cast<u32>(a.a + (b.a - a.a) * t));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! RGBAŏo
+	//-----------------------------------------------------------------------------
+	bool writeRaw(std::FILE* fp, const s3d::Image& frame)
+	{
+		const size_t size = static_cast<size_t>(frame.width) * frame.height;
+		return std::fwrite(frame[0], sizeof(s3d::Color), size, fp) == size;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+#pragma region FrameRenderer
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	FrameRenderer::FrameRenderer()
+		: mScale(1)
+		, mBackground(s3d::Palette::Black)
+		, mShownWater(0)
+		, mShownCondition(Condition::Playing)
+		, mRedrawAll(true)
+		, mDirtyNum(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	FrameRenderer::~FrameRenderer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XvCgǂݍ
+	//-----------------------------------------------------------------------------
+	bool FrameRenderer::loadAtlas(const s3d::FilePath& filepath)
+	{
+		mAtlas = s3d::Image(filepath);
+		mRedrawAll = true;
+		return !mAtlas.isEmpty();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `
+	//! Z͓̉摜ɍŕ`AOՂ͂̕ɏd˂
+	//-----------------------------------------------------------------------------
+	void FrameRenderer::render(const Map& map, const std::vector<int2>& trail, s32 trailLength, s3d::Image& frame)
+	{
+		const u32 w = getFrameWidth(map), h = getFrameHeight(map);
+		if (mBase.width != w || mBase.height != h) {
+			mBase = s3d::Image(w, h, mBackground);
+			mRedrawAll = true;
+		}
+
+		for (u32 y = 0; y < map.cell.height; ++y)
+		{
+			const bool flooded = map.cell.height - static_cast<s32>(map.water) <= static_cast<s32>(y);
+			const bool wasFlooded = map.cell.height - static_cast<s32>(mShownWater) <= static_cast<s32>(y);
+
+			for (u32 x = 0; x < map.cell.width; ++x)
+			{
+				const Cell c = map.cell[y][x];
+				const bool dirty = mRedrawAll || flooded != wasFlooded ||
+					mShownCells[y][x] != c ||
+					(c == Cell::Robot && map.condition != mShownCondition);
+
+				if (dirty) {
+					drawCell(map, x, y);
+					mDirtyNum++;
+				}
+			}
+		}
+
+		mShownCells = map.cell;
+		mShownWater = map.water;
+		mShownCondition = map.condition;
+		mRedrawAll = false;
+
+		frame = mBase;
+		drawTrail(trail, trailLength, frame);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Z`
+	//-----------------------------------------------------------------------------
+	void FrameRenderer::drawCell(const Map& map, u32 x, u32 y)
+	{
+		const u32 sz = CELL_SIZE * mScale;
+		for (u32 j = 0; j < sz; ++j) {
+			s3d::Color* row = mBase[y * sz + j] + x * sz;
+			for (u32 i = 0; i < sz; ++i) {
+				row[i] = mBackground;
+			}
+		}
+
+		const Cell lc = map.cell[y][x];
+		const Cell c = cellType(lc);
+
+		switch (c) {
+		case Cell::Empty:
+			break;
+
+		case Cell::Robot:
+			if (map.robotPos == map.info->liftPos) {
+				drawSprite(static_cast<u32>(Cell::OpenLift), 0, x, y);
+			}
+			drawSprite(static_cast<u32>(map.condition), 1, x, y);
+			break;
+
+		default:
+			drawSprite(static_cast<u32>(c), 0, x, y);
+
+			if (c == Cell::Trampoline) {
+				const u8 label = cellLabel(lc);
+				drawSprite(label, 2, x, y);
+				drawSprite(map.info->jump[label], 3, x, y);
+			} else if (c == Cell::Target) {
+				drawSprite(cellLabel(lc), 3, x, y);
+			}
+			break;
+		}
+
+		// 
+		if (map.cell.height - static_cast<s32>(map.water) <= static_cast<s32>(y)) {
+			s3d::Color waterColor{ s3d::Palette::Blue };
+			waterColor.a = 96;
+			for (u32 j = 0; j < sz; ++j) {
+				s3d::Color* row = mBase[y * sz + j] + x * sz;
+				for (u32 i = 0; i < sz; ++i) {
+					blendAlpha(row[i], waterColor);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XvCg`
+	//! |CgTvOŊg傷
+	//-----------------------------------------------------------------------------
+	void FrameRenderer::drawSprite(u32 column, u32 row, u32 x, u32 y)
+	{
+		const u32 sx = column * CELL_SIZE, sy = row * CELL_SIZE;
+		if (sx + CELL_SIZE > mAtlas.width || sy + CELL_SIZE > mAtlas.height)
+			return;
+
+		const u32 sz = CELL_SIZE * mScale;
+		for (u32 j = 0; j < sz; ++j) {
+			const s3d::Color* src = mAtlas[sy + j / mScale] + sx;
+			s3d::Color* dst = mBase[y * sz + j] + x * sz;
+			for (u32 i = 0; i < sz; ++i) {
+				const s3d::Color& s = src[i / mScale];
+				if (s.a == 255) {
+					dst[i] = s;
+				} else if (s.a != 0) {
+					blendAlpha(dst[i], s);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! OՂ`
+	//! Simulator::drawTrail ƓVɐԂ物FցAZŕ`
+	//-----------------------------------------------------------------------------
+	void FrameRenderer::drawTrail(const std::vector<int2>& trail, s32 length, s3d::Image& frame) const
+	{
+		if (trail.size() < 2 || length == 0)
+			return;
+
+		const s32 num = static_cast<s32>(trail.size()) - 1;
+		length = length < 0 ? num : std::min(length, num);
+
+		const f64 cell = static_cast<f64>(CELL_SIZE * mScale);
+		const f64 half = cell * 0.5;
+
+		for (s32 i = 0; i < length; ++i) {
+			const int2& pos1 = trail[num - i];
+			const int2& pos2 = trail[num - 1 - i];
+
+			const f64 t = static_cast<f64>(i) / length;
+			s3d::Color color{ lerpColor(s3d::Palette::Red, s3d::Palette::Yellow, t) };
+			color.a = static_cast<u8>(255 * (1.0 + (0.5 - 1.0) * t));
+
+			drawArrow(frame,
+				half + pos2.x * cell, half + pos2.y * cell,
+				half + pos1.x * cell, half + pos1.y * cell,
+				2.0 * mScale, 8.0 * mScale, 16.0 * mScale, color);
+		}
+	}
+
+#pragma endregion
+
+
+	//-----------------------------------------------------------------------------
+	//! vCAPNGRGBAXg[ɏo
+	//! output  "-" gq .rgba ȂRGBAXg[AȊOPNGufBNg
+	//-----------------------------------------------------------------------------
+	bool renderReplay(const s3d::FilePath& mapPath, const s3d::String& cmds, const s3d::FilePath& output,
+		const RenderSettings& settings, RenderResult& result)
+	{
+		const s3d::Stopwatch stopwatch(true);
+
+		MapInfo mapInfo;
+		Map map;
+		map.info = &mapInfo;
+		if (!Simulator::loadMap(mapPath, mapInfo, map))
+			return false;
+
+		FrameRenderer renderer;
+		if (!renderer.loadAtlas())
+			return false;
+		renderer.setScale(settings.scale);
+
+		result.width = renderer.getFrameWidth(map);
+		result.height = renderer.getFrameHeight(map);
+		result.frameNum = 0;
+
+		const bool raw = output == L"-" || s3d::FileSystem::Extension(output).lowercased() == L"rgba";
+
+		std::FILE* fp = nullptr;
+		if (raw) {
+			if (output == L"-") {
+				// eLXg[ĥ܂܂ƉsoCgϊĉ
+				std::fflush(stdout);
+				::_setmode(::_fileno(stdout), _O_BINARY);
+				fp = stdout;
+			} else {
+				fp = ::_wfopen(output.c_str(), L"wb");
+			}
+			if (!fp)
+				return false;
+		} else {
+			::CreateDirectoryW(output.c_str(), nullptr);
+		}
+
+		TaskPool pool(settings.threadNum);
+		const u64 frameSize = static_cast<u64>(result.width) * result.height * sizeof(s3d::Color);
+		const size_t batchMax = static_cast<size_t>(std::max<u64>(1, std::min<u64>(pool.size() * 4, FRAME_BUDGET / std::max<u64>(1, frameSize))));
+
+		std::vector<s3d::Image> frames(batchMax);
+		size_t batchNum = 0;
+		u32 batchBase = 0;
+		std::atomic<bool> failed(false);
+
+		// ܂t[ɃGR[h
+		const auto flushBatch = [&]() {
+			for (size_t i = 0; i < batchNum; ++i) {
+				pool.submit([&, i]{
+					const s3d::FilePath path = s3d::Format(s3d::PyFmt, L"{}/frame_{:06d}.png", output, batchBase + i);
+					if (!frames[i].savePNG(path))
+						failed = true;
+				});
+			}
+			pool.wait();
+			batchBase += static_cast<u32>(batchNum);
+			batchNum = 0;
+		};
+
+		std::vector<int2> trail(1, map.robotPos);
+		size_t pos = 0;
+		for (;;)
+		{
+			s3d::Image& frame = frames[batchNum];
+			renderer.render(map, trail, settings.trailLength, frame);
+			result.frameNum++;
+
+			if (raw) {
+				if (!writeRaw(fp, frame)) {
+					failed = true;
+					break;
+				}
+			} else if (++batchNum == frames.size()) {
+				flushBatch();
+			}
+
+			// Ֆʂς܂Ői߂
+			bool changed = false;
+			while (!changed && pos < cmds.length && map.condition == Condition::Playing) {
+				const Command cmd = commandOfChar(cmds[pos++]);
+				if (cmd != Command::None) {
+					changed = Simulator::step(cmd, map);
+				}
+			}
+			if (!changed)
+				break;
+
+			trail.push_back(map.robotPos);
+		}
+
+		if (raw) {
+			if (fp != stdout) {
+				std::fclose(fp);
+			} else {
+				std::fflush(fp);
+			}
+		} else if (batchNum > 0) {
+			flushBatch();
+		}
+
+		result.dirtyNum = renderer.getDirtyNum();
+		result.time = stopwatch.ms();
+		return !failed;
+	}
+
+}
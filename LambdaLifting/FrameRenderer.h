@@ -0,0 +1,81 @@
+//
+// Frame Renderer
+//
+
+#pragma once
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class FrameRenderer
+	//! Simulator::draw ƓڂCPUŕ`悷
+	//! Ot[ωZ`
+	//===================================================================================
+	class FrameRenderer
+	{
+	public:
+		FrameRenderer();
+		~FrameRenderer();
+
+		bool loadAtlas(const s3d::FilePath& filepath = L"assets\\cell.png");
+
+		void setScale(u32 scale){ mScale = std::max(1u, scale); mRedrawAll = true; }
+		void setBackground(const s3d::Color& color){ mBackground = color; mRedrawAll = true; }
+
+		void render(const Map& map, const std::vector<int2>& trail, s32 trailLength, s3d::Image& frame);
+
+		u32 getFrameWidth(const Map& map) const { return CELL_SIZE * mScale * map.cell.width; }
+		u32 getFrameHeight(const Map& map) const { return CELL_SIZE * mScale * map.cell.height; }
+		u64 getDirtyNum() const { return mDirtyNum; }
+
+	private:
+		void drawCell(const Map& map, u32 x, u32 y);
+		void drawSprite(u32 column, u32 row, u32 x, u32 y);
+		void drawTrail(const std::vector<int2>& trail, s32 length, s3d::Image& frame) const;
+
+	private:
+		static const u32 CELL_SIZE = 32;
+
+		s3d::Image mAtlas;
+		s3d::Image mBase;
+		u32 mScale;
+		s3d::Color mBackground;
+
+		s3d::Grid<Cell> mShownCells;
+		u32 mShownWater;
+		Condition mShownCondition;
+		bool mRedrawAll;
+		u64 mDirtyNum;
+	};
+
+	//===================================================================================
+	//! @struct RenderSettings
+	//===================================================================================
+	struct RenderSettings
+	{
+		u32 scale;
+		s32 trailLength;	// -1őS
+		u32 threadNum;		// 0ŃRA
+
+		RenderSettings() : scale(1), trailLength(32), threadNum(0) {}
+	};
+
+	//===================================================================================
+	//! @struct RenderResult
+	//===================================================================================
+	struct RenderResult
+	{
+		u32 width;
+		u32 height;
+		u32 frameNum;
+		u64 dirtyNum;
+		f64 time;	// [ms]
+	};
+
+	bool renderReplay(const s3d::FilePath& mapPath, const s3d::String& cmds, const s3d::FilePath& output,
+		const RenderSettings& settings, RenderResult& result);
+
+}
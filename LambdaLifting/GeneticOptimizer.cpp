@@ -0,0 +1,325 @@
+//
+// Genetic Optimizer
+//
+
+#include "stdafx.h"
+#include "GeneticOptimizer.h"
+
+#include <chrono>
+
+#include "TaskPool.h"
+#include "PrefixCache.h"
+
+namespace {
+
+	// ̐ɂ̂܂܎c
+	static const u32 ELITE_RATE = 10;
+
+	static const u32 TOURNAMENT_SIZE = 3;
+	static const u32 CROSSOVER_RATE = 20;
+
+	// }A폜Ԃ̍ő咷
+	static const u32 SEGMENT_MAX = 8;
+
+	// ō_ɎcR}hBȏ͐L΂Ă]dȂ邾
+	static const u32 TAIL_MAX = 32;
+
+	//-----------------------------------------------------------------------------
+	//! xorshift64
+	//-----------------------------------------------------------------------------
+	inline u64 nextRandom(u64& x)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	GeneticOptimizer::GeneticOptimizer(u32 threadNum, size_t cacheMax)
+		: mThreadNum(threadNum)
+		, mCacheMax(cacheMax)
+		, mPopulation(200)
+		, mLengthMax(0)
+		, mGeneration(0)
+		, mRandom(0x9E3779B97F4A7C15ull)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	GeneticOptimizer::~GeneticOptimizer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! WčɂȂ郋[gǉ
+	//! R}hȊÔ͎̕āAAbortȍ~͓ǂ܂Ȃ
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::addSeed(const s3d::String& route)
+	{
+		s3d::String seed;
+		for (auto c : route) {
+			const Command cmd = commandOfChar(c);
+			if (cmd == Command::Abort)
+				break;
+			if (cmd != Command::None) {
+				seed += charOfCommand(cmd);
+			}
+		}
+		mSeeds.push_back(seed);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! z͌ĂяõXbhōsA] TaskPool ŕɍs
+	//! ]̂̓[g̎ɕAe͈͂[J[Ƃ̃LbVŕ]
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::solve(const Map& initial, SolverContext& ctx)
+	{
+		mGeneration = 0;
+
+		mCommands = L"UDLRW";
+		if (initial.razor > 0 || initial.beard > 0) {
+			mCommands += charOfCommand(Command::Shave);
+		}
+
+		// [gیȂLтȂ悤ɂ
+		mLengthMax = initial.cell.width * initial.cell.height * 2;
+		for (const auto& seed : mSeeds) {
+			mLengthMax = std::max<u32>(mLengthMax, seed.length * 2);
+		}
+
+		const s3d::Array<s3d::String> seeds = mSeeds.empty() ? s3d::Array<s3d::String>(1) : mSeeds;
+
+		std::vector<Individual> population(mPopulation);
+		for (u32 i = 0; i < mPopulation; ++i) {
+			Individual& ind = population[i];
+			ind.route = seeds[i % seeds.size()];
+			ind.evaluated = false;
+			if (i >= seeds.size()) {
+				mutate(ind);
+			}
+		}
+
+		TaskPool pool(mThreadNum);
+
+		// ŋ߂͈͖͂قړLbVɍŝŁAe̕]ō؂H
+		std::vector<std::unique_ptr<PrefixCache>> caches(pool.size());
+		for (auto& cache : caches) {
+			cache.reset(new PrefixCache(initial, mCacheMax / caches.size()));
+		}
+
+		std::vector<u32> order;
+		std::vector<Individual> children;
+		auto lastReport = std::chrono::steady_clock::now();
+		for (;;)
+		{
+			order.clear();
+			for (u32 i = 0; i < population.size(); ++i) {
+				if (!population[i].evaluated) {
+					order.push_back(i);
+				}
+			}
+			std::sort(order.begin(), order.end(), [&](u32 a, u32 b) { return population[a].route < population[b].route; });
+
+			const u32 cacheNum = static_cast<u32>(caches.size());
+			pool.parallelFor(0, cacheNum, [&](u32 c) {
+				const size_t begin = order.size() * c / cacheNum;
+				const size_t end = order.size() * (c + 1) / cacheNum;
+				for (size_t k = begin; k < end; ++k) {
+					evaluate(population[order[k]], *caches[c]);
+				}
+			});
+
+			// _ȂZ[gD悷
+			std::stable_sort(population.begin(), population.end(), [](const Individual& a, const Individual& b) {
+				return a.score != b.score ? a.score > b.score : a.bestLength < b.bestLength;
+			});
+
+			const Individual& best = population.front();
+			if (best.score > ctx.getBestScore()) {
+				s3d::String route{ best.route.substr(0, best.bestLength) };
+				if (best.bestAbort) {
+					route += charOfCommand(Command::Abort);
+				}
+				ctx.publish(route, best.score);
+			}
+
+			mGeneration++;
+
+			const auto now = std::chrono::steady_clock::now();
+			if (mReportCallback && now - lastReport >= std::chrono::seconds(1)) {
+				lastReport = now;
+
+				u64 simulatedSteps = 0, reusedSteps = 0;
+				size_t cacheBytes = 0;
+				for (const auto& cache : caches) {
+					const PrefixCache::Stats& stats = cache->getStats();
+					simulatedSteps += stats.stepNum;
+					reusedSteps += stats.hitNum;
+					cacheBytes += stats.bytes;
+				}
+				mReportCallback(mGeneration, simulatedSteps, reusedSteps, cacheBytes);
+			}
+
+			if (ctx.isCancelled())
+				break;
+
+			breed(population, children);
+			population.swap(children);
+		}
+
+		for (const auto& cache : caches) {
+			ctx.addNodeNum(cache->getStats().stepNum);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! KxvZ
+	//! r̍ō_XRAƂA̎_őł؂[gƂ
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::evaluate(Individual& ind, PrefixCache& cache)
+	{
+		Map map;
+		PrefixCache::Peak peak;
+		const u32 pos = cache.evaluate(ind.route, map, peak);
+
+		ind.score = peak.score;
+		ind.bestLength = peak.length;
+		ind.bestAbort = peak.abort;
+
+		// ĨR}hƁAō_痣ꂷ͎̂Ă
+		const u32 length = std::min(pos, ind.bestLength + TAIL_MAX);
+		if (length < ind.route.length) {
+			ind.route = ind.route.substr(0, length);
+		}
+
+		ind.evaluated = true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̐
+	//! parents ̓XRA̍~ɕł邱
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::breed(const std::vector<Individual>& parents, std::vector<Individual>& children)
+	{
+		children.clear();
+		children.reserve(parents.size());
+
+		const u32 eliteNum = std::max(1u, static_cast<u32>(parents.size()) * ELITE_RATE / 100);
+		for (u32 i = 0; i < eliteNum; ++i) {
+			children.push_back(parents[i]);
+		}
+
+		while (children.size() < parents.size())
+		{
+			children.push_back(select(parents));
+			Individual& child = children.back();
+			child.evaluated = false;
+
+			if (random(100) < CROSSOVER_RATE) {
+				crossover(child, select(parents));
+			}
+
+			const u32 num = 1 + random(3);
+			for (u32 i = 0; i < num; ++i) {
+				mutate(child);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! g[igI
+	//-----------------------------------------------------------------------------
+	const GeneticOptimizer::Individual& GeneticOptimizer::select(const std::vector<Individual>& population)
+	{
+		// ~ɕł̂œYقǗǂ
+		const u32 num = static_cast<u32>(population.size());
+		u32 best = random(num);
+		for (u32 i = 1; i < TOURNAMENT_SIZE; ++i) {
+			best = std::min(best, random(num));
+		}
+		return population[best];
+	}
+
+	//-----------------------------------------------------------------------------
+	//! _
+	//! O child ̂܂܎ĉŁA̓̕LbV̖؂H
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::crossover(Individual& child, const Individual& other)
+	{
+		const u32 i = random(child.route.length + 1);
+		const u32 lo = i > SEGMENT_MAX ? i - SEGMENT_MAX : 0;
+		const u32 j = std::min<u32>(other.route.length, lo + random(SEGMENT_MAX * 2 + 1));
+
+		child.route = child.route.substr(0, i) + other.route.substr(j);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ˑRψ
+	//-----------------------------------------------------------------------------
+	void GeneticOptimizer::mutate(Individual& child)
+	{
+		s3d::String& route = child.route;
+		const u32 length = route.length;
+		const u32 pos = random(length + 1);
+
+		switch (length > 0 ? random(4) : 0) {
+		case 0:
+		{
+			// Ԃ}
+			const u32 num = 1 + random(SEGMENT_MAX);
+			s3d::String segment;
+			for (u32 i = 0; i < num; ++i) {
+				segment += randomCommand();
+			}
+			route = route.substr(0, pos) + segment + route.substr(pos);
+			break;
+		}
+		case 1:
+		case 2:
+			// u
+			if (pos == length) {
+				route += randomCommand();
+			} else {
+				route[pos] = randomCommand();
+			}
+			break;
+		default:
+			// Ԃ폜
+			route = route.substr(0, pos) + route.substr(std::min(length, pos + 1 + random(SEGMENT_MAX)));
+			break;
+		}
+
+		if (route.length > mLengthMax) {
+			route = route.substr(0, mLengthMax);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! _ȃR}h
+	//-----------------------------------------------------------------------------
+	s3d::wchar GeneticOptimizer::randomCommand()
+	{
+		return mCommands[random(mCommands.length)];
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [0, n) ̗
+	//-----------------------------------------------------------------------------
+	u32 GeneticOptimizer::random(u32 n)
+	{
+		return static_cast<u32>(nextRandom(mRandom) % n);
+	}
+
+}
@@ -0,0 +1,75 @@
+//
+// Genetic Optimizer
+//
+
+#pragma once
+
+#include "Map.h"
+#include "Solver.h"
+
+namespace app
+{
+
+	// Forward declaration
+	class PrefixCache;
+
+	//===================================================================================
+	//! @class GeneticOptimizer
+	//! ̃[gˑRψقƌŉǂ
+	//! ] PrefixCache ŐeƋʂ̐擪ȂA擪̂蒼
+	//===================================================================================
+	class GeneticOptimizer : public Solver
+	{
+	public:
+		using ReportCallback = std::function<void(u32 generation, u64 simulatedSteps, u64 reusedSteps, size_t cacheBytes)>;
+
+		explicit GeneticOptimizer(u32 threadNum = 0, size_t cacheMax = 256 << 20);
+		~GeneticOptimizer();
+
+		const s3d::wchar* getName() const override { return L"genetic"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		void addSeed(const s3d::String& route);
+		void clearSeeds(){ mSeeds.clear(); }
+
+		void setPopulation(u32 num){ mPopulation = std::max(2u, num); }
+		void setReportCallback(const ReportCallback& callback){ mReportCallback = callback; }
+
+		u32 getGeneration() const { return mGeneration; }
+
+	private:
+		struct Individual
+		{
+			s3d::String route;
+			bool evaluated;
+
+			s32 score;
+			u32 bestLength;
+			bool bestAbort;
+		};
+
+		void evaluate(Individual& ind, PrefixCache& cache);
+		void breed(const std::vector<Individual>& parents, std::vector<Individual>& children);
+		const Individual& select(const std::vector<Individual>& population);
+		void crossover(Individual& child, const Individual& other);
+		void mutate(Individual& child);
+
+		s3d::wchar randomCommand();
+		u32 random(u32 n);
+
+	private:
+		u32 mThreadNum;
+		size_t mCacheMax;
+		u32 mPopulation;
+
+		s3d::Array<s3d::String> mSeeds;
+		s3d::String mCommands;
+		u32 mLengthMax;
+		u32 mGeneration;
+		u64 mRandom;
+
+		ReportCallback mReportCallback;
+	};
+
+}
@@ -0,0 +1,35 @@
+//
+// Hash
+//
+
+#pragma once
+
+namespace app
+{
+
+	static const u64 FNV_OFFSET_BASIS	= 14695981039346656037ull;
+	static const u64 FNV_PRIME			= 1099511628211ull;
+
+	//-----------------------------------------------------------------------------
+	//! oCg̃nbV (FNV-1a)
+	//-----------------------------------------------------------------------------
+	inline u64 hashBytes(const void* data, size_t size, u64 h = FNV_OFFSET_BASIS)
+	{
+		const u8* p = static_cast<const u8*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			h ^= p[i];
+			h *= FNV_PRIME;
+		}
+		return h;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! l
+	//-----------------------------------------------------------------------------
+	template<class T>
+	inline u64 hashValue(const T& value, u64 h = FNV_OFFSET_BASIS)
+	{
+		return hashBytes(&value, sizeof(T), h);
+	}
+
+}
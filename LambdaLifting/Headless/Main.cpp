@@ -0,0 +1,23 @@
+//
+// Headless Main
+//
+// Siv3D ̃EBhEgȂR}hCł̃Gg|Cg
+//
+
+#include "stdafx.h"
+
+#include "CommandLine.h"
+
+int main(int argc, char* argv[])
+{
+	s3d::Array<s3d::String> args;
+	for (int i = 0; i < argc; ++i) {
+		args.push_back(s3d::Widen(argv[i]));
+	}
+
+	const int result = app::runCommand(args);
+
+	std::fflush(stdout);
+	std::fflush(stderr);
+	return result;
+}
@@ -0,0 +1,606 @@
+//
+// Siv3D subset for the headless build
+//
+// wbhX (LL_HEADLESS) ŃRAg Siv3D ̌^Ɗ֐WCuŎ
+// EBhEA`AAZbg͖BWindows ł͖{ Siv3D ĝŁA
+// fBNg̓wbhXł̃CN[hpXɂ
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <climits>
+
+namespace s3d
+{
+
+	using wchar = wchar_t;
+
+	template<class T>
+	using Array = std::vector<T>;
+
+	//===================================================================================
+	//! @struct None_t
+	//===================================================================================
+	struct None_t
+	{
+	};
+
+	static const None_t none = {};
+
+	//===================================================================================
+	//! @class Optional
+	//===================================================================================
+	template<class T>
+	class Optional
+	{
+	public:
+		Optional() : mHasValue(false), mValue() {}
+		Optional(None_t) : mHasValue(false), mValue() {}
+		Optional(const T& value) : mHasValue(true), mValue(value) {}
+
+		explicit operator bool() const { return mHasValue; }
+		bool has_value() const { return mHasValue; }
+
+		T& value() { return mValue; }
+		const T& value() const { return mValue; }
+
+		T& operator*() { return mValue; }
+		const T& operator*() const { return mValue; }
+		T* operator->() { return &mValue; }
+		const T* operator->() const { return &mValue; }
+
+	private:
+		bool mHasValue;
+		T mValue;
+	};
+
+	//===================================================================================
+	//! @class String
+	//! Siv3D  length  isEmpty ̓vpeBȂ̂ŁAwϊZq̃o[Ő^
+	//! o[͎w܂܂ɂ邽߁ARs[ł͎ʂȂ
+	//===================================================================================
+	class String : public std::wstring
+	{
+	public:
+		class LengthProperty
+		{
+		public:
+			explicit LengthProperty(const String* owner) : mpOwner(owner) {}
+			LengthProperty& operator=(const LengthProperty&) { return *this; }
+			operator uint32_t() const { return static_cast<uint32_t>(mpOwner->size()); }
+
+		private:
+			LengthProperty(const LengthProperty&) = delete;
+
+			const String* mpOwner;
+		};
+
+		class EmptyProperty
+		{
+		public:
+			explicit EmptyProperty(const String* owner) : mpOwner(owner) {}
+			EmptyProperty& operator=(const EmptyProperty&) { return *this; }
+			operator bool() const { return mpOwner->empty(); }
+
+		private:
+			EmptyProperty(const EmptyProperty&) = delete;
+
+			const String* mpOwner;
+		};
+
+	public:
+		String() : length(this), isEmpty(this) {}
+		String(const wchar_t* s) : std::wstring(s), length(this), isEmpty(this) {}
+		String(const wchar_t* s, size_t n) : std::wstring(s, n), length(this), isEmpty(this) {}
+		String(size_t n, wchar_t c) : std::wstring(n, c), length(this), isEmpty(this) {}
+		String(const std::wstring& s) : std::wstring(s), length(this), isEmpty(this) {}
+		String(std::wstring&& s) : std::wstring(std::move(s)), length(this), isEmpty(this) {}
+		String(const String& s) : std::wstring(s), length(this), isEmpty(this) {}
+		String(String&& s) : std::wstring(std::move(s)), length(this), isEmpty(this) {}
+
+		String& operator=(const String& s) { std::wstring::operator=(s); return *this; }
+		String& operator=(String&& s) { std::wstring::operator=(std::move(s)); return *this; }
+		String& operator=(const wchar_t* s) { std::wstring::operator=(s); return *this; }
+
+		const std::wstring& str() const { return *this; }
+
+		String substr(size_t pos = 0, size_t n = npos) const { return String(std::wstring::substr(pos, n)); }
+
+		bool startsWith(const String& s) const { return compare(0, s.size(), s) == 0; }
+
+		String lowercased() const
+		{
+			String result(*this);
+			for (auto& c : result) {
+				c = static_cast<wchar_t>(std::towlower(c));
+			}
+			return result;
+		}
+
+		Array<String> split(wchar_t separator) const
+		{
+			Array<String> result;
+			size_t begin = 0;
+			for (;;) {
+				const size_t end = find(separator, begin);
+				if (end == npos) {
+					result.push_back(substr(begin));
+					return result;
+				}
+				result.push_back(substr(begin, end - begin));
+				begin = end + 1;
+			}
+		}
+
+		//! UTF-8 ɕϊ
+		std::string narrow() const
+		{
+			std::string result;
+			result.reserve(size());
+			for (const wchar_t wc : *this) {
+				const uint32_t c = static_cast<uint32_t>(wc);
+				if (c < 0x80) {
+					result += static_cast<char>(c);
+				} else if (c < 0x800) {
+					result += static_cast<char>(0xC0 | (c >> 6));
+					result += static_cast<char>(0x80 | (c & 0x3F));
+				} else if (c < 0x10000) {
+					result += static_cast<char>(0xE0 | (c >> 12));
+					result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (c & 0x3F));
+				} else {
+					result += static_cast<char>(0xF0 | (c >> 18));
+					result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+					result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (c & 0x3F));
+				}
+			}
+			return result;
+		}
+
+	public:
+		LengthProperty length;
+		EmptyProperty isEmpty;
+	};
+
+	using FilePath = String;
+
+	//-----------------------------------------------------------------------------
+	//! UTF-8 ϊ
+	//-----------------------------------------------------------------------------
+	inline String Widen(const std::string& s)
+	{
+		String result;
+		result.reserve(s.size());
+		for (size_t i = 0; i < s.size();) {
+			const uint8_t c = static_cast<uint8_t>(s[i]);
+			const size_t n = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+			uint32_t code = n == 1 ? c : n == 2 ? (c & 0x1F) : n == 3 ? (c & 0x0F) : (c & 0x07);
+			for (size_t k = 1; k < n && i + k < s.size(); ++k) {
+				code = (code << 6) | (static_cast<uint8_t>(s[i + k]) & 0x3F);
+			}
+			result += static_cast<wchar_t>(code);
+			i += n;
+		}
+		return result;
+	}
+
+	//===================================================================================
+	//! @struct Rect
+	//===================================================================================
+	struct Rect
+	{
+		int32_t x, y, w, h;
+
+		Rect() : x(0), y(0), w(0), h(0) {}
+		Rect(int32_t _x, int32_t _y, int32_t _w, int32_t _h) : x(_x), y(_y), w(_w), h(_h) {}
+	};
+
+	//===================================================================================
+	//! @struct Vector2D
+	//===================================================================================
+	template<class Type>
+	struct Vector2D
+	{
+		Type x, y;
+
+		Vector2D() : x(0), y(0) {}
+		Vector2D(Type _x, Type _y) : x(_x), y(_y) {}
+
+		template<class U>
+		explicit Vector2D(const Vector2D<U>& v) : x(static_cast<Type>(v.x)), y(static_cast<Type>(v.y)) {}
+
+		void set(Type _x, Type _y) { x = _x; y = _y; }
+		Vector2D movedBy(Type _x, Type _y) const { return{ x + _x, y + _y }; }
+
+		bool intersects(const Rect& r) const { return r.x <= x && x < r.x + r.w && r.y <= y && y < r.y + r.h; }
+
+		bool operator==(const Vector2D& v) const { return x == v.x && y == v.y; }
+		bool operator!=(const Vector2D& v) const { return !(*this == v); }
+	};
+
+	//===================================================================================
+	//! @class Grid
+	//! sD2zBgrid[y][x] ŎQƂ
+	//===================================================================================
+	template<class Type>
+	class Grid
+	{
+	public:
+		Grid() : width(0), height(0) {}
+		Grid(int32_t w, int32_t h, const Type& value = Type()) : width(w), height(h), mData(static_cast<size_t>(w) * h, value) {}
+
+		Type* operator[](size_t y) { return mData.data() + y * width; }
+		const Type* operator[](size_t y) const { return mData.data() + y * width; }
+
+		void resize(int32_t w, int32_t h, const Type& value = Type())
+		{
+			width = w;
+			height = h;
+			mData.assign(static_cast<size_t>(w) * h, value);
+		}
+
+		void clear()
+		{
+			width = height = 0;
+			mData.clear();
+		}
+
+		Type* data() { return mData.data(); }
+		const Type* data() const { return mData.data(); }
+		size_t num_elements() const { return mData.size(); }
+
+		bool operator==(const Grid& g) const { return width == g.width && height == g.height && mData == g.mData; }
+		bool operator!=(const Grid& g) const { return !(*this == g); }
+
+	public:
+		int32_t width;
+		int32_t height;
+
+	private:
+		std::vector<Type> mData;
+	};
+
+	//===================================================================================
+	// step
+	//===================================================================================
+	template<class T>
+	class StepRange
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(T value, T delta) : mValue(value), mDelta(delta) {}
+			T operator*() const { return mValue; }
+			Iterator& operator++() { mValue += mDelta; return *this; }
+			bool operator!=(const Iterator& it) const { return mValue != it.mValue; }
+
+		private:
+			T mValue;
+			T mDelta;
+		};
+
+		StepRange(T first, T last, T delta) : mFirst(first), mLast(last), mDelta(delta) {}
+
+		Iterator begin() const { return Iterator(mFirst, mDelta); }
+		Iterator end() const { return Iterator(mLast, mDelta); }
+
+	private:
+		T mFirst;
+		T mLast;
+		T mDelta;
+	};
+
+	template<class T>
+	inline StepRange<T> step(T n) { return StepRange<T>(0, n < 0 ? 0 : n, 1); }
+
+	template<class T>
+	inline StepRange<T> step_backward(T n) { return StepRange<T>(n - 1, n <= 0 ? n - 1 : -1, -1); }
+
+	//===================================================================================
+	// Format
+	//===================================================================================
+	struct PyFmt_t
+	{
+	};
+
+	static const PyFmt_t PyFmt = {};
+
+	namespace detail
+	{
+		//===================================================================================
+		//! @class FormatArg
+		//! Format ̈𕶎AÂǂꂩƂĎ
+		//===================================================================================
+		class FormatArg
+		{
+		public:
+			FormatArg(const wchar_t* s) : mType(Type::Text), mText(s) {}
+			FormatArg(const std::wstring& s) : mType(Type::Text), mText(s) {}
+			FormatArg(wchar_t c) : mType(Type::Text), mText(1, c) {}
+			FormatArg(bool b) : mType(Type::Text), mText(b ? L"true" : L"false") {}
+			FormatArg(const String::LengthProperty& n) : mType(Type::Unsigned), mUnsigned(static_cast<uint32_t>(n)) {}
+
+			template<class T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type* = nullptr>
+			FormatArg(T n) : mType(Type::Signed), mSigned(n) {}
+
+			template<class T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type* = nullptr>
+			FormatArg(T n) : mType(Type::Unsigned), mUnsigned(n) {}
+
+			template<class T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
+			FormatArg(T f) : mType(Type::Float), mFloat(f) {}
+
+			//! spec  ':' B".Nf" ߂
+			void write(std::wstring& out, const std::wstring& spec) const
+			{
+				wchar_t buffer[64];
+				switch (mType) {
+				case Type::Text:
+					out += mText;
+					return;
+				case Type::Signed:
+					out += std::to_wstring(mSigned);
+					return;
+				case Type::Unsigned:
+					out += std::to_wstring(mUnsigned);
+					return;
+				case Type::Float:
+					if (spec.size() >= 2 && spec[0] == L'.') {
+						const int precision = std::wcstol(spec.c_str() + 1, nullptr, 10);
+						std::swprintf(buffer, 64, L"%.*f", precision, mFloat);
+					} else {
+						std::swprintf(buffer, 64, L"%g", mFloat);
+					}
+					out += buffer;
+					return;
+				}
+			}
+
+		private:
+			enum class Type { Text, Signed, Unsigned, Float };
+
+			Type mType;
+			std::wstring mText;
+			union
+			{
+				long long mSigned;
+				unsigned long long mUnsigned;
+				double mFloat;
+			};
+		};
+
+		//-----------------------------------------------------------------------------
+		//! "{}" "{0}" "{:.2f}" Œu
+		//-----------------------------------------------------------------------------
+		inline String FormatPy(const wchar_t* format, const FormatArg* args, size_t argNum)
+		{
+			std::wstring out;
+			size_t next = 0;
+			for (const wchar_t* p = format; *p; ++p) {
+				if (*p != L'{') {
+					out += *p;
+					continue;
+				}
+
+				const wchar_t* close = p + 1;
+				while (*close && *close != L'}') {
+					++close;
+				}
+				if (!*close) {
+					out += p;
+					break;
+				}
+
+				const std::wstring field(p + 1, close);
+				const size_t colon = field.find(L':');
+				const std::wstring index = field.substr(0, colon);
+				const std::wstring spec = colon == std::wstring::npos ? std::wstring() : field.substr(colon + 1);
+
+				const size_t i = index.empty() ? next++ : static_cast<size_t>(std::wcstoul(index.c_str(), nullptr, 10));
+				if (i < argNum) {
+					args[i].write(out, spec);
+				}
+				p = close;
+			}
+			return out;
+		}
+	}
+
+	template<class... Args>
+	inline String Format(PyFmt_t, const wchar_t* format, const Args&... args)
+	{
+		const detail::FormatArg list[] = { detail::FormatArg(args)..., detail::FormatArg(L"") };
+		return detail::FormatPy(format, list, sizeof...(Args));
+	}
+
+	template<class... Args>
+	inline String Format(const Args&... args)
+	{
+		const detail::FormatArg list[] = { detail::FormatArg(args)..., detail::FormatArg(L"") };
+		std::wstring out;
+		for (size_t i = 0; i < sizeof...(Args); ++i) {
+			list[i].write(out, std::wstring());
+		}
+		return out;
+	}
+
+	//===================================================================================
+	// Parse
+	//===================================================================================
+	template<class T>
+	inline T Parse(const String& s)
+	{
+		std::wistringstream is(s);
+		T value = T();
+		is >> value;
+		return value;
+	}
+
+	template<>
+	inline wchar_t Parse<wchar_t>(const String& s)
+	{
+		const size_t pos = s.find_first_not_of(L" \t\r\n");
+		return pos == String::npos ? L'\0' : s[pos];
+	}
+
+	//===================================================================================
+	//! @class TextReader
+	//! UTF-8 (BOM͗LĂĂǂ)  BOM  UTF-16LE ǂݍ
+	//===================================================================================
+	class TextReader
+	{
+	public:
+		TextReader() : mOpened(false) {}
+		explicit TextReader(const FilePath& path) : mOpened(false) { open(path); }
+
+		bool open(const FilePath& path)
+		{
+			mOpened = false;
+			mContents.clear();
+
+			std::FILE* fp = std::fopen(path.narrow().c_str(), "rb");
+			if (!fp)
+				return false;
+
+			std::string bytes;
+			char buffer[4096];
+			size_t n;
+			while ((n = std::fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+				bytes.append(buffer, n);
+			}
+			std::fclose(fp);
+
+			if (bytes.size() >= 2 && static_cast<uint8_t>(bytes[0]) == 0xFF && static_cast<uint8_t>(bytes[1]) == 0xFE) {
+				for (size_t i = 2; i + 1 < bytes.size(); i += 2) {
+					mContents += static_cast<wchar_t>(static_cast<uint8_t>(bytes[i]) | (static_cast<uint8_t>(bytes[i + 1]) << 8));
+				}
+			} else {
+				const bool bom = bytes.size() >= 3 && bytes.compare(0, 3, "\xEF\xBB\xBF") == 0;
+				mContents = Widen(bom ? bytes.substr(3) : bytes);
+			}
+
+			mOpened = true;
+			return true;
+		}
+
+		bool isOpened() const { return mOpened; }
+
+		String readContents() const { return mContents; }
+
+	private:
+		bool mOpened;
+		String mContents;
+	};
+
+	//===================================================================================
+	//! @class BinaryWriter
+	//===================================================================================
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter() : mpFile(nullptr) {}
+		explicit BinaryWriter(const FilePath& path) : mpFile(std::fopen(path.narrow().c_str(), "wb")) {}
+		~BinaryWriter() { close(); }
+
+		bool isOpened() const { return mpFile != nullptr; }
+
+		int64_t write(const void* data, size_t size)
+		{
+			return mpFile ? static_cast<int64_t>(std::fwrite(data, 1, size, mpFile)) : 0;
+		}
+
+		void close()
+		{
+			if (mpFile) {
+				std::fclose(mpFile);
+				mpFile = nullptr;
+			}
+		}
+
+	private:
+		BinaryWriter(const BinaryWriter&) = delete;
+		BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+		std::FILE* mpFile;
+	};
+
+	//===================================================================================
+	// FileSystem
+	//===================================================================================
+	namespace FileSystem
+	{
+		inline String FileName(const FilePath& path)
+		{
+			const size_t slash = path.find_last_of(L"/\\");
+			return slash == String::npos ? path : path.substr(slash + 1);
+		}
+
+		inline String BaseName(const FilePath& path)
+		{
+			const String name = FileName(path);
+			const size_t dot = name.rfind(L'.');
+			return dot == String::npos ? name : name.substr(0, dot);
+		}
+
+		inline String Extension(const FilePath& path)
+		{
+			const String name = FileName(path);
+			const size_t dot = name.rfind(L'.');
+			return dot == String::npos ? String() : name.substr(dot + 1).lowercased();
+		}
+
+		//! ݂Ȃt@CłAJgfBNg̐΃pXɂ
+		inline FilePath FullPath(const FilePath& path)
+		{
+			char resolved[PATH_MAX];
+			if (::realpath(path.narrow().c_str(), resolved))
+				return Widen(resolved);
+
+			if (!path.isEmpty && path[0] == L'/')
+				return path;
+
+			char cwd[PATH_MAX];
+			if (!::getcwd(cwd, sizeof(cwd)))
+				return path;
+			return Widen(cwd) + L"/" + path;
+		}
+
+		//! fBNg̃t@CƃfBNg̐΃pX
+		inline Array<FilePath> DirectoryContents(const FilePath& path)
+		{
+			Array<FilePath> result;
+			const FilePath directory = FullPath(path);
+
+			DIR* dir = ::opendir(directory.narrow().c_str());
+			if (!dir)
+				return result;
+
+			while (const dirent* entry = ::readdir(dir)) {
+				const std::string name = entry->d_name;
+				if (name == "." || name == "..")
+					continue;
+				result.push_back(directory + L"/" + Widen(name));
+			}
+			::closedir(dir);
+
+			std::sort(result.begin(), result.end());
+			return result;
+		}
+	}
+
+}
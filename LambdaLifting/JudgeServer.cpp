@@ -0,0 +1,436 @@
+//
+// Judge Server
+//
+
+#include "stdafx.h"
+#include "JudgeServer.h"
+
+#include <thread>
+
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+
+#include "Simulator.h"
+#include "Replay.h"
+
+namespace {
+
+	//-----------------------------------------------------------------------------
+	//! 擪̒PƎcɕ
+	//-----------------------------------------------------------------------------
+	void splitRequest(const std::string& request, std::string& name, std::string& arg)
+	{
+		const size_t begin = request.find_first_not_of(" \t");
+		if (begin == std::string::npos) {
+			name.clear();
+			arg.clear();
+			return;
+		}
+
+		const size_t end = request.find_first_of(" \t", begin);
+		name = request.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+		const size_t argBegin = end == std::string::npos ? std::string::npos : request.find_first_not_of(" \t", end);
+		arg = argBegin == std::string::npos ? std::string() : request.substr(argBegin);
+		while (!arg.empty() && (arg.back() == ' ' || arg.back() == '\t' || arg.back() == '\r')) {
+			arg.pop_back();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ԃ𕶎
+	//-----------------------------------------------------------------------------
+	void appendState(const app::Map& map, std::string& response)
+	{
+		char buf[256];
+		std::snprintf(buf, sizeof(buf), "ok score=%d condition=%s steps=%u lambdas=%u/%u robot=%d,%d water=%u waterproof=%u razor=%u beard=%u",
+			map.score, s3d::String(app::stringOfCondition(map.condition)).narrow().c_str(),
+			map.stepCount, map.lambdaCollected, map.lambda,
+			map.robotPos.x, map.robotPos.y, map.water, map.waterproofCount, map.razor, map.beard);
+		response += buf;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \Pbg1sǂݍ
+	//-----------------------------------------------------------------------------
+	bool recvLine(SOCKET s, std::string& buffer, std::string& line)
+	{
+		for (;;) {
+			const size_t pos = buffer.find('\n');
+			if (pos != std::string::npos) {
+				line = buffer.substr(0, pos);
+				buffer.erase(0, pos + 1);
+				return true;
+			}
+
+			char chunk[4096];
+			const int n = ::recv(s, chunk, sizeof(chunk), 0);
+			if (n <= 0)
+				return false;
+			buffer.append(chunk, n);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \PbgɑSď
+	//-----------------------------------------------------------------------------
+	bool sendAll(SOCKET s, const std::string& data)
+	{
+		size_t sent = 0;
+		while (sent < data.size()) {
+			const int n = ::send(s, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+			if (n <= 0)
+				return false;
+			sent += n;
+		}
+		return true;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+#pragma region StageStore
+
+	//-----------------------------------------------------------------------------
+	//! }bvǂݍ
+	//! xǂݍ񂾃}bv̓vZXI܂ŕێ
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<const Stage> StageStore::load(const s3d::FilePath& filepath)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			const auto it = mStages.find(filepath.str());
+			if (it != mStages.end())
+				return it->second;
+		}
+
+		std::shared_ptr<Stage> stage = std::make_shared<Stage>();
+		stage->map.info = &stage->mapInfo;
+		if (!Simulator::loadMap(filepath, stage->mapInfo, stage->map))
+			return nullptr;
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto result = mStages.insert(std::make_pair(filepath.str(), stage));
+		return result.first->second;
+	}
+
+#pragma endregion
+
+
+#pragma region JudgeSession
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	JudgeSession::JudgeSession(StageStore& store)
+		: mStore(store)
+		, mNextSnapshot(1)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	JudgeSession::~JudgeSession()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! NGXg
+	//! ZbVIꍇfalseԂ
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::handle(const std::string& request, std::string& response)
+	{
+		std::string name, arg;
+		splitRequest(request, name, arg);
+
+		response.clear();
+
+		if (name.empty()) {
+			return true;
+		} else if (name == "quit") {
+			response = "ok bye\n";
+			return false;
+		} else if (name == "load") {
+			load(arg, response);
+		} else if (!mpStage) {
+			response = "error no map\n";
+		} else if (name == "step") {
+			step(arg, response);
+		} else if (name == "state") {
+			state(response);
+		} else if (name == "cells") {
+			cells(response);
+		} else if (name == "snapshot") {
+			snapshot(response);
+		} else if (name == "restore") {
+			restore(arg, response);
+		} else if (name == "release") {
+			release(arg, response);
+		} else if (name == "score") {
+			score(response);
+		} else if (name == "reset") {
+			reset(response);
+		} else {
+			response = "error unknown request\n";
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! load <path>
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::load(const std::string& arg, std::string& response)
+	{
+		std::shared_ptr<const Stage> stage = mStore.load(s3d::Widen(arg));
+		if (!stage) {
+			response = "error failed to load map\n";
+			return false;
+		}
+
+		mpStage = stage;
+		mMap = mpStage->map;
+		mSnapshots.clear();
+
+		char buf[64];
+		std::snprintf(buf, sizeof(buf), "ok %u %u %u\n", static_cast<u32>(mMap.cell.width), static_cast<u32>(mMap.cell.height), mMap.lambda);
+		response = buf;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! step <commands>
+	//! ̃R}h܂Ƃ߂Ďs
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::step(const std::string& arg, std::string& response)
+	{
+		u32 count = 0;
+		for (const char c : arg) {
+			if (mMap.condition != Condition::Playing)
+				break;
+
+			const Command cmd = commandOfChar(static_cast<s3d::wchar>(c));
+			if (cmd != Command::None) {
+				Simulator::step(cmd, mMap, mScratch);
+				count++;
+			}
+		}
+
+		appendState(mMap, response);
+
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), " applied=%u\n", count);
+		response += buf;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! state
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::state(std::string& response)
+	{
+		appendState(mMap, response);
+		response += '\n';
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! cells
+	//! "ok <height>" ɑă}bvt@CƓŊesԂ
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::cells(std::string& response)
+	{
+		const u32 w = mMap.cell.width, h = mMap.cell.height;
+
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "ok %u\n", h);
+		response = buf;
+		response.reserve(response.size() + (w + 1) * h);
+
+		for (u32 y = 0; y < h; ++y) {
+			for (u32 x = 0; x < w; ++x) {
+				response += static_cast<char>(charOfCell(mMap.cell[y][x]));
+			}
+			response += '\n';
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! snapshot
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::snapshot(std::string& response)
+	{
+		const u32 id = mNextSnapshot++;
+		mSnapshots[id] = mMap;
+
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "ok %u\n", id);
+		response = buf;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! restore <id>
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::restore(const std::string& arg, std::string& response)
+	{
+		const auto it = mSnapshots.find(static_cast<u32>(std::strtoul(arg.c_str(), nullptr, 10)));
+		if (it == mSnapshots.end()) {
+			response = "error unknown snapshot\n";
+			return false;
+		}
+
+		mMap = it->second;
+		appendState(mMap, response);
+		response += '\n';
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! release <id>
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::release(const std::string& arg, std::string& response)
+	{
+		if (mSnapshots.erase(static_cast<u32>(std::strtoul(arg.c_str(), nullptr, 10))) == 0) {
+			response = "error unknown snapshot\n";
+			return false;
+		}
+		response = "ok\n";
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! score
+	//! vCȂ炻̏Abortꍇ̃XRA
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::score(std::string& response)
+	{
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "ok %d\n", finalScore(mMap));
+		response = buf;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! reset
+	//-----------------------------------------------------------------------------
+	bool JudgeSession::reset(std::string& response)
+	{
+		mMap = mpStage->map;
+		appendState(mMap, response);
+		response += '\n';
+		return true;
+	}
+
+#pragma endregion
+
+
+#pragma region JudgeServer
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	JudgeServer::JudgeServer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	JudgeServer::~JudgeServer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Wo͂1ZbV
+	//-----------------------------------------------------------------------------
+	void JudgeServer::serve(std::FILE* in, std::FILE* out)
+	{
+		JudgeSession session(mStore);
+
+		std::string line, response;
+		char buf[4096];
+		while (std::fgets(buf, sizeof(buf), in)) {
+			line += buf;
+			if (line.empty() || line.back() != '\n')
+				continue;
+
+			line.pop_back();
+			const bool alive = session.handle(line, response);
+			line.clear();
+
+			std::fwrite(response.data(), 1, response.size(), out);
+			std::fflush(out);
+
+			if (!alive)
+				break;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! UnixhC\Pbgő҂󂯂
+	//! ڑƂɃXbh𗧂āAǂݍݍς݂̃}bv͑SZbVŋL
+	//-----------------------------------------------------------------------------
+	bool JudgeServer::listen(const s3d::FilePath& socketPath)
+	{
+		WSADATA wsa;
+		if (::WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+			return false;
+
+		SOCKET server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (server == INVALID_SOCKET) {
+			::WSACleanup();
+			return false;
+		}
+
+		sockaddr_un addr = {};
+		addr.sun_family = AF_UNIX;
+		const std::string path = socketPath.narrow();
+		if (path.size() >= sizeof(addr.sun_path)) {
+			::closesocket(server);
+			::WSACleanup();
+			return false;
+		}
+		std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+		// Õ\Pbgt@CcĂΏ
+		::DeleteFileA(path.c_str());
+
+		if (::bind(server, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR ||
+			::listen(server, SOMAXCONN) == SOCKET_ERROR)
+		{
+			::closesocket(server);
+			::WSACleanup();
+			return false;
+		}
+
+		for (;;) {
+			const SOCKET client = ::accept(server, nullptr, nullptr);
+			if (client == INVALID_SOCKET)
+				break;
+
+			std::thread([this, client]{
+				JudgeSession session(mStore);
+				std::string buffer, line, response;
+				while (recvLine(client, buffer, line)) {
+					const bool alive = session.handle(line, response);
+					if (!sendAll(client, response) || !alive)
+						break;
+				}
+				::closesocket(client);
+			}).detach();
+		}
+
+		::closesocket(server);
+		::WSACleanup();
+		return true;
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,86 @@
+//
+// Judge Server
+//
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct Stage
+	//! ǂݍݍς݂̃}bvBZbVԂŋLAύXȂ
+	//===================================================================================
+	struct Stage
+	{
+		MapInfo mapInfo;
+		Map map;
+	};
+
+	//===================================================================================
+	//! @class StageStore
+	//===================================================================================
+	class StageStore
+	{
+	public:
+		std::shared_ptr<const Stage> load(const s3d::FilePath& filepath);
+
+	private:
+		std::mutex mMutex;
+		std::unordered_map<std::wstring, std::shared_ptr<const Stage>> mStages;
+	};
+
+	//===================================================================================
+	//! @class JudgeSession
+	//! 1s1NGXg̃eLXgvgR
+	//===================================================================================
+	class JudgeSession
+	{
+	public:
+		explicit JudgeSession(StageStore& store);
+		~JudgeSession();
+
+		bool handle(const std::string& request, std::string& response);
+
+	private:
+		bool load(const std::string& arg, std::string& response);
+		bool step(const std::string& arg, std::string& response);
+		bool state(std::string& response);
+		bool cells(std::string& response);
+		bool snapshot(std::string& response);
+		bool restore(const std::string& arg, std::string& response);
+		bool release(const std::string& arg, std::string& response);
+		bool score(std::string& response);
+		bool reset(std::string& response);
+
+	private:
+		StageStore& mStore;
+		std::shared_ptr<const Stage> mpStage;
+		Map mMap;
+		s3d::Grid<Cell> mScratch;
+		std::unordered_map<u32, Map> mSnapshots;
+		u32 mNextSnapshot;
+	};
+
+	//===================================================================================
+	//! @class JudgeServer
+	//===================================================================================
+	class JudgeServer
+	{
+	public:
+		JudgeServer();
+		~JudgeServer();
+
+		void serve(std::FILE* in, std::FILE* out);
+		bool listen(const s3d::FilePath& socketPath);
+
+	private:
+		StageStore mStore;
+	};
+
+}
@@ -0,0 +1,219 @@
+//
+// Lambda Lifting C API
+//
+
+#include "stdafx.h"
+#include "LambdaLiftingAPI.h"
+
+#include "Map.h"
+#include "Simulator.h"
+#include "Replay.h"
+
+//===================================================================================
+//! @struct LLMap
+//===================================================================================
+struct LLMap
+{
+	app::MapInfo mapInfo;
+	app::Map map;
+	LLState state;
+	s3d::Grid<app::Cell> scratch;	// XebvƂ̊mۂ邽߂̍Ɨ̈
+};
+
+namespace {
+
+	//-----------------------------------------------------------------------------
+	//! JE^𓯊
+	//-----------------------------------------------------------------------------
+	void syncState(LLMap& m)
+	{
+		const app::Map& map = m.map;
+		LLState& s = m.state;
+		s.robotX = map.robotPos.x;
+		s.robotY = map.robotPos.y;
+		s.lambda = map.lambda;
+		s.lambdaCollected = map.lambdaCollected;
+		s.stepCount = map.stepCount;
+		s.score = map.score;
+		s.condition = static_cast<uint32_t>(map.condition);
+		s.water = map.water;
+		s.floodingCount = map.floodingCount;
+		s.waterproofCount = map.waterproofCount;
+		s.growthCount = map.growthCount;
+		s.razor = map.razor;
+		s.beard = map.beard;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 1R}hs
+	//! Ֆʂς1AςȂ0AR}hsȂ-1
+	//-----------------------------------------------------------------------------
+	inline int32_t stepOne(LLMap& m, char c)
+	{
+		const app::Command cmd = app::commandOfChar(static_cast<s3d::wchar>(c));
+		if (cmd == app::Command::None)
+			return -1;
+		if (m.map.condition != app::Condition::Playing)
+			return 0;
+		return app::Simulator::step(cmd, m.map, m.scratch) ? 1 : 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	LLMap* createMap(const s3d::String& text)
+	{
+		LLMap* m = new LLMap;
+		m->map.info = &m->mapInfo;
+		if (!app::Simulator::parseMap(text, m->mapInfo, m->map)) {
+			delete m;
+			return nullptr;
+		}
+		syncState(*m);
+		return m;
+	}
+
+} // unnamed namespace
+
+
+extern "C" {
+
+	//-----------------------------------------------------------------------------
+	//! ABĨo[W
+	//-----------------------------------------------------------------------------
+	uint32_t llVersion(void)
+	{
+		return LL_API_VERSION;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@Cǂݍ
+	//-----------------------------------------------------------------------------
+	LLMap* llLoadMap(const wchar_t* filepath)
+	{
+		s3d::TextReader r(filepath);
+		if (!r.isOpened())
+			return nullptr;
+		return createMap(r.readContents());
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 񂩂ǂݍ
+	//-----------------------------------------------------------------------------
+	LLMap* llParseMap(const char* text, size_t length)
+	{
+		return createMap(s3d::Widen(std::string(text, length)));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	LLMap* llCloneMap(const LLMap* map)
+	{
+		LLMap* m = new LLMap(*map);
+		m->map.info = &m->mapInfo;
+		return m;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ㏑
+	//! 傫̃}bvmȂZ̃obt@͍ĊmۂȂ
+	//-----------------------------------------------------------------------------
+	void llCopyMap(LLMap* dst, const LLMap* src)
+	{
+		if (dst == src)
+			return;
+		dst->mapInfo = src->mapInfo;
+		dst->map = src->map;
+		dst->map.info = &dst->mapInfo;
+		dst->state = src->state;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	void llFreeMap(LLMap* map)
+	{
+		delete map;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 1R}hs
+	//-----------------------------------------------------------------------------
+	int32_t llStep(LLMap* map, char cmd)
+	{
+		const int32_t result = stepOne(*map, cmd);
+		if (result >= 0) {
+			// 0łŌ̕EƂȂǂ͔ՖʂςĂ
+			syncState(*map);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! As
+	//! ՖʂςR}h̐Ԃ
+	//-----------------------------------------------------------------------------
+	uint32_t llRun(LLMap* map, const char* cmds, size_t length)
+	{
+		uint32_t count = 0;
+		for (size_t i = 0; i < length && map->map.condition == app::Condition::Playing; ++i) {
+			if (stepOne(*map, cmds[i]) > 0)
+				count++;
+		}
+		syncState(*map);
+		return count;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̃}bvꂼ1R}hi߂
+	//! results ɂ llStep Ɠl (nullptr)
+	//-----------------------------------------------------------------------------
+	void llStepBatch(LLMap* const* maps, const char* cmds, size_t count, int32_t* results)
+	{
+		for (size_t i = 0; i < count; ++i) {
+			const int32_t result = stepOne(*maps[i], cmds[i]);
+			if (result >= 0) {
+				syncState(*maps[i]);
+			}
+			if (results) {
+				results[i] = result;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XRA
+	//! vCȂ炻̏Abortꍇ̃XRA
+	//-----------------------------------------------------------------------------
+	int32_t llScore(const LLMap* map)
+	{
+		return app::finalScore(map->map);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! JE^
+	//-----------------------------------------------------------------------------
+	const LLState* llGetState(const LLMap* map)
+	{
+		return &map->state;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Z
+	//! sD width * height Bl Cell (8bitށA8bitx)
+	//! }bv邩A傫̈Ⴄ}bvŏ㏑܂ŗL
+	//-----------------------------------------------------------------------------
+	const uint16_t* llGetCells(const LLMap* map, uint32_t* width, uint32_t* height)
+	{
+		const s3d::Grid<app::Cell>& cell = map->map.cell;
+		if (width)
+			*width = cell.width;
+		if (height)
+			*height = cell.height;
+		if (cell.width == 0 || cell.height == 0)
+			return nullptr;
+		return reinterpret_cast<const uint16_t*>(cell[0]);
+	}
+
+}
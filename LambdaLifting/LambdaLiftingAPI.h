@@ -0,0 +1,77 @@
+//
+// Lambda Lifting C API
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#if defined(LL_BUILD_DLL)
+#define LL_API __declspec(dllexport)
+#elif defined(LL_USE_DLL)
+#define LL_API __declspec(dllimport)
+#else
+#define LL_API
+#endif
+
+#define LL_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	//===================================================================================
+	//! @struct LLState
+	//! Map ̃JE^ށBXebvƂɍXVAAhX̓}bv܂ŕςȂ
+	//===================================================================================
+	typedef struct LLState
+	{
+		int32_t robotX;
+		int32_t robotY;
+		uint32_t lambda;
+		uint32_t lambdaCollected;
+		uint32_t stepCount;
+		int32_t score;
+		uint32_t condition;		// 0:Playing 1:Winning 2:Abort 3:Losing
+
+		uint32_t water;
+		uint32_t floodingCount;
+		uint32_t waterproofCount;
+
+		uint32_t growthCount;
+		uint32_t razor;
+		uint32_t beard;
+	} LLState;
+
+	typedef struct LLMap LLMap;
+
+	LL_API uint32_t llVersion(void);
+
+	//! @name Ɣj
+	//@{
+	LL_API LLMap* llLoadMap(const wchar_t* filepath);
+	LL_API LLMap* llParseMap(const char* text, size_t length);
+	LL_API LLMap* llCloneMap(const LLMap* map);
+	LL_API void llCopyMap(LLMap* dst, const LLMap* src);
+	LL_API void llFreeMap(LLMap* map);
+	//@}
+
+	//! @name s
+	//@{
+	LL_API int32_t llStep(LLMap* map, char cmd);
+	LL_API uint32_t llRun(LLMap* map, const char* cmds, size_t length);
+	LL_API void llStepBatch(LLMap* const* maps, const char* cmds, size_t count, int32_t* results);
+	LL_API int32_t llScore(const LLMap* map);
+	//@}
+
+	//! @name Q
+	//@{
+	LL_API const LLState* llGetState(const LLMap* map);
+	LL_API const uint16_t* llGetCells(const LLMap* map, uint32_t* width, uint32_t* height);
+	//@}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,374 @@
+//
+// MCTS Solver
+//
+
+#include "stdafx.h"
+#include "MCTSSolver.h"
+
+#include <cmath>
+#include <thread>
+
+#include "Simulator.h"
+#include "TaskPool.h"
+#include "Replay.h"
+#include "MapAnalysis.h"
+
+namespace {
+
+	static const app::Command COMMANDS[] = {
+		app::Command::Up,
+		app::Command::Down,
+		app::Command::Left,
+		app::Command::Right,
+		app::Command::Wait,
+		app::Command::Shave,
+	};
+	static const u32 COMMAND_NUM = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+	static const u64 REWARD_ONE = 1 << 20;
+	static const u32 VIRTUAL_LOSS = 3;
+	static const f64 EXPLORATION = 0.5;
+
+	// 1^XNŉ񂷃Ce[V
+	static const u32 ITERATION_PER_TASK = 256;
+
+	// WJ̏
+	static const u8 NODE_LEAF = 0;
+	static const u8 NODE_EXPANDING = 1;
+	static const u8 NODE_EXPANDED = 2;
+	static const u8 NODE_FULL = 3;		// m[h肸WJłȂ
+
+	//-----------------------------------------------------------------------------
+	//! xorshift64
+	//-----------------------------------------------------------------------------
+	inline u64 nextRandom(u64& x)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	MCTSSolver::MCTSSolver(u32 threadNum, u32 nodeMax)
+		: mThreadNum(threadNum)
+		, mNodeMax(std::max(1u, nodeMax))
+		, mRolloutDepth(100)
+		, mRolloutGuidance(0.5)
+		, mNodeNum(0)
+		, mRolloutNum(0)
+		, mScoreMin(0)
+		, mScoreMax(1)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	MCTSSolver::~MCTSSolver()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! Ce[V^XNɕ TaskPool ɗAI^XN͎ēo^
+	//-----------------------------------------------------------------------------
+	void MCTSSolver::solve(const Map& initial, SolverContext& ctx)
+	{
+		mpNodes.reset(new Node[mNodeMax]);
+		mNodeNum = 1;
+		mRolloutNum = 0;
+
+		// V [0, 1] ɐK邽߂͈̔
+		const s32 depthMax = initial.cell.width * initial.cell.height;
+		mScoreMin = -depthMax;
+		mScoreMax = std::max(mScoreMin + 1, static_cast<s32>(75 * initial.lambda));
+
+		ctx.publish(s3d::String(1, charOfCommand(Command::Abort)), finalScore(initial));
+
+		TaskPool pool(mThreadNum);
+
+		mWorkspaces.clear();
+		mFreeWorkspaces.clear();
+		for (u32 i = 0; i < pool.size() * 2; ++i) {
+			std::unique_ptr<Workspace> ws(new Workspace);
+			ws->map = initial;
+			ws->child = initial;
+			ws->random = 0x9E3779B97F4A7C15ull * (i + 1);
+			ws->fields.reset(initial);
+			mFreeWorkspaces.push_back(ws.get());
+			mWorkspaces.push_back(std::move(ws));
+		}
+
+		std::atomic<bool> stop(false);
+		std::function<void()> task;
+		task = [&]{
+			Workspace* ws = acquire();
+			for (u32 i = 0; i < ITERATION_PER_TASK && !stop; ++i) {
+				iterate(*ws, initial, ctx);
+			}
+			release(ws);
+
+			// TsꂽI
+			const Node& root = mpNodes[0];
+			if (root.state == NODE_EXPANDED && root.childNum == 0) {
+				stop = true;
+			}
+			if (!stop) {
+				pool.submit(task);
+			}
+		};
+
+		for (u32 i = 0; i < pool.size() * 2; ++i) {
+			pool.submit(task);
+		}
+
+		// Iɐi񍐂
+		auto last = std::chrono::steady_clock::now();
+		u64 lastRolloutNum = 0;
+		while (!stop)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			if (ctx.isCancelled()) {
+				stop = true;
+				break;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			const f64 dt = std::chrono::duration<f64>(now - last).count();
+			if (dt >= 1.0 && mReportCallback) {
+				const u64 rolloutNum = mRolloutNum;
+				mReportCallback(rolloutNum, mNodeNum, (rolloutNum - lastRolloutNum) / dt);
+				last = now;
+				lastRolloutNum = rolloutNum;
+			}
+		}
+		pool.wait();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! IAWJA[AEgAt`d1s
+	//! Ֆʂ͍H蒼AƗ̈Mapɏ㏑
+	//-----------------------------------------------------------------------------
+	void MCTSSolver::iterate(Workspace& ws, const Map& initial, SolverContext& ctx)
+	{
+		// ǑoHŕ\ɔfŹAɖ߂ƕς肤
+		ws.stale.insert(ws.stale.end(), ws.changed.begin(), ws.changed.begin() + ws.synced);
+		ws.changed.clear();
+		ws.synced = 0;
+		ws.map = initial;
+		ws.path.clear();
+		ws.route.clear();
+
+		u32 index = 0;
+		ws.path.push_back(index);
+
+		for (;;)
+		{
+			Node& node = mpNodes[index];
+
+			u8 state = node.state.load(std::memory_order_acquire);
+			if (state == NODE_LEAF && node.visits > 0) {
+				u8 expected = NODE_LEAF;
+				if (node.state.compare_exchange_strong(expected, NODE_EXPANDING)) {
+					expand(node, ws);
+				}
+				state = node.state.load(std::memory_order_acquire);
+			}
+
+			// tAȂՖ
+			if (state != NODE_EXPANDED || node.childNum == 0)
+				break;
+
+			const u32 child = select(node, std::log(static_cast<f64>(node.visits + node.virtualLoss * VIRTUAL_LOSS + 1)));
+			mpNodes[child].virtualLoss++;
+
+			const Command cmd = static_cast<Command>(mpNodes[child].cmd);
+			Simulator::step(cmd, ws.map, ws.scratch, ws.changed);
+			ws.route += charOfCommand(cmd);
+			ws.path.push_back(child);
+			index = child;
+
+			if (ws.map.condition != Condition::Playing)
+				break;
+		}
+
+		ctx.addNodeNum(ws.path.size());
+
+		const s32 score = rollout(ws, ctx);
+		const u64 reward = static_cast<u64>(rewardOf(score) * REWARD_ONE);
+
+		for (size_t i = 0; i < ws.path.size(); ++i) {
+			Node& node = mpNodes[ws.path[i]];
+			node.reward += reward;
+			node.visits++;
+			if (i > 0) {
+				node.virtualLoss--;
+			}
+		}
+		mRolloutNum++;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! UCB1ŎqI
+	//! z͕V0̖KƂĐ
+	//-----------------------------------------------------------------------------
+	u32 MCTSSolver::select(const Node& node, f64 logVisits) const
+	{
+		const u32 first = node.firstChild;
+		u32 best = first;
+		f64 bestValue = -1.0;
+
+		for (u32 i = 0; i < node.childNum; ++i)
+		{
+			const Node& child = mpNodes[first + i];
+			const u32 n = child.visits + child.virtualLoss * VIRTUAL_LOSS;
+			if (n == 0)
+				return first + i;
+
+			const f64 q = static_cast<f64>(child.reward) / REWARD_ONE / n;
+			const f64 value = q + EXPLORATION * std::sqrt(logVisits / n);
+			if (value > bestValue) {
+				bestValue = value;
+				best = first + i;
+			}
+		}
+		return best;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! WJ
+	//! ՖʂςAȂȂR}hqɂ
+	//-----------------------------------------------------------------------------
+	void MCTSSolver::expand(Node& node, Workspace& ws)
+	{
+		u8 cmds[COMMAND_NUM];
+		u32 num = 0;
+
+		for (u32 k = 0; k < COMMAND_NUM; ++k) {
+			const Command cmd = COMMANDS[k];
+			if (cmd == Command::Shave && ws.map.razor == 0)
+				continue;
+			if (pushesIntoDeadCorner(ws.map, cmd))
+				continue;
+
+			ws.child = ws.map;
+			if (Simulator::step(cmd, ws.child, ws.scratch) && ws.child.condition != Condition::Losing) {
+				cmds[num++] = static_cast<u8>(cmd);
+			}
+		}
+
+		const u32 first = mNodeNum.fetch_add(num);
+		if (first + num > mNodeMax) {
+			node.state.store(NODE_FULL, std::memory_order_release);
+			return;
+		}
+
+		for (u32 i = 0; i < num; ++i) {
+			mpNodes[first + i].cmd = cmds[i];
+		}
+		node.firstChild = first;
+		node.childNum = static_cast<u8>(num);
+		node.state.store(NODE_EXPANDED, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [AEg
+	//! mRolloutGuidance ̊ōŊ̃_ (΃tg) ɋ߂ÂAc̓_ɐi߂
+	//! rAbortꍇ܂߂ōXRAԂ
+	//! ̕\͎gɁAOɎgՖʂ珑Z𒼂
+	//-----------------------------------------------------------------------------
+	s32 MCTSSolver::rollout(Workspace& ws, SolverContext& ctx)
+	{
+		s32 bestScore = finalScore(ws.map);
+		size_t bestLength = ws.route.length;
+		bool bestAbort = ws.map.condition == Condition::Playing;
+
+		const u64 guidance = static_cast<u64>(mRolloutGuidance * 1024);
+
+		for (u32 depth = 0; depth < mRolloutDepth && ws.map.condition == Condition::Playing; ++depth)
+		{
+			Command cmd = Command::Wait;
+			if (nextRandom(ws.random) % 1024 < guidance) {
+				syncFields(ws);
+				cmd = ws.fields.descend(ws.map);
+			}
+			if (cmd == Command::Wait) {
+				const u32 num = ws.map.razor > 0 ? COMMAND_NUM : COMMAND_NUM - 1;
+				cmd = COMMANDS[nextRandom(ws.random) % num];
+			}
+
+			// ߂lfalsełEȂǂŔՖʂ͕ς肤̂ŁAsR}h͕Kc
+			Simulator::step(cmd, ws.map, ws.scratch, ws.changed);
+			ws.route += charOfCommand(cmd);
+
+			const s32 score = finalScore(ws.map);
+			if (score > bestScore) {
+				bestScore = score;
+				bestLength = ws.route.length;
+				bestAbort = ws.map.condition == Condition::Playing;
+			}
+		}
+
+		if (bestScore > ctx.getBestScore()) {
+			// ō_̎_ŏIĂȂAbortt
+			s3d::String route{ ws.route.substr(0, bestLength) };
+			if (bestAbort) {
+				route += charOfCommand(Command::Abort);
+			}
+			ctx.publish(route, bestScore);
+		}
+
+		return bestScore;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̕\Ɨ̈̔Ֆʂɍ킹
+	//! \ƈႢ̂́AǑoHŔfZƁǍoHł܂fĂȂZ
+	//-----------------------------------------------------------------------------
+	void MCTSSolver::syncFields(Workspace& ws)
+	{
+		ws.stale.insert(ws.stale.end(), ws.changed.begin() + ws.synced, ws.changed.end());
+		ws.fields.update(ws.map, ws.stale);
+		ws.stale.clear();
+		ws.synced = ws.changed.size();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XRA [0, 1] 
+	//-----------------------------------------------------------------------------
+	f64 MCTSSolver::rewardOf(s32 score) const
+	{
+		const f64 r = static_cast<f64>(score - mScoreMin) / (mScoreMax - mScoreMin);
+		return std::max(0.0, std::min(1.0, r));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ɨ̈؂
+	//-----------------------------------------------------------------------------
+	MCTSSolver::Workspace* MCTSSolver::acquire()
+	{
+		std::lock_guard<std::mutex> lock(mWorkspaceMutex);
+		Workspace* ws = mFreeWorkspaces.back();
+		mFreeWorkspaces.pop_back();
+		return ws;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ɨ̈Ԃ
+	//-----------------------------------------------------------------------------
+	void MCTSSolver::release(Workspace* ws)
+	{
+		std::lock_guard<std::mutex> lock(mWorkspaceMutex);
+		mFreeWorkspaces.push_back(ws);
+	}
+
+}
@@ -0,0 +1,108 @@
+//
+// MCTS Solver
+//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "DistanceFields.h"
+#include "Map.h"
+#include "Solver.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class MCTSSolver
+	//! SXbh1{̖؂L郂eJؒT
+	//! I𒆂̃m[hɂ͉zAoHɏWȂ悤ɂ
+	//===================================================================================
+	class MCTSSolver : public Solver
+	{
+	public:
+		using ReportCallback = std::function<void(u64 rolloutNum, u32 treeSize, f64 rolloutRate)>;
+
+		explicit MCTSSolver(u32 threadNum = 0, u32 nodeMax = 1 << 22);
+		~MCTSSolver();
+
+		const s3d::wchar* getName() const override { return L"mcts"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		void setRolloutDepth(u32 depth){ mRolloutDepth = depth; }
+		//! [AEgŋ̕\ɏ]ē (0ŊSɃ_)
+		void setRolloutGuidance(f64 ratio){ mRolloutGuidance = ratio; }
+		void setReportCallback(const ReportCallback& callback){ mReportCallback = callback; }
+
+		u64 getRolloutNum() const { return mRolloutNum; }
+		u32 getTreeSize() const { return mNodeNum; }
+
+	private:
+		struct Node
+		{
+			std::atomic<u32> visits;
+			std::atomic<u32> virtualLoss;
+			std::atomic<u64> reward;		// V̍v (REWARD_ONE 1.0)
+			std::atomic<u32> firstChild;
+			std::atomic<u8> state;			// 0:WJ 1:WJ 2:WJς
+			u8 childNum;
+			u8 cmd;
+
+			Node() : visits(0), virtualLoss(0), reward(0), firstChild(0), state(0), childNum(0), cmd(0) {}
+		};
+
+		//! [J[Ƃ̍Ɨ̈B[AEgƂMapmۂȂ
+		struct Workspace
+		{
+			Map map;
+			Map child;
+			s3d::Grid<Cell> scratch;
+			std::vector<u32> path;
+			s3d::String route;
+			u64 random;
+
+			// [AEgŎĝ͍Ŋ̃_ƃtg܂ł̕\
+			DistanceFields fields;
+
+			// HԂɏZƁÂ\ɔf
+			// stale ͑OɒHoHŕ\ɔfZŁAɖ߂ՖʂƂ͂Ⴂ
+			std::vector<s32> changed;
+			size_t synced;
+			std::vector<s32> stale;
+
+			Workspace() : fields(0), synced(0) {}
+		};
+
+		void iterate(Workspace& ws, const Map& initial, SolverContext& ctx);
+		u32 select(const Node& node, f64 logVisits) const;
+		void expand(Node& node, Workspace& ws);
+		s32 rollout(Workspace& ws, SolverContext& ctx);
+		void syncFields(Workspace& ws);
+		f64 rewardOf(s32 score) const;
+
+		Workspace* acquire();
+		void release(Workspace* ws);
+
+	private:
+		u32 mThreadNum;
+		u32 mNodeMax;
+		u32 mRolloutDepth;
+		f64 mRolloutGuidance;
+
+		std::unique_ptr<Node[]> mpNodes;
+		std::atomic<u32> mNodeNum;
+		std::atomic<u64> mRolloutNum;
+
+		s32 mScoreMin;
+		s32 mScoreMax;
+
+		std::mutex mWorkspaceMutex;
+		std::vector<std::unique_ptr<Workspace>> mWorkspaces;
+		std::vector<Workspace*> mFreeWorkspaces;
+
+		ReportCallback mReportCallback;
+	};
+
+}
@@ -0,0 +1,98 @@
+//
+// Macro Action
+//
+
+#include "stdafx.h"
+#include "MacroAction.h"
+
+#include "Simulator.h"
+#include "TourPlanner.h"
+
+namespace {
+
+	//-----------------------------------------------------------------------------
+	//! ړR}hŌ}X
+	//-----------------------------------------------------------------------------
+	inline app::int2 movedPos(const app::int2& pos, s3d::wchar cmd)
+	{
+		switch (app::commandOfChar(cmd)) {
+		case app::Command::Up:		return app::int2{ pos.x, pos.y - 1 };
+		case app::Command::Down:	return app::int2{ pos.x, pos.y + 1 };
+		case app::Command::Left:	return app::int2{ pos.x - 1, pos.y };
+		case app::Command::Right:	return app::int2{ pos.x + 1, pos.y };
+		default:					return pos;
+		}
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! {bg target ܂œ
+	//! PathField ŌoH߁Ac1肸V~[g
+	//! ₪ēȂ莀ʎ肪΁Ã}XǂƂ݂ȂČoH
+	//! ȂꍇA܂łɓ result ɕԂ
+	//-----------------------------------------------------------------------------
+	bool moveTo(const Map& map, int2 target, MoveResult& result, u32 replanMax)
+	{
+		result.reached = false;
+		result.commands.clear();
+		result.map = map;
+		result.replanNum = 0;
+
+		if (target.x < 0 || target.y < 0 || target.x >= map.cell.width || target.y >= map.cell.height)
+			return false;
+
+		Map& cur = result.map;
+		Map plan, saved;
+		s3d::Grid<Cell> scratch;
+		PathField field;
+		s3d::String leg;
+		std::vector<int2> blocked;
+
+		while (cur.condition == Condition::Playing && cur.robotPos != target)
+		{
+			// }XǂɂՖʂŌoH߂
+			plan = cur;
+			for (const auto& pos : blocked) {
+				plan.cell[pos.y][pos.x] = Cell::Wall;
+			}
+
+			// ƔՖʂ傫ς̂ŁAɍs鎞͂
+			field.build(plan, cur.robotPos, false);
+			if (!field.routeTo(target, leg)) {
+				field.build(plan, cur.robotPos, true);
+				if (!field.routeTo(target, leg))
+					break;
+			}
+
+			bool replan = false;
+			for (auto cmd : leg) {
+				saved = cur;
+				const int2 from = cur.robotPos;
+
+				Simulator::step(commandOfChar(cmd), cur, scratch);
+				if (cur.condition == Condition::Losing || cur.robotPos == from) {
+					blocked.push_back(movedPos(from, cmd));
+					cur = saved;
+					replan = true;
+					break;
+				}
+
+				result.commands += cmd;
+				if (cur.condition != Condition::Playing)
+					break;
+			}
+
+			if (!replan || ++result.replanNum > replanMax)
+				break;
+		}
+
+		result.reached = cur.robotPos == target;
+		return result.reached;
+	}
+
+}
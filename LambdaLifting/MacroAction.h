@@ -0,0 +1,25 @@
+//
+// Macro Action
+//
+
+#pragma once
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct MoveResult
+	//===================================================================================
+	struct MoveResult
+	{
+		bool reached;			// ړInɒ
+		s3d::String commands;	// ۂɓR}h
+		Map map;				// ̔Ֆ
+		u32 replanNum;			// oH
+	};
+
+	bool moveTo(const Map& map, int2 target, MoveResult& result, u32 replanMax = 16);
+
+}
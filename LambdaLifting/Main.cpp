@@ -2,9 +2,14 @@
 #include "stdafx.h"
 
 #include "App.h"
+#include "CommandLine.h"
 
 void Main()
 {
+	// コマンドラインモード
+	if (app::runCommandLine(s3d::CommandLine::Get()))
+		return;
+
 	std::unique_ptr<app::App> appPtr{ new app::App };
 
 	appPtr->initialize();
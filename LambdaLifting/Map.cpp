@@ -4,6 +4,28 @@
 
 #include "stdafx.h"
 #include "Map.h"
+#include "Hash.h"
+
+namespace {
+
+	template<class T>
+	void put(std::vector<u8>& out, const T& value)
+	{
+		const u8* p = reinterpret_cast<const u8*>(&value);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	template<class T>
+	bool get(const u8*& p, const u8* end, T& value)
+	{
+		if (end - p < static_cast<ptrdiff_t>(sizeof(T)))
+			return false;
+		std::memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+} // unnamed namespace
 
 namespace app
 {
@@ -77,6 +99,29 @@ namespace app
 		return L"H";
 	}
 
+	//-----------------------------------------------------------------------------
+	//! Cell}bvt@C̕
+	//-----------------------------------------------------------------------------
+	s3d::wchar charOfCell(Cell cell)
+	{
+		switch (cellType(cell)) {
+		case Cell::Empty:		return L' ';
+		case Cell::Robot:		return L'R';
+		case Cell::Rock:		return L'*';
+		case Cell::Lambda:		return L'\\';
+		case Cell::Earth:		return L'.';
+		case Cell::Wall:		return L'#';
+		case Cell::ClosedLift:	return L'L';
+		case Cell::OpenLift:	return L'O';
+		case Cell::Trampoline:	return static_cast<s3d::wchar>(L'A' + cellLabel(cell));
+		case Cell::Target:		return static_cast<s3d::wchar>(L'1' + cellLabel(cell));
+		case Cell::Beard:		return L'W';
+		case Cell::Razor:		return L'!';
+		case Cell::HORock:		return L'@';
+		}
+		return L'?';
+	}
+
 	//-----------------------------------------------------------------------------
 	//! Condition𕶎
 	//-----------------------------------------------------------------------------
@@ -130,6 +175,155 @@ namespace app
 		std::memset(trampolinePos, 0, sizeof(trampolinePos));
 		std::memset(targetPos, 0, sizeof(targetPos));
 		std::fill(jump, jump + sizeof(jump), 0xFF);
+
+		cellFlags = s3d::Grid<u8>();
+		fixedRock = 0;
+		deadLambda = 0;
+		liftReachable = true;
+	}
+
+
+	//-----------------------------------------------------------------------------
+	//! Ֆʂ̃nbV
+	//! 萔ƃXRAȊÓAȍ~̓WJɉel܂߂
+	//-----------------------------------------------------------------------------
+	u64 hashOfMap(const Map& map)
+	{
+		u64 h = FNV_OFFSET_BASIS;
+
+		// Z8oCg
+		const size_t size = map.cell.width * map.cell.height * sizeof(Cell);
+		const u8* p = size > 0 ? reinterpret_cast<const u8*>(map.cell[0]) : nullptr;
+		size_t i = 0;
+		for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+			u64 v;
+			std::memcpy(&v, p + i, sizeof(u64));
+			h = (h ^ v) * FNV_PRIME;
+			h ^= h >> 29;
+		}
+		h = hashBytes(p + i, size - i, h);
+
+		h = hashValue(map.robotPos, h);
+		h = hashValue(map.lambda, h);
+		h = hashValue(map.lambdaCollected, h);
+		h = hashValue(map.condition, h);
+		h = hashValue(map.water, h);
+		h = hashValue(map.floodingCount, h);
+		h = hashValue(map.waterproofCount, h);
+		h = hashValue(map.growthCount, h);
+		h = hashValue(map.razor, h);
+		return h;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! MapoCgɕϊ
+	//! Z͎ނƃx4bitl߂1oCgŕۑ
+	//-----------------------------------------------------------------------------
+	void packMap(const Map& map, std::vector<u8>& out)
+	{
+		const u16 w = static_cast<u16>(map.cell.width), h = static_cast<u16>(map.cell.height);
+
+		put(out, w);
+		put(out, h);
+		put(out, map.robotPos.x);
+		put(out, map.robotPos.y);
+		put(out, map.lambda);
+		put(out, map.lambdaCollected);
+		put(out, map.stepCount);
+		put(out, map.score);
+		put(out, static_cast<u8>(map.condition));
+		put(out, map.water);
+		put(out, map.floodingCount);
+		put(out, map.waterproofCount);
+		put(out, map.growthCount);
+		put(out, map.razor);
+		put(out, map.beard);
+
+		const size_t offset = out.size();
+		out.resize(offset + w * h);
+		u8* p = &out[offset];
+		for (u32 y = 0; y < h; ++y) {
+			for (u32 x = 0; x < w; ++x) {
+				const Cell c = map.cell[y][x];
+				*p++ = static_cast<u8>(static_cast<u16>(cellType(c)) | (cellLabel(c) << 4));
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oCg񂩂Map𕜌
+	//-----------------------------------------------------------------------------
+	bool unpackMap(const u8*& p, const u8* end, Map& map)
+	{
+		u16 w = 0, h = 0;
+		u8 condition = 0;
+
+		if (!get(p, end, w) || !get(p, end, h) ||
+			!get(p, end, map.robotPos.x) || !get(p, end, map.robotPos.y) ||
+			!get(p, end, map.lambda) || !get(p, end, map.lambdaCollected) ||
+			!get(p, end, map.stepCount) || !get(p, end, map.score) ||
+			!get(p, end, condition) ||
+			!get(p, end, map.water) || !get(p, end, map.floodingCount) || !get(p, end, map.waterproofCount) ||
+			!get(p, end, map.growthCount) || !get(p, end, map.razor) || !get(p, end, map.beard))
+		{
+			return false;
+		}
+		map.condition = static_cast<Condition>(condition);
+
+		if (end - p < static_cast<ptrdiff_t>(w * h))
+			return false;
+
+		// TCYȂobt@ėp
+		if (map.cell.width != w || map.cell.height != h) {
+			map.cell.resize(w, h, Cell::Empty);
+		}
+		for (u32 y = 0; y < h; ++y) {
+			for (u32 x = 0; x < w; ++x) {
+				const u8 b = *p++;
+				map.cell[y][x] = static_cast<Cell>(MAKE_LABELED_CELL(b & 0x0F, b >> 4));
+			}
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! MapInfooCgɕϊ
+	//-----------------------------------------------------------------------------
+	void packMapInfo(const MapInfo& mapInfo, std::vector<u8>& out)
+	{
+		put(out, mapInfo.liftPos.x);
+		put(out, mapInfo.liftPos.y);
+		put(out, mapInfo.flooding);
+		put(out, mapInfo.waterproof);
+		put(out, mapInfo.growth);
+		for (u32 i = 0; i < MAX_TRAMPOLINE; ++i) {
+			put(out, mapInfo.trampolinePos[i].x);
+			put(out, mapInfo.trampolinePos[i].y);
+			put(out, mapInfo.targetPos[i].x);
+			put(out, mapInfo.targetPos[i].y);
+			put(out, mapInfo.jump[i]);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oCg񂩂MapInfo𕜌
+	//-----------------------------------------------------------------------------
+	bool unpackMapInfo(const u8*& p, const u8* end, MapInfo& mapInfo)
+	{
+		if (!get(p, end, mapInfo.liftPos.x) || !get(p, end, mapInfo.liftPos.y) ||
+			!get(p, end, mapInfo.flooding) || !get(p, end, mapInfo.waterproof) || !get(p, end, mapInfo.growth))
+		{
+			return false;
+		}
+		for (u32 i = 0; i < MAX_TRAMPOLINE; ++i) {
+			if (!get(p, end, mapInfo.trampolinePos[i].x) || !get(p, end, mapInfo.trampolinePos[i].y) ||
+				!get(p, end, mapInfo.targetPos[i].x) || !get(p, end, mapInfo.targetPos[i].y) ||
+				!get(p, end, mapInfo.jump[i]))
+			{
+				return false;
+			}
+		}
+		return true;
 	}
 
 }
@@ -78,6 +78,7 @@ namespace app
 	inline u8 cellLabel(Cell c){ return (static_cast<u16>(c) & CELL_LABEL_MASK) >> CELL_LABEL_SHIFT; }
 
 	const s3d::wchar* stringOfCell(Cell cell);
+	s3d::wchar charOfCell(Cell cell);
 
 	//===================================================================================
 	//! @enum Condition
@@ -132,6 +133,12 @@ namespace app
 	//===================================================================================
 	static const u32 MAX_TRAMPOLINE = 9;
 
+	// ǂݍݎ̉͂ŕZ̐ (MapInfo::cellFlags)
+	static const u8 CELL_UNREACHABLE	= 0x01;		// {bgxȂ
+	static const u8 CELL_FIXED_ROCK		= 0x02;		// xƓȂ
+	static const u8 CELL_DEAD_CORNER	= 0x04;		// ₪xƓȂ
+	static const u8 CELL_DEAD_LAMBDA	= 0x08;		// łȂ_K
+
 	//! @struct Jump Table
 	struct MapInfo
 	{
@@ -149,12 +156,35 @@ namespace app
 		int2 targetPos[MAX_TRAMPOLINE];
 		u8 jump[MAX_TRAMPOLINE];
 
+		// Static analysis (analyzeMap)
+		s3d::Grid<u8> cellFlags;
+		u32 fixedRock;
+		u32 deadLambda;
+		bool liftReachable;
+
 	public:
 		MapInfo(){ clear(); }
 
+		bool isAnalyzed() const { return cellFlags.width > 0; }
+		u8 flagsAt(int2 pos) const { return isAnalyzed() ? cellFlags[pos.y][pos.x] : 0; }
+
 		void clear();
 	};
 
+	//===================================================================================
+	// Hash
+	//===================================================================================
+	u64 hashOfMap(const Map& map);
+
+	//===================================================================================
+	// Serialization
+	//===================================================================================
+	void packMap(const Map& map, std::vector<u8>& out);
+	bool unpackMap(const u8*& p, const u8* end, Map& map);
+
+	void packMapInfo(const MapInfo& mapInfo, std::vector<u8>& out);
+	bool unpackMapInfo(const u8*& p, const u8* end, MapInfo& mapInfo);
+
 
 #if 0
 	//===================================================================================
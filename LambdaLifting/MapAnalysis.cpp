@@ -0,0 +1,321 @@
+//
+// Map Analysis
+//
+
+#include "stdafx.h"
+#include "MapAnalysis.h"
+
+#include "Map.h"
+
+namespace {
+
+	using app::Cell;
+	using app::int2;
+
+	//-----------------------------------------------------------------------------
+	//! ǂƃtg͌`ς炸A{bgȂ
+	//-----------------------------------------------------------------------------
+	inline bool isStatic(Cell c)
+	{
+		const Cell t = app::cellType(c);
+		return t == Cell::Wall || t == Cell::ClosedLift || t == Cell::OpenLift;
+	}
+
+	inline bool isRock(Cell c)
+	{
+		return c == Cell::Rock || c == Cell::HORock;
+	}
+
+	//===================================================================================
+	//! @class Analyzer
+	//! ͒̔ՖʂƁA
+	//===================================================================================
+	class Analyzer
+	{
+	public:
+		Analyzer(const app::Map& map, s3d::Grid<u8>& flags)
+			: mMap(map)
+			, mFlags(flags)
+			, mWidth(map.cell.width)
+			, mHeight(map.cell.height)
+		{
+		}
+
+		//-----------------------------------------------------------------------------
+		//! ₪邱Ƃo邱ƂȂZBՖʂ̊O܂
+		//-----------------------------------------------------------------------------
+		bool isSolid(s32 x, s32 y) const
+		{
+			if (x < 0 || x >= mWidth || y < 0 || y >= mHeight)
+				return true;
+			return isStatic(mMap.cell[y][x]) || (mFlags[y][x] & app::CELL_FIXED_ROCK) != 0;
+		}
+
+		//-----------------------------------------------------------------------------
+		//! (x, y) ɂ₪xƓȂ
+		//! ǂĂėAȂ̏Ȃ獶Eɂ炸A
+		//! E̕ЕǂĂă{bgȂ
+		//-----------------------------------------------------------------------------
+		bool isStuck(s32 x, s32 y) const
+		{
+			if (!isSolid(x, y + 1))
+				return false;
+
+			if (y + 1 < mHeight && (mFlags[y + 1][x] & app::CELL_FIXED_ROCK)) {
+				if (!isSolid(x + 1, y) && !isSolid(x + 1, y + 1))
+					return false;
+				if (!isSolid(x - 1, y) && !isSolid(x - 1, y + 1))
+					return false;
+			}
+
+			return isSolid(x - 1, y) || isSolid(x + 1, y);
+		}
+
+		//-----------------------------------------------------------------------------
+		//! ȂT
+		//! ₪ȂȂƁȀƍE̊ȂȂ邱Ƃ̂Œג
+		//-----------------------------------------------------------------------------
+		u32 findFixedRocks()
+		{
+			std::vector<int2> stack;
+			for (s32 y = 0; y < mHeight; ++y) {
+				for (s32 x = 0; x < mWidth; ++x) {
+					if (isRock(mMap.cell[y][x])) {
+						stack.push_back(int2{ x, y });
+					}
+				}
+			}
+
+			u32 count = 0;
+			while (!stack.empty())
+			{
+				const int2 pos = stack.back();
+				stack.pop_back();
+
+				u8& flags = mFlags[pos.y][pos.x];
+				if ((flags & app::CELL_FIXED_ROCK) || !isStuck(pos.x, pos.y))
+					continue;
+
+				flags |= app::CELL_FIXED_ROCK;
+				count++;
+
+				for (s32 dy = -1; dy <= 0; ++dy) {
+					for (s32 dx = -1; dx <= 1; ++dx) {
+						const s32 nx = pos.x + dx, ny = pos.y + dy;
+						if ((dx || dy) && 0 <= nx && nx < mWidth && 0 <= ny && isRock(mMap.cell[ny][nx])) {
+							stack.push_back(int2{ nx, ny });
+						}
+					}
+				}
+			}
+			return count;
+		}
+
+		//-----------------------------------------------------------------------------
+		//! ₪瓮ȂȂ󂫃Z
+		//-----------------------------------------------------------------------------
+		void findDeadCorners()
+		{
+			for (s32 y = 0; y < mHeight; ++y) {
+				for (s32 x = 0; x < mWidth; ++x) {
+					if (!isSolid(x, y) && !isRock(mMap.cell[y][x]) && isStuck(x, y)) {
+						mFlags[y][x] |= app::CELL_DEAD_CORNER;
+					}
+				}
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		//! {bgZ𕝗DŒTAcɈt
+		//! E͒ʂ̂ƂAg|̓WvɂȂ
+		//! ^[Qbgɂ̓WvłȂBtg͍sɂ͂Ȃ邪ʂ蔲Ȃ
+		//! ߂l̓tgɓ͂
+		//-----------------------------------------------------------------------------
+		bool findReachable(const app::MapInfo& mapInfo)
+		{
+			std::vector<bool> reached(mWidth * mHeight, false);
+			std::vector<int2> queue;
+			queue.reserve(mWidth * mHeight);
+
+			reached[mMap.robotPos.y * mWidth + mMap.robotPos.x] = true;
+			queue.push_back(mMap.robotPos);
+
+			static const s32 DX[] = { 0, 0, -1, 1 };
+			static const s32 DY[] = { -1, 1, 0, 0 };
+
+			bool lift = false;
+			auto visit = [&](int2 pos) {
+				if (!reached[pos.y * mWidth + pos.x]) {
+					reached[pos.y * mWidth + pos.x] = true;
+					queue.push_back(pos);
+				}
+			};
+
+			for (size_t head = 0; head < queue.size(); ++head)
+			{
+				const int2 pos = queue[head];
+				const Cell lc = mMap.cell[pos.y][pos.x];
+				if (app::cellType(lc) == Cell::Trampoline) {
+					const u8 target = mapInfo.jump[app::cellLabel(lc)];
+					if (target < app::MAX_TRAMPOLINE) {
+						visit(mapInfo.targetPos[target]);
+					}
+				}
+
+				for (u32 k = 0; k < 4; ++k) {
+					const int2 next{ pos.x + DX[k], pos.y + DY[k] };
+					if (next.x < 0 || next.x >= mWidth || next.y < 0 || next.y >= mHeight)
+						continue;
+
+					const Cell c = app::cellType(mMap.cell[next.y][next.x]);
+					if (c == Cell::ClosedLift || c == Cell::OpenLift) {
+						reached[next.y * mWidth + next.x] = true;
+						lift = true;
+						continue;
+					}
+					if (c == Cell::Wall || c == Cell::Target || (mFlags[next.y][next.x] & app::CELL_FIXED_ROCK))
+						continue;
+
+					visit(next);
+				}
+			}
+
+			for (s32 y = 0; y < mHeight; ++y) {
+				for (s32 x = 0; x < mWidth; ++x) {
+					if (!reached[y * mWidth + x]) {
+						mFlags[y][x] |= app::CELL_UNREACHABLE;
+					}
+				}
+			}
+			return lift;
+		}
+
+		//-----------------------------------------------------------------------------
+		//! łȂ_
+		//! ȂZ̃_ƁAȂ̂ŗă_ɂȂȂK
+		//-----------------------------------------------------------------------------
+		u32 findDeadLambdas()
+		{
+			u32 count = 0;
+			for (s32 y = 0; y < mHeight; ++y) {
+				for (s32 x = 0; x < mWidth; ++x) {
+					const Cell c = mMap.cell[y][x];
+					u8& flags = mFlags[y][x];
+					if ((c == Cell::Lambda && (flags & app::CELL_UNREACHABLE)) || (c == Cell::HORock && (flags & app::CELL_FIXED_ROCK))) {
+						flags |= app::CELL_DEAD_LAMBDA;
+						count++;
+					}
+				}
+			}
+			return count;
+		}
+
+	private:
+		const app::Map& mMap;
+		s3d::Grid<u8>& mFlags;
+		s32 mWidth;
+		s32 mHeight;
+	};
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! Ֆʂ͂
+	//! Ȃ͓ȂZ̔ɎĝŐɋ߂
+	//-----------------------------------------------------------------------------
+	void analyzeMap(const Map& map, MapInfo& mapInfo)
+	{
+		mapInfo.cellFlags = s3d::Grid<u8>(map.cell.width, map.cell.height, 0);
+
+		Analyzer analyzer(map, mapInfo.cellFlags);
+		mapInfo.fixedRock = analyzer.findFixedRocks();
+		analyzer.findDeadCorners();
+		mapInfo.liftReachable = analyzer.findReachable(mapInfo);
+		mapInfo.deadLambda = analyzer.findDeadLambdas();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! cmd ŉɉ₪A₪瓮ȂȂɓ邩
+	//-----------------------------------------------------------------------------
+	bool pushesIntoDeadCorner(const Map& map, Command cmd)
+	{
+		if (!map.info->isAnalyzed())
+			return false;
+
+		s32 dir = 0;
+		if (cmd == Command::Left) {
+			dir = -1;
+		} else if (cmd == Command::Right) {
+			dir = 1;
+		} else {
+			return false;
+		}
+
+		const s32 y = map.robotPos.y;
+		const s32 to = map.robotPos.x + dir * 2;
+		if (to < 0 || to >= map.cell.width)
+			return false;
+		return isRock(map.cell[y][to - dir]) && map.cell[y][to] == Cell::Empty
+			&& (map.info->cellFlags[y][to] & CELL_DEAD_CORNER) != 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! (x, y) ɂZ c AxƉłȂ_K₩
+	//-----------------------------------------------------------------------------
+	bool isDeadLambda(const MapInfo& mapInfo, Cell c, s32 x, s32 y)
+	{
+		if (!mapInfo.isAnalyzed())
+			return false;
+
+		const u8 flags = mapInfo.cellFlags[y][x];
+		if (flags & CELL_DEAD_LAMBDA)
+			return true;
+		return c == Cell::HORock && (flags & CELL_DEAD_CORNER) != 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! analyzeMap ̌ʂoCgɒǉ
+	//! [fixedRock:4][deadLambda:4][liftReachable:1][cellFlags:*]
+	//-----------------------------------------------------------------------------
+	void packAnalysis(const MapInfo& mapInfo, std::vector<u8>& out)
+	{
+		const size_t cellNum = static_cast<size_t>(mapInfo.cellFlags.width) * mapInfo.cellFlags.height;
+		const size_t offset = out.size();
+		out.resize(offset + 9 + cellNum);
+
+		u8* p = &out[offset];
+		std::memcpy(p, &mapInfo.fixedRock, 4);
+		std::memcpy(p + 4, &mapInfo.deadLambda, 4);
+		p[8] = mapInfo.liftReachable ? 1 : 0;
+		for (s32 y = 0; y < mapInfo.cellFlags.height; ++y) {
+			std::memcpy(p + 9 + y * mapInfo.cellFlags.width, mapInfo.cellFlags[y], mapInfo.cellFlags.width);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! packAnalysis oCg񂩂畜
+	//-----------------------------------------------------------------------------
+	bool unpackAnalysis(const u8*& p, const u8* end, const Map& map, MapInfo& mapInfo)
+	{
+		const size_t w = static_cast<size_t>(map.cell.width), h = static_cast<size_t>(map.cell.height);
+		if (static_cast<size_t>(end - p) < 9 + w * h)
+			return false;
+
+		std::memcpy(&mapInfo.fixedRock, p, 4);
+		std::memcpy(&mapInfo.deadLambda, p + 4, 4);
+		mapInfo.liftReachable = p[8] != 0;
+		p += 9;
+
+		mapInfo.cellFlags = s3d::Grid<u8>(map.cell.width, map.cell.height, 0);
+		for (size_t y = 0; y < h; ++y) {
+			std::memcpy(mapInfo.cellFlags[y], p, w);
+			p += w;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,41 @@
+//
+// Map Analysis
+//
+
+#pragma once
+
+namespace app
+{
+
+	// Forward declaration
+	enum class Command;
+	enum class Cell : u16;
+	struct Map;
+	struct MapInfo;
+
+	//-----------------------------------------------------------------------------
+	//! ǂݍ񂾒̔Ֆʂ𒲂ׁAƕςȂ mapInfo ɏ
+	//! ȂA₪瓮ȂȂA{bgȂZAłȂ_A
+	//! tgɓ͂BǂՖʂ̑傫ɔႷ鎞Ԃŋ߂
+	//-----------------------------------------------------------------------------
+	void analyzeMap(const Map& map, MapInfo& mapInfo);
+
+	//-----------------------------------------------------------------------------
+	//! cmd ŉɉ₪A₪瓮ȂȂɓ邩
+	//! ͂ĂȂՖʂł͏false
+	//-----------------------------------------------------------------------------
+	bool pushesIntoDeadCorner(const Map& map, Command cmd);
+
+	//-----------------------------------------------------------------------------
+	//! (x, y) ɂZ c AxƉłȂ_K₩
+	//! ͂ŕ̂ɉāAɉ܂ꂽK͗Ȃ̂Ń_ɂȂȂ
+	//-----------------------------------------------------------------------------
+	bool isDeadLambda(const MapInfo& mapInfo, Cell c, s32 x, s32 y);
+
+	//-----------------------------------------------------------------------------
+	//! ͌ʂ̕ۑBՖʂ̑傫͎Ȃ̂ŁA͔ՖʂWJɍs
+	//-----------------------------------------------------------------------------
+	void packAnalysis(const MapInfo& mapInfo, std::vector<u8>& out);
+	bool unpackAnalysis(const u8*& p, const u8* end, const Map& map, MapInfo& mapInfo);
+
+}
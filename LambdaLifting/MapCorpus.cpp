@@ -0,0 +1,375 @@
+//
+// Map Corpus
+//
+
+#include "stdafx.h"
+#include "MapCorpus.h"
+
+#include "Map.h"
+#include "Simulator.h"
+#include "MapAnalysis.h"
+#include "FileUtil.h"
+#include "Hash.h"
+
+namespace {
+
+	const u32 kMagic = 0x434D4C4C;	// "LLMC"
+	const u32 kVersion = 2;	// 2: ÓI͂̌ʂۑ
+
+	//! @struct CacheHeader
+	struct CacheHeader
+	{
+		u32 magic;
+		u32 version;
+		u32 count;
+		u32 reserved;
+		u64 pathOffset;
+		u64 dataOffset;
+	};
+
+	//! @struct CacheRecord
+	struct CacheRecord
+	{
+		u64 hash;
+		u64 fileSize;
+		u64 writeTime;
+		u32 width;
+		u32 height;
+		u32 lambda;
+		u32 flags;
+		u32 pathOffset;
+		u32 pathLength;
+		u32 dataOffset;
+		u32 dataSize;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! }bvt@C
+	//-----------------------------------------------------------------------------
+	bool isMapFile(const s3d::FilePath& filepath)
+	{
+		const s3d::String ext = s3d::FileSystem::Extension(filepath).lowercased();
+		return ext == L"txt" || ext == L"map";
+	}
+
+	//-----------------------------------------------------------------------------
+	//! tO𒲂ׂ
+	//-----------------------------------------------------------------------------
+	u32 flagsOfMap(const app::MapInfo& mapInfo, const app::Map& map)
+	{
+		using namespace app;
+
+		u32 flags = 0;
+		if (mapInfo.flooding > 0)
+			flags |= CORPUS_FLOODING;
+		if (map.beard > 0 || map.razor > 0)
+			flags |= CORPUS_BEARD;
+
+		for (auto y : s3d::step(map.cell.height)) {
+			for (auto x : s3d::step(map.cell.width)) {
+				const Cell c = cellType(map.cell[y][x]);
+				if (c == Cell::Trampoline)
+					flags |= CORPUS_TRAMPOLINE;
+				else if (c == Cell::HORock)
+					flags |= CORPUS_HOROCK;
+				else if (c == Cell::Razor)
+					flags |= CORPUS_BEARD;
+			}
+		}
+		return flags;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	MapCorpus::MapCorpus()
+		: mDataOffset(0)
+		, mParsedNum(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	MapCorpus::~MapCorpus()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! LbVt@CJ
+	//-----------------------------------------------------------------------------
+	bool MapCorpus::open(const s3d::FilePath& cachePath)
+	{
+		close();
+
+		if (!mFile.open(cachePath))
+			return false;
+
+		const u8* p = mFile.data();
+		const u64 size = mFile.size();
+
+		CacheHeader header;
+		if (size < sizeof(header)) {
+			close();
+			return false;
+		}
+		std::memcpy(&header, p, sizeof(header));
+
+		if (header.magic != kMagic || header.version != kVersion ||
+			sizeof(header) + static_cast<u64>(header.count) * sizeof(CacheRecord) > header.pathOffset ||
+			header.pathOffset > header.dataOffset || header.dataOffset > size)
+		{
+			// Â`ꂽLbV͎gȂ
+			close();
+			return false;
+		}
+
+		const wchar_t* paths = reinterpret_cast<const wchar_t*>(p + header.pathOffset);
+		const u64 pathNum = (header.dataOffset - header.pathOffset) / sizeof(wchar_t);
+		const u64 dataSize = size - header.dataOffset;
+
+		mEntries.resize(header.count);
+		for (u32 i = 0; i < header.count; ++i) {
+			CacheRecord r;
+			std::memcpy(&r, p + sizeof(header) + i * sizeof(CacheRecord), sizeof(r));
+
+			if (static_cast<u64>(r.pathOffset) + r.pathLength > pathNum ||
+				static_cast<u64>(r.dataOffset) + r.dataSize > dataSize)
+			{
+				close();
+				return false;
+			}
+
+			CorpusEntry& e = mEntries[i];
+			e.filepath = s3d::String(std::wstring(paths + r.pathOffset, r.pathLength));
+			e.hash = r.hash;
+			e.fileSize = r.fileSize;
+			e.writeTime = r.writeTime;
+			e.width = r.width;
+			e.height = r.height;
+			e.lambda = r.lambda;
+			e.flags = r.flags;
+			e.offset = r.dataOffset;
+			e.size = r.dataSize;
+
+			mIndex[e.filepath.str()] = i;
+		}
+
+		mDataOffset = header.dataOffset;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! fBNg𑖍ăLbVXV
+	//! TCYƍXVςĂȂΑỎ͌ʂg񂵁A
+	//! ςĂĂenbVȂĉ͂Ȃ
+	//-----------------------------------------------------------------------------
+	bool MapCorpus::update(const s3d::FilePath& directory, const s3d::FilePath& cachePath)
+	{
+		open(cachePath);
+		mParsedNum = 0;
+		mFailedPaths.clear();
+
+		s3d::Array<CorpusEntry> entries;
+		std::vector<u8> blob;
+
+		for (const auto& path : s3d::FileSystem::DirectoryContents(directory)) {
+			if (!isMapFile(path))
+				continue;
+
+			const s3d::FilePath filepath = s3d::FileSystem::FullPath(path);
+
+			FileStat stat;
+			if (!statFile(filepath, stat))
+				continue;
+
+			const auto it = mIndex.find(filepath.str());
+			const CorpusEntry* prev = it != mIndex.end() ? &mEntries[it->second] : nullptr;
+
+			CorpusEntry e;
+			bool reuse = false;
+			if (prev && prev->fileSize == stat.size && prev->writeTime == stat.writeTime) {
+				e = *prev;
+				reuse = true;
+			} else {
+				s3d::TextReader r(filepath);
+				if (!r.isOpened())
+					continue;
+
+				const s3d::String s = r.readContents();
+				const u64 hash = hashBytes(s.c_str(), s.length * sizeof(s3d::wchar));
+
+				if (prev && prev->hash == hash) {
+					e = *prev;
+					reuse = true;
+				} else {
+					MapInfo mapInfo;
+					Map map;
+					map.info = &mapInfo;
+					if (!Simulator::parseMap(s, mapInfo, map)) {
+						mFailedPaths.push_back(filepath);
+						continue;
+					}
+					analyzeMap(map, mapInfo);
+
+					std::vector<u8> packed;
+					packMapInfo(mapInfo, packed);
+					packMap(map, packed);
+					packAnalysis(mapInfo, packed);
+
+					e.filepath = filepath;
+					e.hash = hash;
+					e.width = map.cell.width;
+					e.height = map.cell.height;
+					e.lambda = map.lambda;
+					e.flags = flagsOfMap(mapInfo, map);
+					e.offset = static_cast<u32>(blob.size());
+					e.size = static_cast<u32>(packed.size());
+					blob.insert(blob.end(), packed.begin(), packed.end());
+					mParsedNum++;
+				}
+				e.fileSize = stat.size;
+				e.writeTime = stat.writeTime;
+			}
+
+			// ÕLbVf[^ڂ
+			if (reuse) {
+				const u8* p = data(*prev);
+				e.offset = static_cast<u32>(blob.size());
+				blob.insert(blob.end(), p, p + prev->size);
+			}
+
+			entries.push_back(e);
+		}
+
+		// VLbVočւ
+		const s3d::FilePath tmpPath = cachePath + L".tmp";
+		const bool written = write(tmpPath, entries, blob);
+		close();
+
+		if (!written || !replaceFile(tmpPath, cachePath))
+			return false;
+
+		return open(cachePath);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	void MapCorpus::close()
+	{
+		mFile.close();
+		mDataOffset = 0;
+		mEntries.clear();
+		mIndex.clear();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! t@CpX猟
+	//! ΃pXł悤ɁALbVɂ͐΃pXŋL^Ă
+	//-----------------------------------------------------------------------------
+	s3d::Optional<u32> MapCorpus::find(const s3d::FilePath& filepath) const
+	{
+		const auto it = mIndex.find(s3d::FileSystem::FullPath(filepath).str());
+		if (it == mIndex.end())
+			return s3d::none;
+		return it->second;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! LbVĂ}bvt@CςĂȂ
+	//! update ɊJLbVgƂɁAÂ͌ʂgȂ悤m߂
+	//-----------------------------------------------------------------------------
+	bool MapCorpus::isCurrent(u32 index) const
+	{
+		if (index >= mEntries.size())
+			return false;
+
+		const CorpusEntry& e = mEntries[index];
+		FileStat stat;
+		return statFile(e.filepath, stat) && stat.size == e.fileSize && stat.writeTime == e.writeTime;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! }bvǂݍ
+	//-----------------------------------------------------------------------------
+	bool MapCorpus::loadMap(u32 index, struct MapInfo& mapInfo, struct Map& map) const
+	{
+		if (index >= mEntries.size())
+			return false;
+
+		const CorpusEntry& e = mEntries[index];
+		const u8* p = data(e);
+		const u8* end = p + e.size;
+
+		mapInfo.clear();
+		map.clear();
+		map.info = &mapInfo;
+
+		// ͌ʂ̂̂g
+		return unpackMapInfo(p, end, mapInfo) && unpackMap(p, end, map) && unpackAnalysis(p, end, map, mapInfo);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ͍ς݃f[^擾
+	//-----------------------------------------------------------------------------
+	const u8* MapCorpus::data(const CorpusEntry& e) const
+	{
+		return mFile.data() + mDataOffset + e.offset;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! LbVt@Co
+	//-----------------------------------------------------------------------------
+	bool MapCorpus::write(const s3d::FilePath& cachePath, const s3d::Array<CorpusEntry>& entries, const std::vector<u8>& blob) const
+	{
+		std::vector<CacheRecord> records(entries.size());
+		std::wstring paths;
+
+		for (size_t i = 0; i < entries.size(); ++i) {
+			const CorpusEntry& e = entries[i];
+			CacheRecord& r = records[i];
+			r.hash = e.hash;
+			r.fileSize = e.fileSize;
+			r.writeTime = e.writeTime;
+			r.width = e.width;
+			r.height = e.height;
+			r.lambda = e.lambda;
+			r.flags = e.flags;
+			r.pathOffset = static_cast<u32>(paths.length());
+			r.pathLength = e.filepath.length;
+			r.dataOffset = e.offset;
+			r.dataSize = e.size;
+			paths += e.filepath.str();
+		}
+
+		CacheHeader header;
+		header.magic = kMagic;
+		header.version = kVersion;
+		header.count = static_cast<u32>(records.size());
+		header.reserved = 0;
+		header.pathOffset = sizeof(header) + records.size() * sizeof(CacheRecord);
+		header.dataOffset = header.pathOffset + paths.length() * sizeof(wchar_t);
+
+		s3d::BinaryWriter w(cachePath);
+		if (!w.isOpened())
+			return false;
+
+		w.write(&header, sizeof(header));
+		if (!records.empty())
+			w.write(records.data(), records.size() * sizeof(CacheRecord));
+		if (!paths.empty())
+			w.write(paths.data(), paths.length() * sizeof(wchar_t));
+		if (!blob.empty())
+			w.write(blob.data(), blob.size());
+		w.close();
+		return true;
+	}
+
+}
@@ -0,0 +1,85 @@
+//
+// Map Corpus
+//
+
+#pragma once
+
+#include <unordered_map>
+
+#include "MappedFile.h"
+
+namespace app
+{
+
+	// Forward declaration
+	struct Map;
+	struct MapInfo;
+
+	//===================================================================================
+	// Corpus Flag
+	//===================================================================================
+	static const u32 CORPUS_FLOODING	= 1 << 0;
+	static const u32 CORPUS_BEARD		= 1 << 1;
+	static const u32 CORPUS_TRAMPOLINE	= 1 << 2;
+	static const u32 CORPUS_HOROCK		= 1 << 3;
+
+	//===================================================================================
+	//! @struct CorpusEntry
+	//===================================================================================
+	struct CorpusEntry
+	{
+		s3d::FilePath filepath;
+		u64 hash;
+		u64 fileSize;
+		u64 writeTime;
+		u32 width;
+		u32 height;
+		u32 lambda;
+		u32 flags;
+
+		// LbV͍̉ς݃f[^
+		u32 offset;
+		u32 size;
+	};
+
+	//===================================================================================
+	//! @class MapCorpus
+	//! fBNg̃}bv͍ς݂̌`ŃLbVt@Cɕێ
+	//===================================================================================
+	class MapCorpus
+	{
+	public:
+		MapCorpus();
+		~MapCorpus();
+
+		bool open(const s3d::FilePath& cachePath);
+		bool update(const s3d::FilePath& directory, const s3d::FilePath& cachePath);
+
+		void close();
+
+		u32 size() const { return static_cast<u32>(mEntries.size()); }
+		const CorpusEntry& entry(u32 index) const { return mEntries[index]; }
+		s3d::Optional<u32> find(const s3d::FilePath& filepath) const;
+		bool isCurrent(u32 index) const;
+
+		bool loadMap(u32 index, struct MapInfo& mapInfo, struct Map& map) const;
+
+		u32 getParsedNum() const { return mParsedNum; }
+
+		//! O update œǂ߂Ȃ}bv
+		const s3d::Array<s3d::FilePath>& getFailedPaths() const { return mFailedPaths; }
+
+	private:
+		const u8* data(const CorpusEntry& e) const;
+		bool write(const s3d::FilePath& cachePath, const s3d::Array<CorpusEntry>& entries, const std::vector<u8>& blob) const;
+
+	private:
+		MappedFile mFile;
+		u64 mDataOffset;
+		s3d::Array<CorpusEntry> mEntries;
+		std::unordered_map<std::wstring, u32> mIndex;
+		u32 mParsedNum;
+		s3d::Array<s3d::FilePath> mFailedPaths;
+	};
+
+}
@@ -0,0 +1,231 @@
+//
+// Mapped File
+//
+
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace app
+{
+
+#ifdef _WIN32
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	MappedFile::MappedFile()
+		: mFile(INVALID_HANDLE_VALUE)
+		, mMapping(nullptr)
+		, mpData(nullptr)
+		, mSize(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ǂݍݐpŊJ
+	//-----------------------------------------------------------------------------
+	bool MappedFile::open(const s3d::FilePath& filepath)
+	{
+		close();
+
+		mFile = ::CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!::GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		return map(false, static_cast<u64>(size.QuadPart));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ǂݏ\ŊJ
+	//! t@C΍쐬AsizeɖȂΊg
+	//-----------------------------------------------------------------------------
+	bool MappedFile::create(const s3d::FilePath& filepath, u64 size)
+	{
+		close();
+
+		if (size == 0)
+			return false;
+
+		mFile = ::CreateFileW(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		return map(true, size);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	void MappedFile::close()
+	{
+		if (mpData) {
+			::UnmapViewOfFile(mpData);
+			mpData = nullptr;
+		}
+		if (mMapping) {
+			::CloseHandle(mMapping);
+			mMapping = nullptr;
+		}
+		if (mFile != INVALID_HANDLE_VALUE) {
+			::CloseHandle(mFile);
+			mFile = INVALID_HANDLE_VALUE;
+		}
+		mSize = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! }bsO
+	//-----------------------------------------------------------------------------
+	bool MappedFile::map(bool writable, u64 size)
+	{
+		const DWORD protect = writable ? PAGE_READWRITE : PAGE_READONLY;
+		const DWORD access = writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+
+		mMapping = ::CreateFileMappingW(mFile, nullptr, protect, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+		if (!mMapping) {
+			close();
+			return false;
+		}
+
+		mpData = static_cast<u8*>(::MapViewOfFile(mMapping, access, 0, 0, static_cast<SIZE_T>(size)));
+		if (!mpData) {
+			close();
+			return false;
+		}
+
+		mSize = size;
+		return true;
+	}
+
+#else
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//! mFile ɂ̓t@CLqq1𑫂ēAnullptr ԂƂBmMapping ͎gȂ
+	//-----------------------------------------------------------------------------
+	MappedFile::MappedFile()
+		: mFile(nullptr)
+		, mMapping(nullptr)
+		, mpData(nullptr)
+		, mSize(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ǂݍݐpŊJ
+	//-----------------------------------------------------------------------------
+	bool MappedFile::open(const s3d::FilePath& filepath)
+	{
+		close();
+
+		const int fd = ::open(filepath.narrow().c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		mFile = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+
+		struct ::stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+			close();
+			return false;
+		}
+
+		return map(false, static_cast<u64>(st.st_size));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ǂݏ\ŊJ
+	//! t@C΍쐬AsizeɖȂΊg
+	//-----------------------------------------------------------------------------
+	bool MappedFile::create(const s3d::FilePath& filepath, u64 size)
+	{
+		close();
+
+		if (size == 0)
+			return false;
+
+		const int fd = ::open(filepath.narrow().c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+		mFile = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+
+		struct ::stat st;
+		if (::fstat(fd, &st) != 0 || (static_cast<u64>(st.st_size) < size && ::ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+			close();
+			return false;
+		}
+
+		return map(true, size);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	void MappedFile::close()
+	{
+		if (mpData) {
+			::munmap(mpData, static_cast<size_t>(mSize));
+			mpData = nullptr;
+		}
+		if (mFile) {
+			::close(static_cast<int>(reinterpret_cast<intptr_t>(mFile) - 1));
+			mFile = nullptr;
+		}
+		mSize = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! }bsO
+	//-----------------------------------------------------------------------------
+	bool MappedFile::map(bool writable, u64 size)
+	{
+		const int fd = static_cast<int>(reinterpret_cast<intptr_t>(mFile) - 1);
+		const int protect = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+
+		void* p = ::mmap(nullptr, static_cast<size_t>(size), protect, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			close();
+			return false;
+		}
+
+		mpData = static_cast<u8*>(p);
+		mSize = size;
+		return true;
+	}
+
+#endif
+
+}
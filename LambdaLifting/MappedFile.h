@@ -0,0 +1,43 @@
+//
+// Mapped File
+//
+
+#pragma once
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class MappedFile
+	//===================================================================================
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool open(const s3d::FilePath& filepath);
+		bool create(const s3d::FilePath& filepath, u64 size);
+
+		void close();
+
+		bool isOpened() const { return mpData != nullptr; }
+
+		u8* data() { return mpData; }
+		const u8* data() const { return mpData; }
+		u64 size() const { return mSize; }
+
+	private:
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool map(bool writable, u64 size);
+
+	private:
+		void* mFile;
+		void* mMapping;
+		u8* mpData;
+		u64 mSize;
+	};
+
+}
@@ -0,0 +1,209 @@
+//
+// Portfolio
+//
+
+#include "stdafx.h"
+#include "Portfolio.h"
+
+#include <csignal>
+#include <thread>
+
+#include "Replay.h"
+
+namespace {
+
+	// SIGINT 󂯂Bnhł͂𗧂Ă邾ɂ
+	volatile std::sig_atomic_t gInterrupted = 0;
+
+	// ҋ@Ɋ荞݂ƐԂm߂Ԋu [ms]
+	static const u32 POLL_INTERVAL = 1;
+
+	//-----------------------------------------------------------------------------
+	//! SIGINT nh
+	//-----------------------------------------------------------------------------
+	extern "C" void onInterrupt(int)
+	{
+		gInterrupted = 1;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+#pragma region BestRouteSlot
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	BestRouteSlot::BestRouteSlot(const Map& initial)
+		: mInitial(initial)
+		, mBest(nullptr)
+		, mEntries(nullptr)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	BestRouteSlot::~BestRouteSlot()
+	{
+		Entry* entry = mEntries.load();
+		while (entry) {
+			Entry* next = entry->next;
+			delete entry;
+			entry = next;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [go^
+	//! Simulator::step ōĐAvCŏIȂ璆f̃{[iXׂ 'A' t
+	//! ŗǂXVꍇtrueԂ
+	//-----------------------------------------------------------------------------
+	bool BestRouteSlot::offer(const s3d::String& route)
+	{
+		Map map = mInitial;
+		replayRoute(route, map);
+
+		const s32 score = finalScore(map);
+		Entry* best = mBest.load();
+		if (best && score <= best->score)
+			return false;
+
+		Entry* entry = new Entry;
+		entry->score = score;
+		entry->route = route;
+		entry->next = nullptr;
+		if (map.condition == Condition::Playing && score > map.score) {
+			entry->route += charOfCommand(Command::Abort);
+		}
+
+		// ̃Xbhɗǂ[gu߂
+		do {
+			if (best && score <= best->score) {
+				delete entry;
+				return false;
+			}
+		} while (!mBest.compare_exchange_weak(best, entry));
+
+		entry->next = mEntries.load();
+		while (!mEntries.compare_exchange_weak(entry->next, entry)) {}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŗǃXRA
+	//-----------------------------------------------------------------------------
+	s32 BestRouteSlot::getScore() const
+	{
+		const Entry* best = mBest.load();
+		return best ? best->score : finalScore(mInitial);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŗǃ[gƂ̃XRAB[g͕KvȂ疖 'A' tĂ
+	//-----------------------------------------------------------------------------
+	void BestRouteSlot::load(s3d::String& route, s32& score) const
+	{
+		const Entry* best = mBest.load();
+		if (best) {
+			route = best->route;
+			score = best->score;
+		} else {
+			route.clear();
+			score = finalScore(mInitial);
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region Portfolio
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	Portfolio::Portfolio()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	Portfolio::~Portfolio()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! \o[ǉ
+	//-----------------------------------------------------------------------------
+	void Portfolio::add(std::unique_ptr<Solver> solver)
+	{
+		mSolvers.push_back(std::move(solver));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ׂẴ\o[𑖂点
+	//! ԁASIGINTAS\o[̏Îꂩ emit ĂсǍŃ\o[~߂
+	//! seconds 0ȉȂ琧ԂȂ
+	//-----------------------------------------------------------------------------
+	void Portfolio::run(const Map& map, f64 seconds, const EmitCallback& emit)
+	{
+		BestRouteSlot slot(map);
+
+		gInterrupted = 0;
+		auto* const prevHandler = std::signal(SIGINT, onInterrupt);
+
+		SolverContext timer;
+		timer.setTimeLimit(seconds);
+
+		std::vector<std::unique_ptr<SolverContext>> contexts;
+		std::vector<std::thread> threads;
+		std::atomic<u32> runningNum(static_cast<u32>(mSolvers.size()));
+		std::atomic<bool> emitted(false);
+
+		for (auto& solver : mSolvers) {
+			contexts.emplace_back(new SolverContext);
+			SolverContext& ctx = *contexts.back();
+			ctx.setTimeLimit(seconds);
+
+			const s3d::wchar* name = solver->getName();
+			ctx.setImproveCallback([this, &slot, &timer, &emitted, name](const s3d::String& route, s32) {
+				if (slot.offer(route) && mImproveCallback && !emitted) {
+					mImproveCallback(name, slot.getScore(), timer.getElapsed());
+				}
+			});
+
+			Solver* p = solver.get();
+			threads.push_back(std::thread([p, &map, &ctx, &runningNum] {
+				p->solve(map, ctx);
+				runningNum--;
+			}));
+		}
+
+		while (!gInterrupted && runningNum > 0 && !timer.isCancelled()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL));
+		}
+
+		// ɏo͂Ă~߂B\o[~܂܂łɂ͎Ԃ肤
+		s3d::String route;
+		s32 score;
+		slot.load(route, score);
+		emitted = true;
+		emit(route, score, gInterrupted != 0);
+
+		for (auto& ctx : contexts) {
+			ctx->cancel();
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		std::signal(SIGINT, prevHandler == SIG_ERR ? SIG_DFL : prevHandler);
+	}
+
+#pragma endregion
+
+}
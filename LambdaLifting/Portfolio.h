@@ -0,0 +1,76 @@
+//
+// Portfolio
+//
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "Map.h"
+#include "Solver.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class BestRouteSlot
+	//! ŗǃ[g̒uBbN炸ɓo^Aǂݏoł
+	//! o^ɏՖʂĐăXRA߁Af 'A' tĂ
+	//! ǂݏoÂGgĂĂ悢悤ɁAGg͔j܂ŉȂ
+	//===================================================================================
+	class BestRouteSlot
+	{
+	public:
+		explicit BestRouteSlot(const Map& initial);
+		~BestRouteSlot();
+
+		bool offer(const s3d::String& route);
+
+		s32 getScore() const;
+		void load(s3d::String& route, s32& score) const;
+
+	private:
+		BestRouteSlot(const BestRouteSlot&) = delete;
+		BestRouteSlot& operator=(const BestRouteSlot&) = delete;
+
+		struct Entry
+		{
+			s32 score;
+			s3d::String route;
+			Entry* next;
+		};
+
+	private:
+		const Map mInitial;
+		std::atomic<Entry*> mBest;
+		std::atomic<Entry*> mEntries;	// mۂGg̃Xg
+	};
+
+	//===================================================================================
+	//! @class Portfolio
+	//! ̃\o[𓯂Ԃŕsɑ点AP BestRouteSlot ɏW߂
+	//! Ԃ SIGINT ŁA\o[̏I҂ɍŗǃ[go͂
+	//===================================================================================
+	class Portfolio
+	{
+	public:
+		using EmitCallback = std::function<void(const s3d::String& route, s32 score, bool interrupted)>;
+		using ImproveCallback = std::function<void(const s3d::wchar* solverName, s32 score, f64 elapsed)>;
+
+		Portfolio();
+		~Portfolio();
+
+		void add(std::unique_ptr<Solver> solver);
+
+		void run(const Map& map, f64 seconds, const EmitCallback& emit);
+
+		void setImproveCallback(const ImproveCallback& callback){ mImproveCallback = callback; }
+
+	private:
+		std::vector<std::unique_ptr<Solver>> mSolvers;
+		ImproveCallback mImproveCallback;
+	};
+
+}
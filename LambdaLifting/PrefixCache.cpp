@@ -0,0 +1,428 @@
+//
+// Prefix Cache
+//
+
+#include "stdafx.h"
+#include "PrefixCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "Simulator.h"
+
+namespace {
+
+	// ؂̎q̕
+	static const app::Command COMMANDS[] = {
+		app::Command::Up,
+		app::Command::Down,
+		app::Command::Left,
+		app::Command::Right,
+		app::Command::Wait,
+		app::Command::Abort,
+		app::Command::Shave,
+	};
+
+	//-----------------------------------------------------------------------------
+	//! R}h̎q̔ԍ
+	//-----------------------------------------------------------------------------
+	inline u32 childIndexOf(app::Command cmd)
+	{
+		switch (cmd) {
+		case app::Command::Up:		return 0;
+		case app::Command::Down:	return 1;
+		case app::Command::Left:	return 2;
+		case app::Command::Right:	return 3;
+		case app::Command::Wait:	return 4;
+		case app::Command::Abort:	return 5;
+		default:					return 6;
+		}
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	PrefixCache::PrefixCache(const Map& initial, size_t memoryMax, u32 interval)
+		: mInitial(initial)
+		, mMemoryMax(memoryMax)
+		, mInterval(std::max(1u, interval))
+		, mDepthMax(1 << 16)
+	{
+		clear();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	PrefixCache::~PrefixCache()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ɂ
+	//-----------------------------------------------------------------------------
+	void PrefixCache::clear()
+	{
+		mNodes.resize(1);
+		Node& root = mNodes[0];
+		root.parent = NONE;
+		for (u32 k = 0; k < COMMAND_NUM; ++k) {
+			root.child[k] = NONE;
+		}
+		root.prev = root.next = NONE;
+		root.snapshot = 0;
+		root.depth = 0;
+		root.score = finalScore(mInitial);
+		root.cmd = 0;
+		root.childNum = 0;
+		root.final = mInitial.condition != Condition::Playing;
+		mFreeNodes.clear();
+
+		mSnapshots.resize(1);
+		mSnapshots[0] = mInitial;
+		mFreeSnapshots.clear();
+
+		// LRUXgɓȂ
+		mLruHead = mLruTail = NONE;
+
+		std::memset(&mStats, 0, sizeof(mStats));
+		mStats.nodeNum = 1;
+		mStats.snapshotNum = 1;
+		mStats.bytes = sizeof(Node) + snapshotBytes();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [g̓_
+	//! ʂ replayRoute ƓɂȂ
+	//-----------------------------------------------------------------------------
+	s32 PrefixCache::evaluate(const s3d::String& route, Map& map)
+	{
+		size_t pos = 0;
+		walk([&](Command& cmd) {
+			while (pos < route.length) {
+				cmd = commandOfChar(route[pos++]);
+				if (cmd != Command::None)
+					return true;
+			}
+			return false;
+		}, [](u64, s32, bool) {}, map);
+		return finalScore(map);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xg[ǂ݂Ȃ̓_
+	//! ʂ replayStream ƓɂȂ
+	//-----------------------------------------------------------------------------
+	ReplayResult PrefixCache::evaluate(RouteReader& reader, Map& map)
+	{
+		const u64 count = walk([&](Command& cmd) { return reader.read(cmd); }, [](u64, s32, bool) {}, map);
+
+		ReplayResult result;
+		result.score = map.score;
+		result.condition = map.condition;
+		result.stepCount = map.stepCount;
+		result.lambdaCollected = map.lambdaCollected;
+		result.commandCount = count;
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [g̓_Ar̍ō_߂
+	//! ؂H͋L^XRAĝŁAՖʂ𕜌Ȃ
+	//-----------------------------------------------------------------------------
+	u32 PrefixCache::evaluate(const s3d::String& route, Map& map, Peak& peak)
+	{
+		peak.score = mNodes[0].score;
+		peak.length = 0;
+		peak.abort = !mNodes[0].final;
+
+		size_t pos = 0;
+		const u64 count = walk([&](Command& cmd) {
+			while (pos < route.length) {
+				cmd = commandOfChar(route[pos++]);
+				if (cmd != Command::None)
+					return true;
+			}
+			return false;
+		}, [&](u64 length, s32 score, bool playing) {
+			if (score > peak.score) {
+				peak.score = score;
+				peak.length = static_cast<u32>(length);
+				peak.abort = playing;
+			}
+		}, map);
+		return static_cast<u32>(count);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! L^ς݂̔ՖʂT
+	//! ؂Ȃ̂ŁALRȔԂςȂ
+	//-----------------------------------------------------------------------------
+	u32 PrefixCache::seek(const s3d::String& route, u32 length, Map& map) const
+	{
+		u32 node = 0;
+		u32 found = 0;
+		for (u32 i = 0; i < length && i < route.length; ++i) {
+			node = mNodes[node].child[childIndexOf(commandOfChar(route[i]))];
+			if (node == NONE)
+				break;
+			if (mNodes[node].snapshot != NONE) {
+				found = node;
+			}
+		}
+
+		map = mSnapshots[mNodes[found].snapshot];
+		return mNodes[found].depth;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ܂Ƃ߂č̓_
+	//-----------------------------------------------------------------------------
+	void PrefixCache::evaluate(const s3d::Array<s3d::String>& routes, std::vector<s32>& scores)
+	{
+		std::vector<u32> order(routes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](u32 a, u32 b) { return routes[a] < routes[b]; });
+
+		scores.resize(routes.size());
+		Map map;
+		for (const u32 i : order) {
+			scores[i] = evaluate(routes[i], map);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ؂HȂR}hs
+	//! ؂ɖR}hɗA̎O̔Ֆʂ𕜌Aȍ~͎sȂ؂ɉ
+	//! visit ɂ͓ǂ񂾃R}h̐ƁA̎_̍ŏIXRAƃvCn
+	//! ߂l͓ǂ񂾃R}h̐
+	//-----------------------------------------------------------------------------
+	template<class Source, class Visit>
+	u64 PrefixCache::walk(Source next, Visit visit, Map& map)
+	{
+		mPath.clear();
+		mStats.routeNum++;
+
+		u32 node = 0;
+		bool live = false;	// map  node ̔ՖʂɂȂĂ
+		u64 count = 0;
+		Command cmd;
+		for (;;)
+		{
+			const bool playing = live ? map.condition == Condition::Playing : !mNodes[node].final;
+			if (!playing || !next(cmd))
+				break;
+			count++;
+
+			const u32 k = childIndexOf(cmd);
+			if (!live) {
+				const u32 child = mNodes[node].child[k];
+				if (child != NONE) {
+					node = child;
+					mPath.push_back(node);
+					mStats.hitNum++;
+					visit(count, mNodes[node].score, !mNodes[node].final);
+					continue;
+				}
+				restore(node, map);
+				live = true;
+			}
+
+			Simulator::step(cmd, map, mScratch);
+			mStats.stepNum++;
+			visit(count, finalScore(map), map.condition == Condition::Playing);
+
+			// [Ƃ͋L^Ɏs
+			if (node != NONE && mNodes[node].depth < mDepthMax) {
+				node = insert(node, k, map);
+				mPath.push_back(node);
+			} else {
+				node = NONE;
+			}
+		}
+		mStats.commandNum += count;
+
+		if (!live) {
+			restore(node, map);
+		}
+
+		// [gx̓_鎞ɁArsȂčςނ悤I̔Ֆʂ
+		if (node != NONE && mNodes[node].snapshot == NONE) {
+			attachSnapshot(node, map);
+		}
+
+		touch(mPath);
+		evict();
+		return count;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! node ̔Ֆʂ map ɕ
+	//! ՖʂŊ̑c悩AԂ̃R}hs
+	//-----------------------------------------------------------------------------
+	void PrefixCache::restore(u32 node, Map& map)
+	{
+		mReplay.clear();
+		while (mNodes[node].snapshot == NONE) {
+			mReplay.push_back(static_cast<Command>(mNodes[node].cmd));
+			node = mNodes[node].parent;
+		}
+
+		map = mSnapshots[mNodes[node].snapshot];
+		for (auto it = mReplay.rbegin(); it != mReplay.rend(); ++it) {
+			Simulator::step(*it, map, mScratch);
+			mStats.stepNum++;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! parent  k Ԗڂ̎qBmap ͂̃R}hs̔Ֆ
+	//-----------------------------------------------------------------------------
+	u32 PrefixCache::insert(u32 parent, u32 k, const Map& map)
+	{
+		u32 node;
+		if (!mFreeNodes.empty()) {
+			node = mFreeNodes.back();
+			mFreeNodes.pop_back();
+		} else {
+			node = static_cast<u32>(mNodes.size());
+			mNodes.emplace_back();
+		}
+
+		Node& n = mNodes[node];
+		n.parent = parent;
+		for (u32 i = 0; i < COMMAND_NUM; ++i) {
+			n.child[i] = NONE;
+		}
+		n.snapshot = NONE;
+		n.depth = mNodes[parent].depth + 1;
+		n.score = finalScore(map);
+		n.cmd = static_cast<u8>(COMMANDS[k]);
+		n.childNum = 0;
+		n.final = map.condition != Condition::Playing;
+
+		mNodes[parent].child[k] = node;
+		mNodes[parent].childNum++;
+		link(node);
+
+		mStats.nodeNum++;
+		mStats.bytes += sizeof(Node);
+
+		if (n.depth % mInterval == 0 || n.final) {
+			attachSnapshot(node, map);
+		}
+		return node;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! node ɔՖʂ
+	//-----------------------------------------------------------------------------
+	void PrefixCache::attachSnapshot(u32 node, const Map& map)
+	{
+		u32 snapshot;
+		if (!mFreeSnapshots.empty()) {
+			snapshot = mFreeSnapshots.back();
+			mFreeSnapshots.pop_back();
+			mSnapshots[snapshot] = map;
+		} else {
+			snapshot = static_cast<u32>(mSnapshots.size());
+			mSnapshots.push_back(map);
+		}
+		mNodes[node].snapshot = snapshot;
+
+		mStats.snapshotNum++;
+		mStats.bytes += snapshotBytes();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! gm[hLRUXg̐擪Ɉڂ
+	//! t̑ڂ̂ŁAe͏ɎqOɂA͕KtɂȂ
+	//-----------------------------------------------------------------------------
+	void PrefixCache::touch(const std::vector<u32>& path)
+	{
+		for (auto it = path.rbegin(); it != path.rend(); ++it) {
+			unlink(*it);
+			link(*it);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! memoryMax Ɏ܂܂ŁAłgĂȂt̂Ă
+	//-----------------------------------------------------------------------------
+	void PrefixCache::evict()
+	{
+		while (mStats.bytes > mMemoryMax && mLruTail != NONE)
+		{
+			const u32 node = mLruTail;
+			Node& n = mNodes[node];
+			if (n.childNum > 0)
+				break;
+
+			unlink(node);
+			Node& parent = mNodes[n.parent];
+			parent.child[childIndexOf(static_cast<Command>(n.cmd))] = NONE;
+			parent.childNum--;
+
+			if (n.snapshot != NONE) {
+				mFreeSnapshots.push_back(n.snapshot);
+				mStats.snapshotNum--;
+				mStats.bytes -= snapshotBytes();
+			}
+			mFreeNodes.push_back(node);
+			mStats.nodeNum--;
+			mStats.bytes -= sizeof(Node);
+			mStats.evictNum++;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! LRUXg̐擪ɓ
+	//-----------------------------------------------------------------------------
+	void PrefixCache::link(u32 node)
+	{
+		Node& n = mNodes[node];
+		n.prev = NONE;
+		n.next = mLruHead;
+		if (mLruHead != NONE) {
+			mNodes[mLruHead].prev = node;
+		} else {
+			mLruTail = node;
+		}
+		mLruHead = node;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! LRUXgO
+	//-----------------------------------------------------------------------------
+	void PrefixCache::unlink(u32 node)
+	{
+		Node& n = mNodes[node];
+		if (n.prev != NONE) {
+			mNodes[n.prev].next = n.next;
+		} else {
+			mLruHead = n.next;
+		}
+		if (n.next != NONE) {
+			mNodes[n.next].prev = n.prev;
+		} else {
+			mLruTail = n.prev;
+		}
+		n.prev = n.next = NONE;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ֆ1̎gp
+	//-----------------------------------------------------------------------------
+	size_t PrefixCache::snapshotBytes() const
+	{
+		return sizeof(Map) + mInitial.cell.num_elements() * sizeof(Cell);
+	}
+
+}
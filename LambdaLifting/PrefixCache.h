@@ -0,0 +1,128 @@
+//
+// Prefix Cache
+//
+
+#pragma once
+
+#include <climits>
+
+#include "Map.h"
+#include "Replay.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class PrefixCache
+	//! 1̃}bvő̃[g̓_鎞ɁAʂ̐擪̎sȂ
+	//! s[gR}hƂ̃gC؂ɋL^Ainterval 育ƂƏI̔Ֆʂ
+	//! V[g͖؂HƂ܂ŒHAŊ̔Ֆʂc肾s
+	//! memoryMax 𒴂AłgĂȂt̂Ă
+	//! bNȂ̂ŁA1̃LbV1Xbhg (seek  evaluate ƏdȂȂΕsɌĂׂ)
+	//===================================================================================
+	class PrefixCache
+	{
+	public:
+		struct Stats
+		{
+			u64 routeNum;
+			u64 commandNum;		// ̓_R}h̐
+			u64 hitNum;			// ̂؂HĎsȂ
+			u64 stepNum;		// ۂɎsXebv̐ (Ֆʂ̕܂)
+			u64 evictNum;
+			u32 nodeNum;
+			u32 snapshotNum;
+			size_t bytes;
+
+			f64 hitRate() const { return commandNum > 0 ? static_cast<f64>(hitNum) / commandNum : 0.0; }
+		};
+
+		//! rőł؂ꍇ܂߂ō_
+		struct Peak
+		{
+			s32 score;
+			u32 length;		// ł؂ʒu܂ł̃R}h
+			bool abort;		// ̈ʒuł͂܂vCȂ̂ŁAAbortt
+		};
+
+		explicit PrefixCache(const Map& initial, size_t memoryMax = 256 << 20, u32 interval = 16);
+		~PrefixCache();
+
+		void clear();
+
+		//! route s̔Ֆʂ map ɕԂB߂l͍ŏIXRA
+		s32 evaluate(const s3d::String& route, Map& map);
+		ReplayResult evaluate(RouteReader& reader, Map& map);
+
+		//! route s̔Ֆʂ map ɁAr̍ō_ peak ɕԂB߂l͎sR}h̐
+		u32 evaluate(const s3d::String& route, Map& map, Peak& peak);
+
+		//! ܂Ƃ߂č̓_BʕĎg悤AɎs
+		void evaluate(const s3d::Array<s3d::String>& routes, std::vector<s32>& scores);
+
+		//! R}hȂ route ̐擪 length ̔Ֆʂɍł߂AL^ς݂̔Ֆʂ map ɕԂ
+		//! ߂l͂̔Ֆʂ܂ł̎萔Bc͌ĂяoŎs
+		u32 seek(const s3d::String& route, u32 length, Map& map) const;
+
+		//! [R}h͖؂ɋL^Ȃ
+		void setDepthMax(u32 depth){ mDepthMax = depth; }
+
+		const Stats& getStats() const { return mStats; }
+
+	private:
+		PrefixCache(const PrefixCache&) = delete;
+		PrefixCache& operator=(const PrefixCache&) = delete;
+
+		static const u32 COMMAND_NUM = 7;
+		static const u32 NONE = UINT_MAX;
+
+		struct Node
+		{
+			u32 parent;
+			u32 child[COMMAND_NUM];
+			u32 prev;		// LRUXgB擪ŋߎgm[h
+			u32 next;
+			u32 snapshot;	// mSnapshots ̔ԍB NONE
+			u32 depth;
+			s32 score;		// ̃R}hs̍ŏIXRA
+			u8 cmd;
+			u8 childNum;
+			bool final;		// ̃R}hŃQ[I
+		};
+
+		template<class Source, class Visit>
+		u64 walk(Source next, Visit visit, Map& map);
+
+		void restore(u32 node, Map& map);
+		u32 insert(u32 parent, u32 k, const Map& map);
+		void attachSnapshot(u32 node, const Map& map);
+		void touch(const std::vector<u32>& path);
+		void evict();
+
+		void link(u32 node);
+		void unlink(u32 node);
+
+		size_t snapshotBytes() const;
+
+	private:
+		Map mInitial;
+		size_t mMemoryMax;
+		u32 mInterval;
+		u32 mDepthMax;
+
+		std::vector<Node> mNodes;		// 0 
+		std::vector<u32> mFreeNodes;
+		std::vector<Map> mSnapshots;
+		std::vector<u32> mFreeSnapshots;
+		u32 mLruHead;
+		u32 mLruTail;
+
+		// Ɨ̈
+		std::vector<u32> mPath;
+		std::vector<Command> mReplay;
+		s3d::Grid<Cell> mScratch;
+
+		Stats mStats;
+	};
+
+}
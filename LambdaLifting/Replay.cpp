@@ -0,0 +1,163 @@
+//
+// Replay
+//
+
+#include "stdafx.h"
+#include "Replay.h"
+
+#include "Map.h"
+#include "Simulator.h"
+#include "FileUtil.h"
+
+namespace {
+
+	const size_t kBufferSize = 64 * 1024;
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+#pragma region RouteReader
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	RouteReader::RouteReader()
+		: mFile(nullptr)
+		, mOwner(false)
+		, mBuffer(kBufferSize)
+		, mPos(0)
+		, mLength(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	RouteReader::~RouteReader()
+	{
+		close();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! J
+	//! "-" ̏ꍇ͕W͂ǂݍ
+	//-----------------------------------------------------------------------------
+	bool RouteReader::open(const s3d::FilePath& filepath)
+	{
+		close();
+
+		if (filepath == L"-") {
+			mFile = stdin;
+			mOwner = false;
+		} else {
+			mFile = openFile(filepath, L"rb");
+			mOwner = true;
+		}
+		return mFile != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 
+	//-----------------------------------------------------------------------------
+	void RouteReader::close()
+	{
+		if (mFile && mOwner) {
+			std::fclose(mFile);
+		}
+		mFile = nullptr;
+		mOwner = false;
+		mPos = mLength = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! R}h1ǂݍ
+	//! R}hȊO̕ (sȂ) ͓ǂݔ΂
+	//-----------------------------------------------------------------------------
+	bool RouteReader::read(Command& cmd)
+	{
+		for (;;) {
+			if (mPos == mLength && !fill())
+				return false;
+
+			cmd = commandOfChar(static_cast<s3d::wchar>(mBuffer[mPos++]));
+			if (cmd != Command::None)
+				return true;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! obt@𖄂߂
+	//-----------------------------------------------------------------------------
+	bool RouteReader::fill()
+	{
+		if (!mFile)
+			return false;
+
+		mPos = 0;
+		mLength = std::fread(mBuffer.data(), 1, mBuffer.size(), mFile);
+		return mLength > 0;
+	}
+
+#pragma endregion
+
+
+	//-----------------------------------------------------------------------------
+	//! R}hs
+	//! Simulator::runƓʂɂȂ邪A͎cȂ
+	//-----------------------------------------------------------------------------
+	void replayRoute(const s3d::String& cmds, struct Map& map)
+	{
+		for (auto c : cmds) {
+			if (map.condition != Condition::Playing)
+				break;
+
+			const Command cmd = commandOfChar(c);
+			if (cmd != Command::None) {
+				Simulator::step(cmd, map);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xg[R}hǂ݂Ȃs
+	//! gp̓[g̒ɂ炸
+	//-----------------------------------------------------------------------------
+	ReplayResult replayStream(RouteReader& reader, struct Map& map, const ReplayProgress& progress, u64 interval)
+	{
+		u64 count = 0;
+
+		Command cmd;
+		while (map.condition == Condition::Playing && reader.read(cmd)) {
+			Simulator::step(cmd, map);
+			count++;
+
+			if (progress && interval > 0 && count % interval == 0) {
+				progress(map, count);
+			}
+		}
+
+		ReplayResult result;
+		result.score = map.score;
+		result.condition = map.condition;
+		result.stepCount = map.stepCount;
+		result.lambdaCollected = map.lambdaCollected;
+		result.commandCount = count;
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŏIXRA
+	//! vCȂ炻̏Abortꍇ̃XRAԂ
+	//-----------------------------------------------------------------------------
+	s32 finalScore(const struct Map& map)
+	{
+		if (map.condition == Condition::Playing) {
+			return map.score + 25 * map.lambdaCollected;
+		}
+		return map.score;
+	}
+
+}
@@ -0,0 +1,69 @@
+//
+// Replay
+//
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+
+namespace app
+{
+
+	// Forward declaration
+	enum class Command;
+	enum class Condition : u8;
+	struct Map;
+
+	//===================================================================================
+	//! @class RouteReader
+	//! [gt@CpCvR}hǂݍ
+	//===================================================================================
+	class RouteReader
+	{
+	public:
+		RouteReader();
+		~RouteReader();
+
+		bool open(const s3d::FilePath& filepath);
+		void close();
+
+		bool isOpened() const { return mFile != nullptr; }
+
+		bool read(Command& cmd);
+
+	private:
+		RouteReader(const RouteReader&) = delete;
+		RouteReader& operator=(const RouteReader&) = delete;
+
+		bool fill();
+
+	private:
+		std::FILE* mFile;
+		bool mOwner;
+		std::vector<char> mBuffer;
+		size_t mPos;
+		size_t mLength;
+	};
+
+	//===================================================================================
+	//! @struct ReplayResult
+	//===================================================================================
+	struct ReplayResult
+	{
+		s32 score;
+		Condition condition;
+		u32 stepCount;
+		u32 lambdaCollected;
+		u64 commandCount;
+	};
+
+	using ReplayProgress = std::function<void(const struct Map& map, u64 commandCount)>;
+
+	void replayRoute(const s3d::String& cmds, struct Map& map);
+
+	ReplayResult replayStream(RouteReader& reader, struct Map& map, const ReplayProgress& progress = nullptr, u64 interval = 0);
+
+	s32 finalScore(const struct Map& map);
+
+}
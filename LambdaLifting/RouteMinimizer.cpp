@@ -0,0 +1,497 @@
+//
+// Route Minimizer
+//
+
+#include "stdafx.h"
+#include "RouteMinimizer.h"
+
+#include <chrono>
+
+#include "Simulator.h"
+#include "TaskPool.h"
+#include "Replay.h"
+#include "TourPlanner.h"
+#include "PrefixCache.h"
+#include "Hash.h"
+
+namespace {
+
+	// ]Ԃ̒BLbVɂ͂̊ԊuŔՖʂcAԂ̕]͂n߂
+	static const u32 CHECKPOINT_INTERVAL = 32;
+
+	// LbV̏B[g̔Ֆʂ邪Ã[g͖pXĝŎ̂ĂȂ
+	static const size_t CACHE_MAX = 64 << 20;
+
+	// ̂܂܍폜Ԃ̍ő咷
+	static const u32 WINDOW_MAX = 8;
+
+	// ߓT͈͂ƁA1Ŏߓ̐
+	static const u32 SHORTCUT_MAX = 64;
+	static const u32 SHORTCUT_TRY = 2;
+
+	// ύXԂ̌Ã[g̏Ԃɍ܂ő҂Xebv
+	static const u32 CONVERGE_MAX = 24;
+
+	// ̏ԂႤAŜ̍ĐŊm߂鐔
+	static const u32 VERIFY_MAX = 32;
+
+	//-----------------------------------------------------------------------------
+	//! ʂƕE̎Ֆʂ̃nbV
+	//! Z[ĝ͎ŁA^Ê}bvł悤ɂ
+	//-----------------------------------------------------------------------------
+	u64 layoutOfMap(const app::Map& map)
+	{
+		using namespace app;
+
+		const size_t size = map.cell.width * map.cell.height * sizeof(Cell);
+		u64 h = size > 0 ? hashBytes(map.cell[0], size) : FNV_OFFSET_BASIS;
+		h = hashValue(map.robotPos, h);
+		h = hashValue(map.lambdaCollected, h);
+		h = hashValue(map.condition, h);
+		h = hashValue(map.razor, h);
+		return h;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! uŒZȂR}h
+	//-----------------------------------------------------------------------------
+	template<class T>
+	inline s32 savedOf(const T& c)
+	{
+		return static_cast<s32>(c.end - c.begin) - static_cast<s32>(c.commands.length);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̗pĂ悢₩BXRAオ邩A_ŒZȂ
+	//-----------------------------------------------------------------------------
+	template<class T>
+	inline bool isAcceptable(const T& c)
+	{
+		return c.end > c.begin && (c.gain > 0 || (c.gain == 0 && savedOf(c) > 0));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! a ̕ǂ₩
+	//-----------------------------------------------------------------------------
+	template<class T>
+	inline bool isBetter(const T& a, const T& b)
+	{
+		if (a.gain != b.gain)
+			return a.gain > b.gain;
+		if (savedOf(a) != savedOf(b))
+			return savedOf(a) > savedOf(b);
+		return a.exact && !b.exact;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	RouteMinimizer::RouteMinimizer(u32 threadNum)
+		: mThreadNum(threadNum)
+		, mTimeLimit(0.0)
+		, mPass(0)
+		, mCandidateNum(0)
+		, mFinalScore(0)
+		, mTrampoline(false)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	RouteMinimizer::~RouteMinimizer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [gZ
+	//! 1pXőSʒǔɕ]AdȂȂ̂܂Ƃ߂č̗p
+	//! ̗p͏ԂL^A̗płȂȂ܂ŌJԂ
+	//-----------------------------------------------------------------------------
+	s3d::String RouteMinimizer::minimize(const Map& initial, const s3d::String& route)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		mPass = 0;
+		mCandidateNum = 0;
+
+		// R}hȊO̕ƃQ[ĨR}ĥĂ
+		// Abort͍Ōɕt
+		mRoute.clear();
+		{
+			Map map = initial;
+			s3d::Grid<Cell> scratch;
+			for (auto c : route) {
+				const Command cmd = commandOfChar(c);
+				if (cmd == Command::None)
+					continue;
+				if (cmd == Command::Abort || map.condition != Condition::Playing)
+					break;
+				Simulator::step(cmd, map, scratch);
+				mRoute += charOfCommand(cmd);
+			}
+		}
+
+		mTrampoline = false;
+		for (auto y : s3d::step(initial.cell.height)) {
+			for (auto x : s3d::step(initial.cell.width)) {
+				mTrampoline |= cellType(initial.cell[y][x]) == Cell::Trampoline;
+			}
+		}
+
+		TaskPool pool(mThreadNum);
+		PrefixCache cache(initial, CACHE_MAX, CHECKPOINT_INTERVAL);
+
+		record(initial);
+		if (mReportCallback) {
+			mReportCallback(mPass, mRoute.length, mFinalScore);
+		}
+
+		for (;;)
+		{
+			if (mTimeLimit > 0.0 && std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count() >= mTimeLimit)
+				break;
+			if (mCancelCallback && mCancelCallback())
+				break;
+
+			++mPass;
+
+			// Ԃ̎n܂̔ՖʂLbVɎcB̗pm߂ɎsĂ̂ŁAقƂǒH邾ōς
+			Map map;
+			cache.evaluate(mRoute, map);
+
+			// ʒuƂɍłǂc
+			const u32 blockNum = (mRoute.length + CHECKPOINT_INTERVAL - 1) / CHECKPOINT_INTERVAL;
+			std::vector<Candidate> locals(mRoute.length), endings(mRoute.length);
+			for (u32 i = 0; i < mRoute.length; ++i) {
+				locals[i].begin = locals[i].end = endings[i].begin = endings[i].end = i;
+			}
+
+			// [gł1pXɎԂ̂ŁApX̓rłfɉ
+			std::atomic<bool> cancelled(false);
+			pool.parallelFor(0, blockNum, [&](u32 b) {
+				if (cancelled || (mCancelCallback && mCancelCallback())) {
+					cancelled = true;
+					return;
+				}
+				evaluate(b, cache, locals, endings);
+			});
+			if (cancelled)
+				break;
+
+			// Ō܂łúǍ̋ǏIȌׂĒׂĂ܂
+			// ǏIȌ₪sĂg
+			if (!apply(locals, cache) && !apply(endings, cache))
+				break;
+
+			record(initial);
+			if (mReportCallback) {
+				mReportCallback(mPass, mRoute.length, mFinalScore);
+			}
+		}
+
+		// vCŏIȂAf̃{[iX鎞 'A' t
+		Map map;
+		cache.evaluate(mRoute, map);
+
+		s3d::String result = mRoute;
+		if (map.condition == Condition::Playing && finalScore(map) > map.score) {
+			result += charOfCommand(Command::Abort);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̃[gsAeR}hʒȕԂL^
+	//! Ֆʂ͎̂̂cȂ
+	//-----------------------------------------------------------------------------
+	void RouteMinimizer::record(const Map& initial)
+	{
+		const u32 n = mRoute.length;
+
+		mLayouts.resize(n + 1);
+		mHashes.resize(n + 1);
+		mScores.resize(n + 1);
+		mPositions.resize(n + 1);
+
+		Map map = initial;
+		s3d::Grid<Cell> scratch;
+		for (u32 k = 0; ; ++k)
+		{
+			mLayouts[k] = layoutOfMap(map);
+			mHashes[k] = hashOfMap(map);
+			mScores[k] = map.score;
+			mPositions[k] = map.robotPos;
+
+			if (k == n)
+				break;
+
+			Simulator::step(commandOfChar(mRoute[k]), map, scratch);
+		}
+
+		mFinalScore = finalScore(map);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! block Ԗڂ̋Ԃ̊eʒuŌ
+	//!  rŏI / Ԃ폜 / ʒuւ̋ߓɒu 3
+	//! Ԃ̎n܂̔Ֆʂ̓LbVB̂ĂĂO̔Ֆʂs
+	//-----------------------------------------------------------------------------
+	void RouteMinimizer::evaluate(u32 block, const PrefixCache& cache, std::vector<Candidate>& locals, std::vector<Candidate>& endings)
+	{
+		const u32 n = mRoute.length;
+		const u32 begin = block * CHECKPOINT_INTERVAL;
+		const u32 end = std::min(begin + CHECKPOINT_INTERVAL, n);
+
+		Map state;
+		Map work;
+		s3d::Grid<Cell> scratch;
+		for (u32 k = cache.seek(mRoute, begin, state); k < begin; ++k) {
+			Simulator::step(commandOfChar(mRoute[k]), state, scratch);
+		}
+		PathField field;
+		s3d::String path;
+		Candidate cand;
+		u64 count = 0;
+
+		for (u32 i = begin; i < end; ++i)
+		{
+			if (i > begin) {
+				Simulator::step(commandOfChar(mRoute[i - 1]), state, scratch);
+			}
+
+			auto consider = [&](const Candidate& c) {
+				++count;
+				Candidate& b = c.ending ? endings[i] : locals[i];
+				if (isAcceptable(c) && (!isAcceptable(b) || isBetter(c, b))) {
+					b = c;
+				}
+			};
+
+			// ŏI
+			cand.begin = i;
+			cand.end = n;
+			cand.commands.clear();
+			cand.gain = finalScore(state) - mFinalScore;
+			cand.exact = true;
+			cand.ending = true;
+			consider(cand);
+
+			// ʒuɖ߂ĂԂ폜
+			const int2 pos = mPositions[i];
+			for (u32 w = 1; w <= WINDOW_MAX && i + w <= n; ++w) {
+				if (mPositions[i + w] == pos && simulate(state, i, s3d::String(), i + w, work, scratch, cand)) {
+					consider(cand);
+				}
+			}
+
+			// 肵ĂԂŒZoHɒu
+			// g|Ȃ΃}nb^Z͂ȂȂ̂ŁA̋Ԃׂ͒Ȃ
+			const u32 last = std::min(n, i + SHORTCUT_MAX);
+			bool detour = mTrampoline;
+			for (u32 j = i + 2; j <= last && !detour; ++j) {
+				const int2& to = mPositions[j];
+				detour = static_cast<u32>(std::abs(to.x - pos.x) + std::abs(to.y - pos.y)) < j - i;
+			}
+			if (!detour)
+				continue;
+
+			field.build(state, pos);
+
+			u32 targets[SHORTCUT_TRY] = {};
+			s32 savings[SHORTCUT_TRY] = {};
+			for (u32 j = i + 2; j <= last; ++j) {
+				const s32 dist = field.distanceTo(mPositions[j]);
+				if (dist < 0)
+					continue;
+
+				// ZԂ̍폜͂
+				if (dist == 0 && j - i <= WINDOW_MAX)
+					continue;
+
+				// ZȂȂ牓܂ŒuD悷
+				s32 saving = static_cast<s32>(j - i) - dist;
+				u32 target = j;
+				for (u32 t = 0; t < SHORTCUT_TRY; ++t) {
+					if (saving >= savings[t] && saving > 0) {
+						std::swap(saving, savings[t]);
+						std::swap(target, targets[t]);
+					}
+				}
+			}
+
+			for (u32 t = 0; t < SHORTCUT_TRY; ++t) {
+				if (savings[t] <= 0)
+					break;
+				if (field.routeTo(mPositions[targets[t]], path) && simulate(state, i, path, targets[t], work, scratch, cand)) {
+					consider(cand);
+				}
+			}
+		}
+
+		mCandidateNum += count;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! route[begin] ̏ start  head sAroute[resume] ȍ~𑱂
+	//! ̃[g̏Ԃɍ邩AQ[I邩A[g̍Ō܂ŗɂ
+	//! 񂾏ꍇ CONVERGE_MAX XebvȓɍȂꍇ false
+	//-----------------------------------------------------------------------------
+	bool RouteMinimizer::simulate(const Map& start, u32 begin, const s3d::String& head, u32 resume, Map& work, s3d::Grid<Cell>& scratch, Candidate& out) const
+	{
+		const u32 n = mRoute.length;
+
+		work = start;
+		out.begin = begin;
+		out.commands.clear();
+
+		for (auto c : head) {
+			if (work.condition != Condition::Playing)
+				break;
+			Simulator::step(commandOfChar(c), work, scratch);
+			out.commands += c;
+		}
+
+		for (u32 k = resume; ; ++k)
+		{
+			// Q[IBȍ~̃R}h͗vȂ
+			if (work.condition != Condition::Playing)
+			{
+				if (work.condition == Condition::Losing)
+					return false;
+
+				out.end = n;
+				out.gain = finalScore(work) - mFinalScore;
+				out.exact = true;
+				out.ending = true;
+				return true;
+			}
+
+			// ̃[gɍBȍ~͓ɂȂ
+			if (layoutOfMap(work) == mLayouts[k])
+			{
+				out.end = k;
+				out.gain = work.score - mScores[k];
+				out.exact = hashOfMap(work) == mHashes[k];
+				out.ending = false;
+				return true;
+			}
+
+			// [g̍Ō܂ŗ
+			if (k == n)
+			{
+				out.end = n;
+				out.gain = finalScore(work) - mFinalScore;
+				out.exact = true;
+				out.ending = true;
+				return true;
+			}
+
+			if (k - resume >= CONVERGE_MAX)
+				return false;
+
+			Simulator::step(commandOfChar(mRoute[k]), work, scratch);
+			out.commands += mRoute[k];
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dȂȂǂɍ̗p
+	//! ̏ԂSɈv݂͌ɓƗȂ̂ł܂Ƃ߂ē
+	//! Ⴄ1ŜĐĊm߂BύXʒu܂ł͍̃[gƓȂ̂ŁALbVH
+	//! [gςtrueԂ
+	//-----------------------------------------------------------------------------
+	bool RouteMinimizer::apply(std::vector<Candidate>& candidates, PrefixCache& cache)
+	{
+		std::vector<const Candidate*> sorted;
+		for (const auto& c : candidates) {
+			if (isAcceptable(c)) {
+				sorted.push_back(&c);
+			}
+		}
+		if (sorted.empty())
+			return false;
+
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Candidate* a, const Candidate* b) {
+			return isBetter(*a, *b);
+		});
+
+		std::vector<bool> used(mRoute.length, false);
+		std::vector<const Candidate*> exact, inexact;
+		for (const Candidate* c : sorted) {
+			bool overlap = false;
+			for (u32 k = c->begin; k < c->end && !overlap; ++k) {
+				overlap = used[k];
+			}
+			if (overlap)
+				continue;
+
+			for (u32 k = c->begin; k < c->end; ++k) {
+				used[k] = true;
+			}
+			(c->exact ? exact : inexact).push_back(c);
+		}
+
+		Map map;
+		auto scoreOf = [&](const s3d::String& route) {
+			return cache.evaluate(route, map);
+		};
+
+		auto byBegin = [](const Candidate* a, const Candidate* b) { return a->begin < b->begin; };
+
+		// nbV̏Փ˂ɔāA܂Ƃ߂ʂĐĊm߂
+		std::sort(exact.begin(), exact.end(), byBegin);
+		s3d::String route = splice(mRoute, exact);
+		s32 score = scoreOf(route);
+		if (score < mFinalScore) {
+			exact.clear();
+			route = mRoute;
+			score = mFinalScore;
+		}
+
+		std::vector<const Candidate*> picks = exact;
+		for (u32 v = 0; v < inexact.size() && v < VERIFY_MAX; ++v) {
+			std::vector<const Candidate*> trial = picks;
+			trial.push_back(inexact[v]);
+			std::sort(trial.begin(), trial.end(), byBegin);
+
+			const s3d::String r = splice(mRoute, trial);
+			const s32 s = scoreOf(r);
+			if (s > score || (s == score && r.length < route.length)) {
+				picks.swap(trial);
+				route = r;
+				score = s;
+			}
+		}
+
+		if (picks.empty())
+			return false;
+
+		mRoute = route;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! begin ̏ɕ񂾏dȂȂ route u
+	//-----------------------------------------------------------------------------
+	s3d::String RouteMinimizer::splice(const s3d::String& route, const std::vector<const Candidate*>& picks)
+	{
+		s3d::String result;
+
+		u32 pos = 0;
+		for (const Candidate* c : picks) {
+			result += route.substr(pos, c->begin - pos);
+			result += c->commands;
+			pos = c->end;
+		}
+		result += route.substr(pos);
+		return result;
+	}
+
+}
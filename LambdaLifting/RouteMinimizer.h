@@ -0,0 +1,85 @@
+//
+// Route Minimizer
+//
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include "Map.h"
+
+namespace app
+{
+
+	// Forward declaration
+	class PrefixCache;
+
+	//===================================================================================
+	//! @class RouteMinimizer
+	//! [g疳ʂȃR}h菜BXRAύX͍̗pȂ
+	//! Ԃ̍폜ƁAZoHւ̒uƂÃ[g̏Ԃɍ邩ŕ]
+	//!  PrefixCache Ɏcr̔Ֆʂɕ]
+	//===================================================================================
+	class RouteMinimizer
+	{
+	public:
+		using ReportCallback = std::function<void(u32 pass, u32 length, s32 score)>;
+		using CancelCallback = std::function<bool()>;
+
+		explicit RouteMinimizer(u32 threadNum = 0);
+		~RouteMinimizer();
+
+		s3d::String minimize(const Map& initial, const s3d::String& route);
+
+		//! 0ȂPȂȂ܂ő
+		void setTimeLimit(f64 seconds){ mTimeLimit = seconds; }
+		void setReportCallback(const ReportCallback& callback){ mReportCallback = callback; }
+
+		//! pX̍ԂƋԂ]OɌĂсAtrueȂÕpX܂łɒZ[gԂ
+		//! Ԃ̕]̓[J[̃XbhōŝŁAsɌĂł悢
+		void setCancelCallback(const CancelCallback& callback){ mCancelCallback = callback; }
+
+		u32 getPass() const { return mPass; }
+		u64 getCandidateNum() const { return mCandidateNum; }
+
+	private:
+		//! route[begin, end)  commands ɒu
+		struct Candidate
+		{
+			u32 begin;
+			u32 end;
+			s3d::String commands;
+			s32 gain;
+			bool exact;		// ̏ԂSɈvAgain ̂܂܍ŏIXRA̍ɂȂ
+			bool ending;	// Ƀ[g̍Ō܂łu
+		};
+
+		void record(const Map& initial);
+		void evaluate(u32 block, const PrefixCache& cache, std::vector<Candidate>& locals, std::vector<Candidate>& endings);
+		bool simulate(const Map& start, u32 begin, const s3d::String& head, u32 resume, Map& work, s3d::Grid<Cell>& scratch, Candidate& out) const;
+		bool apply(std::vector<Candidate>& candidates, PrefixCache& cache);
+
+		static s3d::String splice(const s3d::String& route, const std::vector<const Candidate*>& picks);
+
+	private:
+		u32 mThreadNum;
+		f64 mTimeLimit;
+
+		u32 mPass;
+		std::atomic<u64> mCandidateNum;
+
+		// ̃[gs̊eR}hʒȕ
+		s3d::String mRoute;
+		std::vector<u64> mLayouts;		// Ɉ˂Ȃ̃nbV
+		std::vector<u64> mHashes;
+		std::vector<s32> mScores;
+		std::vector<int2> mPositions;
+		s32 mFinalScore;
+		bool mTrampoline;
+
+		ReportCallback mReportCallback;
+		CancelCallback mCancelCallback;
+	};
+
+}
@@ -0,0 +1,274 @@
+//
+// Score Bound
+//
+
+#include "stdafx.h"
+#include "ScoreBound.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "FloodModel.h"
+#include "MapAnalysis.h"
+#include "Replay.h"
+
+namespace {
+
+	//-----------------------------------------------------------------------------
+	//! {bgʂȂ܂ܕςȂZBȂ͕ʂɒׂ
+	//-----------------------------------------------------------------------------
+	inline bool isStatic(app::Cell c)
+	{
+		const app::Cell t = app::cellType(c);
+		return t == app::Cell::Wall || t == app::Cell::ClosedLift || t == app::Cell::OpenLift;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! d Xebvڈȍ~̂ǂōs y ̃Zɓ\邩
+	//! XebvɓMĂ͐̂ŁA1XebvOɗׂ̍s y - 1 ȉŐĂ΂悢
+	//! ɏoɐĂ͎̂c̖h air Xebv܂
+	//! pȂAŌɐɋ̂ waterproof XebvȓŁAX waterproof s
+	//! Ă̍sɋĂ悢Ō̃Xebv܂łɒ΂悢Bpɖ߂镪xꍇ܂
+	//! ʂ͉Ȃ̂ŁAd xقǏ͌Ȃ
+	//-----------------------------------------------------------------------------
+	bool canReach(const app::FloodModel& flood, u32 air, u32 waterproof, s32 y, u32 d)
+	{
+		if (d == 0)
+			return true;
+		return d - 1 <= air || d - 1 <= flood.deadline(y - 1 - static_cast<s32>(waterproof));
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//! \ memoryMax Ɏ܂Ȃ΋ׂ1Ƃ݂ȂB͊ɂȂ邪
+	//-----------------------------------------------------------------------------
+	ScoreBound::ScoreBound(const Map& initial, size_t memoryMax)
+		: mWidth(initial.cell.width)
+		, mHeight(initial.cell.height)
+		, mTrampoline(false)
+		, mWinnable(true)
+	{
+		const size_t cellNum = static_cast<size_t>(mWidth) * mHeight;
+
+		// ǂݍݎ̉͌ʂgB΂ŉ͂
+		MapInfo analyzed;
+		const MapInfo* info = initial.info;
+		if (!info->isAnalyzed()) {
+			analyzed = *info;
+			analyzeMap(initial, analyzed);
+			info = &analyzed;
+		}
+
+		std::vector<bool> blocked(cellNum, false);
+		for (s32 y = 0; y < mHeight; ++y) {
+			for (s32 x = 0; x < mWidth; ++x) {
+				const u8 flags = info->cellFlags[y][x];
+				const Cell c = cellType(initial.cell[y][x]);
+				blocked[y * mWidth + x] = isStatic(c) || (flags & (CELL_FIXED_ROCK | CELL_UNREACHABLE)) != 0;
+
+				if (c == Cell::Lambda) {
+					if (flags & CELL_DEAD_LAMBDA) {
+						mDeadSites.push_back(int2{ x, y });
+					} else {
+						mSites.push_back(int2{ x, y });
+					}
+				} else if (c == Cell::HORock && (flags & CELL_DEAD_LAMBDA)) {
+					mWinnable = false;
+				} else if (c == Cell::Trampoline) {
+					mTrampoline = true;
+				}
+			}
+		}
+
+		const int2 liftPos = info->liftPos;
+		if (!info->liftReachable) {
+			mWinnable = false;
+		}
+
+		if ((mSites.size() + 1) * cellNum * sizeof(u16) > memoryMax)
+			return;
+
+		mFields.resize((mSites.size() + 1) * cellNum);
+		for (size_t i = 0; i < mSites.size(); ++i) {
+			buildField(initial, blocked, mSites[i], &mFields[i * cellNum]);
+		}
+		buildField(initial, blocked, liftPos, &mFields[mSites.size() * cellNum]);
+
+		mLiftDistance.resize(mSites.size());
+		for (size_t i = 0; i < mSites.size(); ++i) {
+			mLiftDistance[i] = static_cast<u16>(distance(static_cast<u32>(mSites.size()), mSites[i]));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	ScoreBound::~ScoreBound()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŏIXRȀ
+	//! k ̃_W߂ɂ́Ał߂_܂ł̋ + (k - 1) ƁA
+	//! ߂ k Ԗڂ̃_܂ł̋́AǂKv
+	//! K͂ǂŃ_ɂȂ邩Ȃ̂ŁA1Ƃ
+	//! ͂ŉłȂƕ_͐Ȃ
+	//-----------------------------------------------------------------------------
+	s32 ScoreBound::upperBound(const Map& map) const
+	{
+		if (map.condition != Condition::Playing)
+			return finalScore(map);
+
+		const FloodModel flood(map);
+		const u32 waterproof = map.info->waterproof;
+		auto reachable = [&](s32 y, u32 d) {
+			return mTrampoline || canReach(flood, map.waterproofCount, waterproof, y, d);
+		};
+
+		const u32 remaining = map.lambda - map.lambdaCollected;
+		std::vector<u32> dists;
+		dists.reserve(remaining);
+
+		// Ֆʂɂ郉_͊EŏȂ̂ŁAȂƃtg͊JȂ
+		// ḰA_ɂȂXebvɕʂ̊₪Ăď邱Ƃ
+		bool complete = mWinnable;
+		u32 present = 0;
+		for (const int2& pos : mDeadSites) {
+			if (map.cell[pos.y][pos.x] == Cell::Lambda) {
+				present++;
+				complete = false;
+			}
+		}
+
+		u32 liftMin = UNREACHABLE;
+		for (u32 i = 0; i < mSites.size(); ++i) {
+			const int2 pos = mSites[i];
+			if (map.cell[pos.y][pos.x] != Cell::Lambda)
+				continue;
+
+			present++;
+			const u32 d = distance(i, map.robotPos);
+			if (d == UNREACHABLE || !reachable(pos.y, d)) {
+				complete = false;
+				continue;
+			}
+			dists.push_back(d);
+			liftMin = std::min<u32>(liftMin, isCoarse() ? 1 : mLiftDistance[i]);
+		}
+		const u32 required = static_cast<u32>(dists.size());
+		for (u32 i = present; i < remaining; ++i) {
+			dists.push_back(1);
+			liftMin = 1;
+		}
+		std::sort(dists.begin(), dists.end());
+
+		// Abortꍇ
+		const s32 base = map.score + 25 * static_cast<s32>(map.lambdaCollected);
+		s32 best = base;
+		for (u32 k = 1; k <= dists.size(); ++k) {
+			const u32 moves = std::max(dists[k - 1], dists[0] + k - 1);
+			best = std::max(best, base + 50 * static_cast<s32>(k) - static_cast<s32>(moves));
+		}
+
+		// tgɓꍇBՖʂɂ郉_ׂ͂ďW߂
+		const u32 liftDist = distance(static_cast<u32>(mSites.size()), map.robotPos);
+		if (complete && liftDist != UNREACHABLE)
+		{
+			const s32 score = map.score + 50 * static_cast<s32>(map.lambdaCollected);
+			for (u32 k = required; k <= dists.size(); ++k) {
+				u32 moves = liftDist;
+				if (k > 0) {
+					moves = std::max(moves, std::max(dists[k - 1], dists[0] + k - 1) + liftMin);
+				}
+				if (reachable(map.info->liftPos.y, moves)) {
+					best = std::max(best, score + 75 * static_cast<s32>(k) - static_cast<s32>(moves));
+				}
+			}
+		}
+
+		return best;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! from ̋ 0-1 BFS ŋ߂
+	//! g|ƃ^[Qbg͋0ōsł̂ƂB邱Ƃ͖
+	//-----------------------------------------------------------------------------
+	void ScoreBound::buildField(const Map& initial, const std::vector<bool>& blocked, int2 from, u16* field) const
+	{
+		const size_t cellNum = static_cast<size_t>(mWidth) * mHeight;
+		std::vector<u32> dist(cellNum, UINT_MAX);
+
+		// g|ƃ^[Qbg̑g
+		std::vector<std::pair<s32, s32>> links;
+		for (u32 i = 0; i < MAX_TRAMPOLINE; ++i) {
+			const u8 target = initial.info->jump[i];
+			if (target >= MAX_TRAMPOLINE)
+				continue;
+			const int2 a = initial.info->trampolinePos[i];
+			const int2 b = initial.info->targetPos[target];
+			if (cellType(initial.cell[a.y][a.x]) == Cell::Trampoline) {
+				links.emplace_back(a.y * mWidth + a.x, b.y * mWidth + b.x);
+			}
+		}
+
+		std::deque<s32> queue;
+		const s32 start = from.y * mWidth + from.x;
+		dist[start] = 0;
+		queue.push_back(start);
+
+		static const s32 DX[] = { 0, 0, -1, 1 };
+		static const s32 DY[] = { -1, 1, 0, 0 };
+
+		while (!queue.empty())
+		{
+			const s32 index = queue.front();
+			queue.pop_front();
+			const u32 d = dist[index];
+
+			for (const auto& link : links) {
+				const s32 other = link.first == index ? link.second : link.second == index ? link.first : -1;
+				if (other >= 0 && d < dist[other]) {
+					dist[other] = d;
+					queue.push_front(other);
+				}
+			}
+
+			const s32 x = index % mWidth;
+			const s32 y = index / mWidth;
+			for (u32 k = 0; k < 4; ++k) {
+				const s32 nx = x + DX[k];
+				const s32 ny = y + DY[k];
+				if (nx < 0 || nx >= mWidth || ny < 0 || ny >= mHeight)
+					continue;
+
+				const s32 next = ny * mWidth + nx;
+				if (blocked[next] || d + 1 >= dist[next])
+					continue;
+				dist[next] = d + 1;
+				queue.push_back(next);
+			}
+		}
+
+		// \Ɏ܂Ȃ͒Zۂ߂BɂȂ邾
+		for (size_t i = 0; i < cellNum; ++i) {
+			field[i] = dist[i] == UINT_MAX ? UNREACHABLE : static_cast<u16>(std::min<u32>(dist[i], UNREACHABLE - 1));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! n_ site  pos ܂ł̋B͂Ȃ UNREACHABLE
+	//-----------------------------------------------------------------------------
+	u32 ScoreBound::distance(u32 site, int2 pos) const
+	{
+		if (isCoarse())
+			return 1;
+		return mFields[site * static_cast<size_t>(mWidth) * mHeight + pos.y * mWidth + pos.x];
+	}
+
+}
@@ -0,0 +1,51 @@
+//
+// Score Bound
+//
+
+#pragma once
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class ScoreBound
+	//! Ֆʂ炱ȏȂŏIXRȀ߂B}p
+	//! ŏ̔ՖʂŁAǂݍݎ̉͂œȂƕǂƂ݂ȂAe_ƃtg̋߂ĂA
+	//! c̃_ŒZŏW߂āAAbortꍇƃtgɓꍇ̗ǂԂ
+	//! ͊₪ꍇ≟ꍇ𖳎Ȃ̂ŁA͕Kۂ̃XRAȏɂȂ
+	//===================================================================================
+	class ScoreBound
+	{
+	public:
+		explicit ScoreBound(const Map& initial, size_t memoryMax = 64 << 20);
+		~ScoreBound();
+
+		s32 upperBound(const Map& map) const;
+
+		//! ̕\ĂAׂ1ƂĈĂ
+		bool isCoarse() const { return mFields.empty(); }
+
+	private:
+		static const u16 UNREACHABLE = 0xFFFF;
+
+		void buildField(const Map& initial, const std::vector<bool>& blocked, int2 from, u16* field) const;
+
+		u32 distance(u32 site, int2 pos) const;
+
+	private:
+		s32 mWidth;
+		s32 mHeight;
+
+		// ŏ̔Ֆʂ̃_̈ʒuBŌ̋̕\tg
+		std::vector<int2> mSites;
+		std::vector<u16> mFields;		// (_̐ + 1) ~ Z
+		std::vector<u16> mLiftDistance;	// e_烊tg܂
+		std::vector<int2> mDeadSites;	// łȂ_̈ʒu
+
+		bool mTrampoline;		// Wvōsς̂ŁA^̔͂Ȃ
+		bool mWinnable;			// ȂK₪邩Atgɓ͂Ȃ΃NAłȂ
+	};
+
+}
@@ -0,0 +1,339 @@
+//
+// Session Writer
+//
+
+#include "stdafx.h"
+#include "SessionWriter.h"
+
+#include <cstdio>
+#include <io.h>
+
+#include "FileUtil.h"
+#include "Hash.h"
+
+namespace {
+
+	const u32 kJournalMagic = 0x324E524A;	// "JRN2"
+
+	//! ύX܂Ƃ߂҂
+	const std::chrono::milliseconds kCoalesceDelay{ 200 };
+
+	//! W[ilߒTCY
+	const u64 kCompactSize = 4 * 1024 * 1024;
+
+	//! @struct JournalRecord
+	//! ÕR}h̐擪keepcAlengtht
+	//! hash͕t̃R}hŜ̃nbV
+	struct JournalRecord
+	{
+		u32 magic;
+		u32 keep;
+		u32 length;
+		u32 reserved;
+		u64 hash;
+	};
+
+	//-----------------------------------------------------------------------------
+	//! R}h̃nbV
+	//-----------------------------------------------------------------------------
+	u64 hashOfCommands(const s3d::String& commands)
+	{
+		return app::hashBytes(commands.c_str(), commands.length * sizeof(s3d::wchar));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ʂ擪̒
+	//-----------------------------------------------------------------------------
+	u32 commonPrefix(const s3d::String& a, const s3d::String& b)
+	{
+		const u32 n = std::min<u32>(a.length, b.length);
+		u32 i = 0;
+		while (i < n && a[i] == b[i])
+			++i;
+		return i;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! prevcommandsւ̍R[hŃfBXN܂Ŕf
+	//-----------------------------------------------------------------------------
+	bool writeRecord(std::FILE* fp, const s3d::String& prev, const s3d::String& commands, u64& written)
+	{
+		JournalRecord r;
+		r.magic = kJournalMagic;
+		r.keep = commonPrefix(prev, commands);
+		r.length = commands.length - r.keep;
+		r.reserved = 0;
+		r.hash = hashOfCommands(commands);
+
+		if (std::fwrite(&r, sizeof(r), 1, fp) != 1)
+			return false;
+		if (r.length > 0 && std::fwrite(commands.c_str() + r.keep, sizeof(s3d::wchar), r.length, fp) != r.length)
+			return false;
+		if (std::fflush(fp) != 0)
+			return false;
+		if (::_commit(::_fileno(fp)) != 0)
+			return false;
+
+		written = sizeof(r) + static_cast<u64>(r.length) * sizeof(s3d::wchar);
+		return true;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	SessionWriter::SessionWriter(const s3d::FilePath& iniPath, const s3d::FilePath& journalPath)
+		: mINIPath(iniPath)
+		, mJournalPath(journalPath)
+		, mDirty(false)
+		, mWriting(false)
+		, mQuit(false)
+		, mJournalSize(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	SessionWriter::~SessionWriter()
+	{
+		stop();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oXbhJn
+	//-----------------------------------------------------------------------------
+	void SessionWriter::start()
+	{
+		if (mThread.joinable())
+			return;
+
+		// ̃W[i̖oĂA̍
+		const auto commands = readJournal(mJournalPath);
+		FileStat stat;
+		if (commands && statFile(mJournalPath, stat)) {
+			mJournalCommands = commands.value();
+			mJournalSize = stat.size;
+		} else {
+			// ǂ߂ȂW[iɂ͒ǋLȀoō蒼
+			mJournalCommands.clear();
+			mJournalSize = kCompactSize + 1;
+		}
+
+		mQuit = false;
+		mThread = std::thread(&SessionWriter::run, this);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! coăXbhI
+	//-----------------------------------------------------------------------------
+	void SessionWriter::stop()
+	{
+		if (!mThread.joinable())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mCondition.notify_all();
+		mThread.join();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ZbVo^
+	//! oOɎ̕ύXꍇ͍ŐV̂̂
+	//-----------------------------------------------------------------------------
+	void SessionWriter::post(const Session& session)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mPending = session;
+			mDirty = true;
+		}
+		mCondition.notify_all();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o^ς݂̃ZbVo܂ő҂
+	//-----------------------------------------------------------------------------
+	void SessionWriter::flush()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (!mThread.joinable()) {
+			if (mDirty) {
+				mDirty = false;
+				write(mPending);
+			}
+			return;
+		}
+		mCondition.notify_all();
+		mFlushed.wait(lock, [this]{ return !mDirty && !mWriting; });
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oXbh
+	//-----------------------------------------------------------------------------
+	void SessionWriter::run()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (;;) {
+			mCondition.wait(lock, [this]{ return mDirty || mQuit; });
+
+			if (!mDirty && mQuit)
+				break;
+
+			// đ̕ύX܂Ƃ߂
+			if (!mQuit) {
+				mCondition.wait_for(lock, kCoalesceDelay, [this]{ return mQuit; });
+			}
+
+			const Session session = mPending;
+			mDirty = false;
+			mWriting = true;
+
+			lock.unlock();
+			write(session);
+			lock.lock();
+
+			mWriting = false;
+			mFlushed.notify_all();
+		}
+		mFlushed.notify_all();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o
+	//-----------------------------------------------------------------------------
+	bool SessionWriter::write(const Session& session)
+	{
+		bool result = true;
+
+		if (session.commands != mJournalCommands || mJournalSize > kCompactSize) {
+			if (mJournalSize > kCompactSize) {
+				result &= compactJournal(session.commands);
+			} else {
+				result &= appendJournal(session.commands);
+			}
+		}
+
+		result &= writeINI(session);
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! INIt@Co
+	//-----------------------------------------------------------------------------
+	bool SessionWriter::writeINI(const Session& session)
+	{
+		const s3d::FilePath tmpPath = mINIPath + L".tmp";
+		{
+			s3d::TextWriter w(tmpPath);
+			if (!w.isOpened())
+				return false;
+
+			w.writeln(L"[Map]");
+			w.writeln(L"filepath=" + session.filepath);
+			w.writeln(L"[GUI]");
+			w.writeln(s3d::Format(L"speed=", session.speed));
+			w.writeln(s3d::Format(L"trail=", session.trail));
+			w.close();
+		}
+		return replaceFile(tmpPath, mINIPath);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! W[iɒǋL
+	//-----------------------------------------------------------------------------
+	bool SessionWriter::appendJournal(const s3d::String& commands)
+	{
+		std::FILE* fp = ::_wfopen(mJournalPath.c_str(), L"ab");
+		if (!fp)
+			return false;
+
+		u64 written = 0;
+		const bool result = writeRecord(fp, mJournalCommands, commands, written);
+		std::fclose(fp);
+
+		if (result) {
+			mJournalCommands = commands;
+			mJournalSize += written;
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! W[iŐṼR[hɋlߒ
+	//-----------------------------------------------------------------------------
+	bool SessionWriter::compactJournal(const s3d::String& commands)
+	{
+		const s3d::FilePath tmpPath = mJournalPath + L".tmp";
+
+		std::FILE* fp = ::_wfopen(tmpPath.c_str(), L"wb");
+		if (!fp)
+			return false;
+
+		u64 written = 0;
+		const bool result = writeRecord(fp, s3d::String(), commands, written);
+		std::fclose(fp);
+
+		if (!result || !replaceFile(tmpPath, mJournalPath))
+			return false;
+
+		mJournalCommands = commands;
+		mJournalSize = written;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! W[i̍R[hɓĂāAŌ̊SȃR[h܂ł𕜌
+	//! ݓrŗꂽR[hȍ~͖
+	//-----------------------------------------------------------------------------
+	s3d::Optional<s3d::String> SessionWriter::readJournal(const s3d::FilePath& journalPath)
+	{
+		FileStat stat;
+		if (!statFile(journalPath, stat))
+			return s3d::none;
+
+		std::FILE* fp = ::_wfopen(journalPath.c_str(), L"rb");
+		if (!fp)
+			return s3d::none;
+
+		s3d::Optional<s3d::String> result;
+		std::wstring buf;
+		u64 offset = 0;
+		JournalRecord r;
+		while (std::fread(&r, sizeof(r), 1, fp) == 1) {
+			offset += sizeof(r);
+			if (r.magic != kJournalMagic)
+				break;
+
+			// ̓t@C̎cƒÕR}hŊm߂Ămۂ
+			if (r.keep > buf.size())
+				break;
+			const u64 bytes = static_cast<u64>(r.length) * sizeof(s3d::wchar);
+			if (bytes > stat.size - std::min(offset, stat.size))
+				break;
+
+			buf.resize(r.keep + static_cast<size_t>(r.length));
+			if (r.length > 0 && std::fread(&buf[r.keep], sizeof(s3d::wchar), r.length, fp) != r.length)
+				break;
+			offset += bytes;
+
+			const s3d::String commands{ buf };
+			if (hashOfCommands(commands) != r.hash)
+				break;
+
+			result = commands;
+		}
+
+		std::fclose(fp);
+		return result;
+	}
+
+}
@@ -0,0 +1,74 @@
+//
+// Session Writer
+//
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct Session
+	//===================================================================================
+	struct Session
+	{
+		s3d::FilePath filepath;
+		s3d::String commands;
+		f64 speed;
+		bool trail;
+
+	public:
+		Session() : speed(3), trail(true) {}
+	};
+
+	//===================================================================================
+	//! @class SessionWriter
+	//! ZbVobNOEhŕۑ
+	//! AύX͂܂Ƃ߂ďoAINI͈ꎞt@C̃l[ŒuB
+	//! Ȃ肤R}hINIł͂ȂǋLp̃W[iɑO񂩂̍
+	//===================================================================================
+	class SessionWriter
+	{
+	public:
+		SessionWriter(const s3d::FilePath& iniPath, const s3d::FilePath& journalPath);
+		~SessionWriter();
+
+		void start();
+		void stop();
+
+		void post(const Session& session);
+		void flush();
+
+		static s3d::Optional<s3d::String> readJournal(const s3d::FilePath& journalPath);
+
+	private:
+		void run();
+		bool write(const Session& session);
+		bool writeINI(const Session& session);
+		bool appendJournal(const s3d::String& commands);
+		bool compactJournal(const s3d::String& commands);
+
+	private:
+		s3d::FilePath mINIPath;
+		s3d::FilePath mJournalPath;
+
+		std::thread mThread;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::condition_variable mFlushed;
+
+		Session mPending;
+		bool mDirty;
+		bool mWriting;
+		bool mQuit;
+
+		// oXbĥ݂G
+		s3d::String mJournalCommands;
+		u64 mJournalSize;
+	};
+
+}
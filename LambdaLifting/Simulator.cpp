@@ -6,14 +6,33 @@
 #include "Simulator.h"
 
 #include "Map.h"
+#include "MapAnalysis.h"
+#include "PrefixCache.h"
 
 #define CHECK_REGISTER(x)	if(!x){return false;}
 
+#ifndef LL_HEADLESS
 namespace {
 
 	const s3d::Vec2 kCellSize{ 32, 32 };
 
 } // unnamed namespace
+#endif
+
+namespace {
+
+	//-----------------------------------------------------------------------------
+	//! ZAchanged ΈʒuL^
+	//-----------------------------------------------------------------------------
+	inline void setCell(app::Map& map, s32 x, s32 y, app::Cell c, std::vector<s32>* changed)
+	{
+		map.cell[y][x] = c;
+		if (changed) {
+			changed->push_back(y * map.cell.width + x);
+		}
+	}
+
+} // unnamed namespace
 
 
 namespace app
@@ -26,6 +45,7 @@ namespace app
 		: mpMapInfo(nullptr)
 		, mpInitialMap(nullptr)
 		, mHistoryPos(0)
+		, mpHistoryCache(nullptr)
 	{
 		mpMapInfo = new MapInfo;
 
@@ -64,12 +84,14 @@ namespace app
 
 		mCommands.clear();
 		mValids.clear();
+		mMerged.clear();
 		mCommandPos = 0;
 
-		for (auto* p : mHistory)
-			delete p;
 		mHistory.clear();
 		mHistoryPos = 0;
+
+		delete mpHistoryCache;
+		mpHistoryCache = nullptr;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -99,8 +121,14 @@ namespace app
 		if (!r.isOpened())
 			return false;
 
-		const s3d::String s = r.readContents();
+		return parseMap(r.readContents(), mapInfo, map);
+	}
 
+	//-----------------------------------------------------------------------------
+	//! }bv𕶎񂩂͂
+	//-----------------------------------------------------------------------------
+	bool Simulator::parseMap(const s3d::String& s, struct MapInfo& mapInfo, struct Map& map)
+	{
 		u32 w = 0, h = 0;
 		bool bend = false;
 		for (const auto& line : s.split(L'\n')) {
@@ -110,7 +138,7 @@ namespace app
 					bend = true;
 					continue;
 				}
-				w = std::max(w, line.length);
+				w = std::max<u32>(w, line.length);
 				h++;
 				continue;
 			}
@@ -229,6 +257,7 @@ namespace app
 			x++;
 		}
 
+		analyzeMap(map, mapInfo);
 		return true;
 	}
 
@@ -238,7 +267,7 @@ namespace app
 	//-----------------------------------------------------------------------------
 	const struct Map& Simulator::getMap() const
 	{
-		return mHistoryPos == mHistory.size() ? *mpMap : *mHistory[mHistoryPos - 1];
+		return *mpMap;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -259,8 +288,11 @@ namespace app
 	{
 		clear(false);
 		*mpMap = *mpInitialMap;
-		mHistory.push_back(new Map(*mpInitialMap));
+		mHistory.push_back(mpInitialMap->robotPos);
 		mHistoryPos++;
+
+		// Ֆʂ͎cA߂鎞ɃLbV畜
+		mpHistoryCache = new PrefixCache(*mpInitialMap);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -276,9 +308,13 @@ namespace app
 				if (mValids[i]) {
 					mHistoryPos--;
 				}
+				// }N̓rł͎~߂Ȃ
+				if (i > 0 && mMerged[i - 1])
+					continue;
 				if (--step == 0)
 					break;
 			}
+			seekHistory();
 			return true;
 		}
 		return false;
@@ -290,16 +326,19 @@ namespace app
 	bool Simulator::redo(u32 step)
 	{
 		if (mCommandPos < mCommands.length) {
-			step = std::min(step, mCommands.length);
+			step = std::min<u32>(step, mCommands.length);
 
 			for (u32 i = mCommandPos; i < mCommands.length; ++i) {
 				mCommandPos++;
 				if (mValids[i]) {
 					mHistoryPos++;
 				}
+				if (mMerged[i])
+					continue;
 				if (--step == 0)
 					break;
 			}
+			seekHistory();
 			return true;
 		}
 		return false;
@@ -328,27 +367,26 @@ namespace app
 	{
 		mCommands += cmd;
 		mValids.push_back(pmap != nullptr);
+		mMerged.push_back(false);
 		mCommandPos++;
 		if (pmap) {
-			mHistory.push_back(new Map(*pmap));
+			mHistory.push_back(pmap->robotPos);
 			mHistoryPos++;
 		}
 	}
 
 	//-----------------------------------------------------------------------------
 	//! ĊJ
+	//! Ֆʂ Undo/Redo ̎ɍ킹Ă̂ŁÂ̗Ă邾
 	//-----------------------------------------------------------------------------
 	bool Simulator::resumeHistory()
 	{
 		if (mCommandPos != mCommands.length) {
 			mCommands.resize(mCommandPos);
 			mValids.resize(mCommandPos);
+			mMerged.resize(mCommandPos);
 
 			if (mHistoryPos != mHistory.size()) {
-				*mpMap = *mHistory[mHistoryPos - 1];
-
-				for (u32 i = mHistoryPos; i < mHistory.size(); ++i)
-					delete mHistory[i];
 				mHistory.resize(mHistoryPos);
 				return true;
 			}
@@ -356,6 +394,15 @@ namespace app
 		return false;
 	}
 
+	//-----------------------------------------------------------------------------
+	//! Ֆʂ mCommandPos ܂łsԂɂ
+	//! ʂ̐擪̓LbVHAŊ̔Ֆʂc肾s
+	//-----------------------------------------------------------------------------
+	void Simulator::seekHistory()
+	{
+		mpHistoryCache->evaluate(mCommands.substr(0, mCommandPos), *mpMap);
+	}
+
 	//-----------------------------------------------------------------------------
 	//! As
 	//-----------------------------------------------------------------------------
@@ -392,19 +439,70 @@ namespace app
 		return step(charOfCommand(cmd));
 	}
 
+	//-----------------------------------------------------------------------------
+	//! }NANV̌ʂ܂Ƃ߂Đς
+	//! result ݂͌̔Ֆʂ cmds sʂł邱
+	//! r̔Ֆʂ͗ɎcAUndo/Redo ł1ƂĈ
+	//-----------------------------------------------------------------------------
+	bool Simulator::stepMacro(const s3d::String& cmds, const struct Map& result)
+	{
+		if (cmds.isEmpty)
+			return false;
+
+		resumeHistory();
+
+		for (u32 i = 0; i + 1 < cmds.length; ++i) {
+			mCommands += cmds[i];
+			mValids.push_back(false);
+			mMerged.push_back(true);
+			mCommandPos++;
+		}
+
+		*mpMap = result;
+		pushHistory(cmds[cmds.length - 1], mpMap);
+		return true;
+	}
+
 	//-----------------------------------------------------------------------------
 	//! Xebvs
 	//-----------------------------------------------------------------------------
 	bool Simulator::step(Command cmd, struct Map& map)
+	{
+		s3d::Grid<Cell> scratch;
+		return step(cmd, map, scratch);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xebvs
+	//! scratch ͍XVO̔Ֆʂ̑ޔɎgBg񂹂΃XebvƂ̊mۂȂȂ
+	//-----------------------------------------------------------------------------
+	bool Simulator::step(Command cmd, struct Map& map, s3d::Grid<Cell>& scratch)
+	{
+		return step(cmd, map, scratch, nullptr);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xebvs
+	//! Z̈ʒu (y *  + x)  changed ɒǉBlɖ߂Zd܂
+	//-----------------------------------------------------------------------------
+	bool Simulator::step(Command cmd, struct Map& map, s3d::Grid<Cell>& scratch, std::vector<s32>& changed)
+	{
+		return step(cmd, map, scratch, &changed);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xebvs̖{
+	//-----------------------------------------------------------------------------
+	bool Simulator::step(Command cmd, struct Map& map, s3d::Grid<Cell>& scratch, std::vector<s32>* changed)
 	{
 		if (map.condition != Condition::Playing)
 			return false;
 
 		// {bgXV
-		bool result = updateRobot(cmd, map);
+		bool result = updateRobot(cmd, map, changed);
 
 		// }bvXV
-		const u32 count = updateMap(map);
+		const u32 count = updateMap(map, scratch, changed);
 		if (cmd == Command::Wait) {
 			result = count > 0;
 		} else {
@@ -424,7 +522,7 @@ namespace app
 	//-----------------------------------------------------------------------------
 	//! {bgXV
 	//-----------------------------------------------------------------------------
-	bool Simulator::updateRobot(Command cmd, struct Map& map)
+	bool Simulator::updateRobot(Command cmd, struct Map& map, std::vector<s32>* changed)
 	{
 		bool result = false;
 
@@ -433,7 +531,7 @@ namespace app
 		case Command::Down:
 		case Command::Left:
 		case Command::Right:
-			result = moveRobot(cmd, map);
+			result = moveRobot(cmd, map, changed);
 			break;
 		case Command::Wait:
 			result = true;
@@ -459,7 +557,7 @@ namespace app
 							continue;
 
 						if (map.cell[adjPos.y][adjPos.x] == Cell::Beard) {
-							map.cell[adjPos.y][adjPos.x] = Cell::Empty;
+							setCell(map, adjPos.x, adjPos.y, Cell::Empty, changed);
 							map.beard--;
 						}
 					}
@@ -485,7 +583,7 @@ namespace app
 	//-----------------------------------------------------------------------------
 	//! {bgړ
 	//-----------------------------------------------------------------------------
-	bool Simulator::moveRobot(Command cmd, struct Map& map)
+	bool Simulator::moveRobot(Command cmd, struct Map& map, std::vector<s32>* changed)
 	{
 		const s3d::Rect rect{ 0, 0, map.cell.width, map.cell.height };
 
@@ -515,8 +613,8 @@ namespace app
 		const Cell lc = map.cell[newPos.y][newPos.x];
 		const Cell c = cellType(lc);
 		if (c == Cell::Empty || c == Cell::Earth || c == Cell::Lambda || c == Cell::OpenLift || c == Cell::Trampoline || c == Cell::Razor) {
-			map.cell[map.robotPos.y][map.robotPos.x] = Cell::Empty;
-			map.cell[newPos.y][newPos.x] = Cell::Robot;
+			setCell(map, map.robotPos.x, map.robotPos.y, Cell::Empty, changed);
+			setCell(map, newPos.x, newPos.y, Cell::Robot, changed);
 			map.robotPos = newPos;
 			map.step();
 			valid = true;
@@ -536,15 +634,15 @@ namespace app
 				const u8 target = map.info->jump[label];
 				const int2 jumpPos{ map.info->targetPos[target] };
 
-				map.cell[newPos.y][newPos.x] = Cell::Empty;
-				map.cell[jumpPos.y][jumpPos.x] = Cell::Robot;
+				setCell(map, newPos.x, newPos.y, Cell::Empty, changed);
+				setCell(map, jumpPos.x, jumpPos.y, Cell::Robot, changed);
 				map.robotPos = jumpPos;
 
 				// ^[QbgɊ֘AtĂg|
 				for (u32 i = 0; i < MAX_TRAMPOLINE; ++i) {
 					if (map.info->jump[i] == target) {
 						const auto& pos = map.info->trampolinePos[i];
-						map.cell[pos.y][pos.x] = Cell::Empty;
+						setCell(map, pos.x, pos.y, Cell::Empty, changed);
 					}
 				}
 			}
@@ -561,9 +659,9 @@ namespace app
 				return false;
 
 			if (map.cell[nextPos.y][nextPos.x] == Cell::Empty) {
-				map.cell[map.robotPos.y][map.robotPos.x] = Cell::Empty;
-				map.cell[newPos.y][newPos.x] = Cell::Robot;
-				map.cell[nextPos.y][nextPos.x] = c;
+				setCell(map, map.robotPos.x, map.robotPos.y, Cell::Empty, changed);
+				setCell(map, newPos.x, newPos.y, Cell::Robot, changed);
+				setCell(map, nextPos.x, nextPos.y, c, changed);
 				map.robotPos = newPos;
 				map.step();
 				valid = true;
@@ -576,9 +674,9 @@ namespace app
 	//-----------------------------------------------------------------------------
 	//! }bvXV
 	//-----------------------------------------------------------------------------
-	u32 Simulator::updateMap(struct Map& map)
+	u32 Simulator::updateMap(struct Map& map, s3d::Grid<Cell>& old, std::vector<s32>* changed)
 	{
-		const s3d::Grid<Cell> old{ map.cell };
+		old = map.cell;
 
 		u32 count = 0;
 
@@ -590,7 +688,7 @@ namespace app
 
 				// tg̏ꍇ
 				if (c == Cell::ClosedLift && map.lambdaCollected == map.lambda) {
-					map.cell[y][x] = Cell::OpenLift;
+					setCell(map, x, y, Cell::OpenLift, changed);
 					count++;
 				}
 				// ̏ꍇ
@@ -625,12 +723,12 @@ namespace app
 							map.lambda--;
 						}
 
-						map.cell[y][x] = Cell::Empty;
-						map.cell[newPos.y][newPos.x] = c;
+						setCell(map, x, y, Cell::Empty, changed);
+						setCell(map, newPos.x, newPos.y, c, changed);
 						count++;
 
 						if (c == Cell::HORock && newPos.y + 1 < h && old[newPos.y + 1][newPos.x] != Cell::Empty) {
-							map.cell[newPos.y][newPos.x] = Cell::Lambda;
+							setCell(map, newPos.x, newPos.y, Cell::Lambda, changed);
 						}
 					}
 				}
@@ -656,7 +754,7 @@ namespace app
 										map.lambda--;
 									}
 
-									map.cell[adjPos.y][adjPos.x] = Cell::Beard;
+									setCell(map, adjPos.x, adjPos.y, Cell::Beard, changed);
 									map.beard++;
 									count++;
 								}
@@ -731,6 +829,7 @@ namespace app
 
 #pragma endregion
 
+#ifndef LL_HEADLESS
 #pragma region Draw Operation
 
 	//-----------------------------------------------------------------------------
@@ -856,7 +955,7 @@ namespace app
 		s3d::Vec2 pos2{ pos1 };
 		for(s32 i = 0; i < length; ++i){
 			// 烍{bg̈ʒu̎擾
-			pos2 = mHistory[mHistoryPos - 2 - i]->robotPos;
+			pos2 = mHistory[mHistoryPos - 2 - i];
 
 			s3d::Color color{ s3d::Math::Lerp(s3d::Palette::Red, s3d::Palette::Yellow, (f64)i / length) };
 			color.a = 255 * s3d::Math::Lerp(1.0, 0.5, (f64)i / length);
@@ -926,7 +1025,7 @@ namespace app
 			if (i >= mCommands.length - d) {
 				color = s3d::Palette::Dimgray;
 			} else {
-				color = mValids[i] ? _color : s3d::Palette::Red;
+				color = mValids[i] || mMerged[i] ? _color : s3d::Palette::Red;
 			}
 
 			font.draw(wstr, s3d::Vec2(rect.x + w * x, rect.y + rect.h + h * y), color);
@@ -945,5 +1044,6 @@ namespace app
 	}
 
 #pragma endregion
+#endif // LL_HEADLESS
 
 } // namespace app
\ No newline at end of file
@@ -9,7 +9,9 @@ namespace app
 
 	// Forward declaration
 	enum class Command;
+	enum class Cell : u16;
 	struct Map;
+	class PrefixCache;
 
 	//===================================================================================
 	//! @class Simulator
@@ -25,14 +27,18 @@ namespace app
 		bool loadMap(const s3d::String& filepath);
 
 		static bool loadMap(const s3d::String& filepath, struct MapInfo& mapInfo, struct Map& map);
+		static bool parseMap(const s3d::String& s, struct MapInfo& mapInfo, struct Map& map);
 
 		//-----------------------------------------------------------------------------
 		void run(const s3d::String& cmds);
 
 		bool step(s3d::wchar cmd);
 		bool step(Command cmd);
+		bool stepMacro(const s3d::String& cmds, const struct Map& result);
 
 		static bool step(Command cmd, struct Map& newMap);
+		static bool step(Command cmd, struct Map& newMap, s3d::Grid<Cell>& scratch);
+		static bool step(Command cmd, struct Map& newMap, s3d::Grid<Cell>& scratch, std::vector<s32>& changed);
 
 		void reset();
 		bool undo(u32 step = 1);
@@ -43,6 +49,7 @@ namespace app
 
 		void setHistoryMax(s32 m = -1){ mHistoryMax = m; }
 
+#ifndef LL_HEADLESS
 		//-----------------------------------------------------------------------------
 		static bool loadAsset();
 
@@ -54,40 +61,47 @@ namespace app
 
 		s3d::RectF drawMapInfo(const s3d::Vec2& pos = s3d::Vec2::Zero, const s3d::Color& = s3d::Palette::White) const;
 		s3d::RectF drawCommands(const s3d::Vec2& pos = s3d::Vec2::Zero, const s3d::Color& = s3d::Palette::White) const;
+#endif
 
 		//-----------------------------------------------------------------------------
 		const s3d::String& getFilePath() const { return mFilePath;  }
 		const struct Map& getMap() const;
+		const struct Map& getInitialMap() const { return *mpInitialMap; }
 		bool isPlaying() const;
 		const s3d::String& getCommands() const { return mCommands; }
 		u32 getCommandNum() const { return mCommands.length; }
+		u32 getCommandPos() const { return mCommandPos; }
 		u32 getHistoryNum() const { return mHistory.size(); }
 
 	private:
 		//! @name Auxiliary function
 		//@{
-		static bool updateRobot(Command cmd, struct Map& map);
-		static bool moveRobot(Command cmd, struct Map& map);
-		static u32  updateMap(struct Map& map);
+		static bool step(Command cmd, struct Map& map, s3d::Grid<Cell>& scratch, std::vector<s32>* changed);
+		static bool updateRobot(Command cmd, struct Map& map, std::vector<s32>* changed);
+		static bool moveRobot(Command cmd, struct Map& map, std::vector<s32>* changed);
+		static u32  updateMap(struct Map& map, s3d::Grid<Cell>& old, std::vector<s32>* changed);
 		static bool updateFlooding(struct Map& map);
 		static bool updateBeard(struct Map& map);
 		//@}
 
 		void pushHistory(s3d::wchar cmd, struct Map* pmap);
 		bool resumeHistory();
+		void seekHistory();
 
 	private:
 		s3d::FilePath mFilePath;
 		s3d::String mFileName;
 		struct MapInfo* mpMapInfo;
 		struct Map* mpInitialMap;
-		struct Map* mpMap;
+		struct Map* mpMap;			// mCommandPos ܂łsՖ
 
 		s3d::String mCommands;
 		u32 mCommandPos;
 		std::vector<bool> mValids;
-		std::deque<struct Map*> mHistory;
+		std::vector<bool> mMerged;		// }N̓r̃R}hB̃R}hƈꏏɖ߂
+		std::vector<s3d::Vector2D<s32>> mHistory;	// LȃR}hs̃{bg̈ʒuB擪͏ʒu
 		u32 mHistoryPos;
+		PrefixCache* mpHistoryCache;	// Undo/Redo Ŗ߂Ֆ
 		s32 mHistoryMax;
 	};
 
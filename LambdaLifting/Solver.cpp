@@ -0,0 +1,100 @@
+//
+// Solver
+//
+
+#include "stdafx.h"
+#include "Solver.h"
+
+#include <climits>
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	SolverContext::SolverContext()
+		: mCancel(false)
+		, mStart(Clock::now())
+		, mHasDeadline(false)
+		, mBestScore(INT_MIN)
+		, mNodeNum(0)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	SolverContext::~SolverContext()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ԃݒ
+	//! 0ȉȂ疳
+	//-----------------------------------------------------------------------------
+	void SolverContext::setTimeLimit(f64 seconds)
+	{
+		mHasDeadline = seconds > 0.0;
+		mDeadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(seconds));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! fׂ
+	//-----------------------------------------------------------------------------
+	bool SolverContext::isCancelled() const
+	{
+		return mCancel || (mHasDeadline && Clock::now() >= mDeadline);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! oߎ [s]
+	//-----------------------------------------------------------------------------
+	f64 SolverContext::getElapsed() const
+	{
+		return std::chrono::duration<f64>(Clock::now() - mStart).count();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! c莞 [s]
+	//! ԂȂ0
+	//-----------------------------------------------------------------------------
+	f64 SolverContext::getRemaining() const
+	{
+		if (!mHasDeadline)
+			return 0.0;
+		return std::max(0.0, std::chrono::duration<f64>(mDeadline - Clock::now()).count());
+	}
+
+	//-----------------------------------------------------------------------------
+	//! P[go^
+	//! ŗǂXVꍇtrueԂ
+	//-----------------------------------------------------------------------------
+	bool SolverContext::publish(const s3d::String& route, s32 score)
+	{
+		// 唼̌Ăяo͍XVȂ̂ŃbN̑Oɒe
+		if (score <= mBestScore)
+			return false;
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (score <= mBestScore)
+			return false;
+
+		mBestScore = score;
+		mBestRoute = route;
+		if (mImproveCallback) {
+			mImproveCallback(route, score);
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ŗǃ[g
+	//-----------------------------------------------------------------------------
+	s3d::String SolverContext::getBestRoute() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mBestRoute;
+	}
+
+}
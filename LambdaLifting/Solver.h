@@ -0,0 +1,83 @@
+//
+// Solver
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+namespace app
+{
+
+	// Forward declaration
+	struct Map;
+
+	//===================================================================================
+	//! @class SolverContext
+	//! \o[̒fAԁAŗǃ[g̋L
+	//===================================================================================
+	class SolverContext
+	{
+	public:
+		using ImproveCallback = std::function<void(const s3d::String& route, s32 score)>;
+
+		SolverContext();
+		~SolverContext();
+
+		void setTimeLimit(f64 seconds);
+		void cancel(){ mCancel = true; }
+		bool isCancelled() const;
+		f64 getElapsed() const;
+
+		bool hasDeadline() const { return mHasDeadline; }
+		f64 getRemaining() const;
+
+		bool publish(const s3d::String& route, s32 score);
+
+		s32 getBestScore() const { return mBestScore; }
+		s3d::String getBestRoute() const;
+
+		void setImproveCallback(const ImproveCallback& callback){ mImproveCallback = callback; }
+
+		void addNodeNum(u64 n){ mNodeNum += n; }
+		u64 getNodeNum() const { return mNodeNum; }
+
+	private:
+		SolverContext(const SolverContext&) = delete;
+		SolverContext& operator=(const SolverContext&) = delete;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		std::atomic<bool> mCancel;
+		Clock::time_point mStart;
+		Clock::time_point mDeadline;
+		bool mHasDeadline;
+
+		mutable std::mutex mMutex;
+		std::atomic<s32> mBestScore;
+		s3d::String mBestRoute;
+		ImproveCallback mImproveCallback;
+
+		std::atomic<u64> mNodeNum;
+	};
+
+	//===================================================================================
+	//! @class Solver
+	//===================================================================================
+	class Solver
+	{
+	public:
+		Solver(){}
+		virtual ~Solver(){}
+
+		virtual const s3d::wchar* getName() const = 0;
+
+		//! Ԃ烋[gTAP邽т ctx.publish 
+		virtual void solve(const Map& map, SolverContext& ctx) = 0;
+	};
+
+}
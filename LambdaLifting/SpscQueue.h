@@ -0,0 +1,82 @@
+//
+// SPSC Queue
+//
+
+#pragma once
+
+#include <atomic>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class SpscQueue
+	//! 1XbhAǂݏo1XbȟŒ蒷Oobt@BbNȂ
+	//!  mTail Aǂݎ mHead i߂
+	//===================================================================================
+	template<class T>
+	class SpscQueue
+	{
+	public:
+		//! eʂ2ׂ̂ɐ؂グ
+		explicit SpscQueue(size_t capacity)
+			: mHead(0)
+			, mTail(0)
+		{
+			size_t size = 1;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			mSlots.resize(size);
+			mMask = size - 1;
+		}
+
+		//! ̃XbhĂԁBtȂfalse
+		bool push(const T& value)
+		{
+			const size_t tail = mTail.load(std::memory_order_relaxed);
+			if (tail - mHead.load(std::memory_order_acquire) > mMask)
+				return false;
+
+			mSlots[tail & mMask] = value;
+			mTail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		//! ǂݎ̃XbhĂԁBȂfalse
+		bool pop(T& value)
+		{
+			const size_t head = mHead.load(std::memory_order_relaxed);
+			if (head == mTail.load(std::memory_order_acquire))
+				return false;
+
+			value = std::move(mSlots[head & mMask]);
+			mHead.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		//! ǂݎ̃XbhĂ
+		void clear()
+		{
+			T value;
+			while (pop(value)) {
+			}
+		}
+
+		size_t capacity() const { return mMask + 1; }
+
+	private:
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+	private:
+		std::vector<T> mSlots;
+		size_t mMask;
+
+		// Ɠǂݎ肪LbVCDȂ悤
+		std::atomic<size_t> mHead;
+		u8 mPadding[64];
+		std::atomic<size_t> mTail;
+	};
+
+}
@@ -0,0 +1,175 @@
+//
+// Task Pool
+//
+
+#include "stdafx.h"
+#include "TaskPool.h"
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	TaskPool::TaskPool(u32 threadNum)
+		: mNext(0)
+		, mQueued(0)
+		, mPending(0)
+		, mStealNum(0)
+		, mQuit(false)
+	{
+		if (threadNum == 0) {
+			threadNum = defaultThreadNum();
+		}
+
+		for (u32 i = 0; i < threadNum; ++i) {
+			mWorkers.emplace_back(new Worker);
+		}
+		for (u32 i = 0; i < threadNum; ++i) {
+			mWorkers[i]->thread = std::thread(&TaskPool::run, this, i);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	TaskPool::~TaskPool()
+	{
+		wait();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mWake.notify_all();
+
+		for (auto& w : mWorkers) {
+			w->thread.join();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! _RA
+	//-----------------------------------------------------------------------------
+	u32 TaskPool::defaultThreadNum()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ^XNo^
+	//-----------------------------------------------------------------------------
+	void TaskPool::submit(Task task)
+	{
+		// ς񂾒ɑ̃[J[oďI邱Ƃ̂ŁAĂς
+		// ォ琔 mPending 0ɂȂAwait s̃^XN҂ɖ߂
+		mPending++;
+		mQueued++;
+
+		Worker& w = *mWorkers[mNext++ % mWorkers.size()];
+		{
+			std::lock_guard<std::mutex> lock(w.mutex);
+			w.tasks.push_back(std::move(task));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+		}
+		mWake.notify_one();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! o^ς݂̃^XNׂďI܂ő҂
+	//! [J[XbhĂł͂Ȃ
+	//-----------------------------------------------------------------------------
+	void TaskPool::wait()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this]{ return mPending == 0; });
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [begin, end) ɏ
+	//-----------------------------------------------------------------------------
+	void TaskPool::parallelFor(u32 begin, u32 end, const std::function<void(u32)>& func)
+	{
+		if (begin >= end)
+			return;
+
+		// [J[̐{ɕA΂͓݂łȂ炷
+		const u32 count = end - begin;
+		const u32 chunkNum = std::min(count, size() * 4);
+		const u32 chunk = (count + chunkNum - 1) / chunkNum;
+
+		for (u32 i = begin; i < end; i += chunk) {
+			const u32 last = std::min(end, i + chunk);
+			submit([&func, i, last]{
+				for (u32 j = i; j < last; ++j) {
+					func(j);
+				}
+			});
+		}
+		wait();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! [J[Xbh
+	//-----------------------------------------------------------------------------
+	void TaskPool::run(u32 index)
+	{
+		for (;;) {
+			Task task;
+			if (pop(index, task) || steal(index, task)) {
+				mQueued--;
+				task();
+
+				if (--mPending == 0) {
+					std::lock_guard<std::mutex> lock(mMutex);
+					mDone.notify_all();
+				}
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this]{ return mQuit || mQueued > 0; });
+			if (mQuit && mQueued == 0)
+				break;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̃L[̖o
+	//-----------------------------------------------------------------------------
+	bool TaskPool::pop(u32 index, Task& task)
+	{
+		Worker& w = *mWorkers[index];
+		std::lock_guard<std::mutex> lock(w.mutex);
+		if (w.tasks.empty())
+			return false;
+
+		task = std::move(w.tasks.back());
+		w.tasks.pop_back();
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̃[J[̃L[̐擪瓐
+	//-----------------------------------------------------------------------------
+	bool TaskPool::steal(u32 index, Task& task)
+	{
+		const u32 n = size();
+		for (u32 i = 1; i < n; ++i) {
+			Worker& w = *mWorkers[(index + i) % n];
+			std::lock_guard<std::mutex> lock(w.mutex);
+			if (w.tasks.empty())
+				continue;
+
+			task = std::move(w.tasks.front());
+			w.tasks.pop_front();
+			mStealNum++;
+			return true;
+		}
+		return false;
+	}
+
+}
@@ -0,0 +1,66 @@
+//
+// Task Pool
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class TaskPool
+	//! [J[ƂɃL[AɂȂ[J[͑̃L[瓐ރXbhv[
+	//===================================================================================
+	class TaskPool
+	{
+	public:
+		using Task = std::function<void()>;
+
+		explicit TaskPool(u32 threadNum = 0);
+		~TaskPool();
+
+		void submit(Task task);
+		void wait();
+
+		void parallelFor(u32 begin, u32 end, const std::function<void(u32)>& func);
+
+		u32 size() const { return static_cast<u32>(mWorkers.size()); }
+		u64 getStealNum() const { return mStealNum; }
+
+		static u32 defaultThreadNum();
+
+	private:
+		TaskPool(const TaskPool&) = delete;
+		TaskPool& operator=(const TaskPool&) = delete;
+
+		void run(u32 index);
+		bool pop(u32 index, Task& task);
+		bool steal(u32 index, Task& task);
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+			std::thread thread;
+		};
+
+		std::vector<std::unique_ptr<Worker>> mWorkers;
+		std::atomic<u32> mNext;
+		std::atomic<u32> mQueued;
+		std::atomic<u32> mPending;
+		std::atomic<u64> mStealNum;
+
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+		bool mQuit;
+	};
+
+}
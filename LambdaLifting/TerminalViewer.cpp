@@ -0,0 +1,523 @@
+//
+// Terminal Viewer
+//
+
+#include "stdafx.h"
+#include "TerminalViewer.h"
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "Simulator.h"
+
+namespace {
+
+	static const u32 FRAME_RATE = 60;
+	static const u32 SPEED_MIN = 0;		// 1 step/sec
+	static const u32 SPEED_MAX = 14;	// 16384 steps/sec
+	static const u32 SPEED_DEFAULT = 4;
+
+	static const u32 STATUS_ROW = 1;
+	static const u32 MAP_ROW = 5;
+
+	// V[NpXibvVbg̊Ԋuƌ̏
+	static const u32 SNAPSHOT_INTERVAL_MIN = 256;
+	static const u32 SNAPSHOT_MAX = 256;
+
+	// ȊÕL[
+	static const int KEY_NONE = -1;
+	static const int KEY_HOME = 0x100;
+	static const int KEY_END = 0x101;
+	static const int KEY_LEFT = 0x102;
+	static const int KEY_RIGHT = 0x103;
+	static const int KEY_UP = 0x104;
+	static const int KEY_DOWN = 0x105;
+
+	//-----------------------------------------------------------------------------
+	//! UTF-8Œǉ
+	//-----------------------------------------------------------------------------
+	void appendUTF8(std::string& out, s3d::wchar c)
+	{
+		const u32 u = static_cast<u32>(c);
+		if (u < 0x80) {
+			out += static_cast<char>(u);
+		} else if (u < 0x800) {
+			out += static_cast<char>(0xC0 | (u >> 6));
+			out += static_cast<char>(0x80 | (u & 0x3F));
+		} else {
+			out += static_cast<char>(0xE0 | (u >> 12));
+			out += static_cast<char>(0x80 | ((u >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (u & 0x3F));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! J[\ړ
+	//-----------------------------------------------------------------------------
+	void appendCursor(std::string& out, u32 row, u32 column)
+	{
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "\x1b[%u;%uH", row, column);
+		out += buf;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ʉ̍s
+	//-----------------------------------------------------------------------------
+	bool isFlooded(const app::Map& map, u32 water, u32 y)
+	{
+		return map.cell.height - static_cast<s32>(water) <= static_cast<s32>(y);
+	}
+
+#ifdef _WIN32
+	//===================================================================================
+	//! @class Terminal
+	//! R\[ŃGXP[vV[PXUTF-8LɂAL[͂ǂ
+	//===================================================================================
+	class Terminal
+	{
+	public:
+		Terminal()
+		{
+			const HANDLE handle = ::GetStdHandle(STD_OUTPUT_HANDLE);
+			DWORD mode = 0;
+			if (::GetConsoleMode(handle, &mode)) {
+				::SetConsoleMode(handle, mode | 0x0004 /* ENABLE_VIRTUAL_TERMINAL_PROCESSING */);
+			}
+			::SetConsoleOutputCP(CP_UTF8);
+		}
+
+		//! ĂȂKEY_NONE
+		int readKey()
+		{
+			if (!::_kbhit())
+				return KEY_NONE;
+
+			const int c = ::_getch();
+
+			// L[Ȃǂ2oCgœ͂
+			if (c == 0 || c == 0xE0) {
+				switch (::_getch()) {
+				case 71: return KEY_HOME;
+				case 79: return KEY_END;
+				case 75: return KEY_LEFT;
+				case 77: return KEY_RIGHT;
+				case 72: return KEY_UP;
+				case 80: return KEY_DOWN;
+				}
+				return KEY_NONE;
+			}
+			return c;
+		}
+	};
+#else
+	//===================================================================================
+	//! @class Terminal
+	//! [raw[hɂAL[͂ǂ
+	//! [gW͂ǂޏꍇ̂ŁAL[ /dev/tty ǂ
+	//===================================================================================
+	class Terminal
+	{
+	public:
+		Terminal()
+			: mFd(::open("/dev/tty", O_RDONLY | O_NOCTTY))
+			, mOwnFd(mFd >= 0)
+			, mRaw(false)
+		{
+			if (!mOwnFd) {
+				mFd = STDIN_FILENO;
+			}
+
+			if (::tcgetattr(mFd, &mSaved) == 0) {
+				termios raw = mSaved;
+				raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);	// Ctrl+Z/Ctrl+YL[ƂĎ󂯎
+				raw.c_iflag &= ~(IXON | ICRNL);
+				raw.c_cc[VMIN] = 0;
+				raw.c_cc[VTIME] = 0;
+				mRaw = ::tcsetattr(mFd, TCSANOW, &raw) == 0;
+			}
+		}
+
+		~Terminal()
+		{
+			if (mRaw) {
+				::tcsetattr(mFd, TCSANOW, &mSaved);
+			}
+			if (mOwnFd) {
+				::close(mFd);
+			}
+		}
+
+		Terminal(const Terminal&) = delete;
+		Terminal& operator=(const Terminal&) = delete;
+
+		//! ĂȂKEY_NONE
+		int readKey()
+		{
+			char buf[64];
+			ssize_t n;
+			while ((n = ::read(mFd, buf, sizeof(buf))) > 0) {
+				mInput.append(buf, static_cast<size_t>(n));
+			}
+
+			if (mInput.empty())
+				return KEY_NONE;
+
+			const int c = static_cast<unsigned char>(mInput[0]);
+			if (c != 0x1B || mInput.size() == 1 || (mInput[1] != '[' && mInput[1] != 'O')) {
+				mInput.erase(0, 1);
+				return c;
+			}
+
+			// ESC [ <> <I[> ̌`œ͂
+			size_t end = 2;
+			while (end < mInput.size() && (mInput[end] < 0x40 || 0x7E < mInput[end]))
+				++end;
+			if (end == mInput.size()) {
+				mInput.clear();
+				return KEY_NONE;
+			}
+
+			const std::string param = mInput.substr(2, end - 2);
+			const char last = mInput[end];
+			mInput.erase(0, end + 1);
+
+			switch (last) {
+			case 'A': return KEY_UP;
+			case 'B': return KEY_DOWN;
+			case 'C': return KEY_RIGHT;
+			case 'D': return KEY_LEFT;
+			case 'H': return KEY_HOME;
+			case 'F': return KEY_END;
+			case '~':
+				if (param == "1" || param == "7")
+					return KEY_HOME;
+				if (param == "4" || param == "8")
+					return KEY_END;
+				break;
+			}
+			return KEY_NONE;
+		}
+
+	private:
+		int mFd;
+		bool mOwnFd;
+		bool mRaw;
+		termios mSaved;
+		std::string mInput;
+	};
+#endif
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	TerminalViewer::TerminalViewer()
+		: mCommandPos(0)
+		, mSnapshotInterval(SNAPSHOT_INTERVAL_MIN)
+		, mPlaying(false)
+		, mSpeed(SPEED_DEFAULT)
+		, mPending(0.0)
+		, mShownWater(0)
+		, mRedrawAll(true)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	TerminalViewer::~TerminalViewer()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! }bvƃ[gǂݍ݁A擪ɖ߂
+	//! XibvVbg͍XSNAPSHOT_MAX+1ɂȂ悤Ԋu߂
+	//-----------------------------------------------------------------------------
+	bool TerminalViewer::load(const s3d::FilePath& filepath, const s3d::String& cmds)
+	{
+		Map map;
+		if (!Simulator::loadMap(filepath, mMapInfo, map))
+			return false;
+		map.info = &mMapInfo;
+
+		mFilePath = filepath;
+		mCommands = cmds;
+		mCommandPos = 0;
+		mMap = map;
+
+		const u32 num = static_cast<u32>(mCommands.length);
+		mSnapshotInterval = std::max(SNAPSHOT_INTERVAL_MIN, (num + SNAPSHOT_MAX - 1) / SNAPSHOT_MAX);
+		mSnapshots.clear();
+		mSnapshots.push_back(std::move(map));
+
+		mPlaying = false;
+		mPending = 0.0;
+		mRedrawAll = true;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! s
+	//! qEscŏI
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::run()
+	{
+		Terminal terminal;
+
+		// ʃNAƃJ[\\
+		mFrame += "\x1b[2J\x1b[?25l";
+
+		const auto interval = std::chrono::microseconds(1000000 / FRAME_RATE);
+		auto next = std::chrono::steady_clock::now();
+
+		for (;;)
+		{
+			bool quit = false;
+			for (int key; !quit && (key = terminal.readKey()) != KEY_NONE; ) {
+				quit = !processKey(key);
+			}
+			if (quit)
+				break;
+
+			advance();
+			render();
+			flush();
+
+			next += interval;
+			std::this_thread::sleep_until(next);
+		}
+
+		appendCursor(mFrame, MAP_ROW + mShownCells.height + 1, 1);
+		mFrame += "\x1b[0m\x1b[?25h";
+		flush();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! L[
+	//! GUIƓHome/EndŐ擪/ACtrl+Z/Ctrl+YEUndo/Redo
+	//! IƂfalseԂ
+	//-----------------------------------------------------------------------------
+	bool TerminalViewer::processKey(int key)
+	{
+		const u32 num = static_cast<u32>(mCommands.length);
+
+		switch (key) {
+		case 'q':
+		case 0x1B:	// Esc
+		case 0x03:	// Ctrl+C
+			return false;
+
+		case ' ':
+			mPlaying = !mPlaying;
+			mPending = 0.0;
+			break;
+
+		case KEY_HOME:
+		case 'g':
+			seek(0);
+			break;
+		case KEY_END:
+		case 'G':
+			seek(num);
+			break;
+		case KEY_LEFT:
+		case 0x1A:	// Ctrl+Z
+		case 'h':
+			seek(mCommandPos > 0 ? mCommandPos - 1 : 0);
+			break;
+		case KEY_RIGHT:
+		case 0x19:	// Ctrl+Y
+		case 'l':
+			seek(mCommandPos + 1);
+			break;
+
+		case KEY_UP:
+		case '+':
+		case '=':
+			mSpeed = std::min(mSpeed + 1, SPEED_MAX);
+			break;
+		case KEY_DOWN:
+		case '-':
+			mSpeed = mSpeed > SPEED_MIN ? mSpeed - 1 : SPEED_MIN;
+			break;
+
+		case 0x0C:	// Ctrl+L
+			mRedrawAll = true;
+			break;
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Đi߂
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::advance()
+	{
+		if (!mPlaying)
+			return;
+
+		const u32 num = static_cast<u32>(mCommands.length);
+		if (mCommandPos >= num) {
+			mPlaying = false;
+			return;
+		}
+
+		mPending += static_cast<f64>(1u << mSpeed) / FRAME_RATE;
+		const u32 step = static_cast<u32>(mPending);
+		if (step > 0) {
+			mPending -= step;
+			seek(std::min(mCommandPos + step, num));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! posԖڂ̃R}h܂ŎsՖʂɂ
+	//! ߂Ƃ͒ÕXibvVbgiߒ
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::seek(u32 pos)
+	{
+		pos = std::min(pos, static_cast<u32>(mCommands.length));
+
+		if (pos < mCommandPos) {
+			const u32 index = pos / mSnapshotInterval;
+			mMap = mSnapshots[index];
+			mCommandPos = index * mSnapshotInterval;
+		}
+
+		while (mCommandPos < pos)
+		{
+			// ߂l͔ՖʂςȂƂӖȂ̂ŌȂ
+			Simulator::step(commandOfChar(mCommands[mCommandPos]), mMap, mScratch);
+			++mCommandPos;
+
+			if (mCommandPos % mSnapshotInterval == 0 && mCommandPos / mSnapshotInterval == mSnapshots.size()) {
+				mSnapshots.push_back(mMap);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! `
+	//! Ot[ƔׂĕωZ̋Ԃ
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::render()
+	{
+		const Map& map{ mMap };
+
+		if (mShownCells.width != map.cell.width || mShownCells.height != map.cell.height) {
+			mRedrawAll = true;
+		}
+		if (mRedrawAll) {
+			mFrame += "\x1b[0m\x1b[2J";
+			for (auto& s : mShownStatus)
+				s.clear();
+		}
+
+		// Xe[^X
+		const s3d::String name = s3d::FileSystem::BaseName(mFilePath);
+		const s3d::String status[3] = {
+			s3d::Format(s3d::PyFmt, L"Map: {}  Size: ({},{})  Robot: ({},{})  Lambda: {}/{}  StepCount: {}  Score: {}  Condition: {}",
+				name, map.cell.width, map.cell.height, map.robotPos.x, map.cell.height - map.robotPos.y,
+				map.lambdaCollected, map.lambda, map.stepCount, map.score, stringOfCondition(map.condition)),
+			s3d::Format(s3d::PyFmt, L"Water: {}  Flooding: {}/{}  Waterproof: {}/{}  Growth: {}/{}  Razor: {}  Beard: {}",
+				map.water, map.floodingCount, map.info->flooding, map.waterproofCount, map.info->waterproof,
+				map.growthCount, map.info->growth, map.razor, map.beard),
+			s3d::Format(s3d::PyFmt, L"CommandCount: {}/{}  {}  Speed: {} step/s",
+				mCommandPos, static_cast<u32>(mCommands.length), mPlaying ? L"Play" : L"Pause", 1u << mSpeed),
+		};
+		for (u32 i = 0; i < 3; ++i) {
+			renderStatus(STATUS_ROW + i, status[i].narrow());
+		}
+
+		// Z
+		for (u32 y = 0; static_cast<s32>(y) < map.cell.height; ++y)
+		{
+			if (mRedrawAll || isFlooded(map, mShownWater, y) != isFlooded(map, map.water, y)) {
+				renderCells(y, 0, map.cell.width, map);
+				continue;
+			}
+
+			for (u32 x = 0; static_cast<s32>(x) < map.cell.width; )
+			{
+				if (mShownCells[y][x] == map.cell[y][x]) {
+					++x;
+					continue;
+				}
+
+				// AĕωZ͂܂Ƃ߂ď
+				u32 end = x + 1;
+				while (static_cast<s32>(end) < map.cell.width && mShownCells[y][end] != map.cell[y][end])
+					++end;
+
+				renderCells(y, x, end, map);
+				x = end;
+			}
+		}
+
+		mShownCells = map.cell;
+		mShownWater = map.water;
+		mRedrawAll = false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xe[^Xs`
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::renderStatus(u32 row, const std::string& line)
+	{
+		std::string& shown = mShownStatus[row - STATUS_ROW];
+		if (shown == line)
+			return;
+
+		appendCursor(mFrame, row, 1);
+		mFrame += line;
+		mFrame += "\x1b[K";
+		shown = line;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Z`
+	//! SpȂ̂1Z2
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::renderCells(u32 y, u32 x0, u32 x1, const Map& map)
+	{
+		appendCursor(mFrame, MAP_ROW + y, 1 + x0 * 2);
+
+		if (isFlooded(map, map.water, y)) {
+			mFrame += "\x1b[44m";
+		}
+		for (u32 x = x0; x < x1; ++x) {
+			for (const s3d::wchar* s = stringOfCell(map.cell[y][x]); *s; ++s)
+				appendUTF8(mFrame, *s);
+		}
+		mFrame += "\x1b[0m";
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 1t[܂Ƃ߂ďo
+	//-----------------------------------------------------------------------------
+	void TerminalViewer::flush()
+	{
+		if (mFrame.empty())
+			return;
+
+		std::fwrite(mFrame.data(), 1, mFrame.size(), stdout);
+		std::fflush(stdout);
+		mFrame.clear();
+	}
+
+}
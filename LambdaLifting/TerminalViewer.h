@@ -0,0 +1,67 @@
+//
+// Terminal Viewer
+//
+
+#pragma once
+
+#include "Map.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class TerminalViewer
+	//! GXP[vV[PXŒ[ɃvC\
+	//! Ot[ωZ
+	//! Ֆʂ1i߁AV[NpɈR}hƂ̃XibvVbgc
+	//===================================================================================
+	class TerminalViewer
+	{
+	public:
+		TerminalViewer();
+		~TerminalViewer();
+
+		TerminalViewer(const TerminalViewer&) = delete;
+		TerminalViewer& operator=(const TerminalViewer&) = delete;
+
+		bool load(const s3d::FilePath& filepath, const s3d::String& cmds);
+
+		void run();
+
+	private:
+		bool processKey(int key);
+		void advance();
+
+		void seek(u32 pos);
+
+		void render();
+		void renderStatus(u32 row, const std::string& line);
+		void renderCells(u32 y, u32 x0, u32 x1, const struct Map& map);
+
+		void flush();
+
+	private:
+		s3d::FilePath mFilePath;
+		MapInfo mMapInfo;
+		Map mMap;
+		s3d::Grid<Cell> mScratch;
+
+		s3d::String mCommands;
+		u32 mCommandPos;
+
+		std::vector<Map> mSnapshots;
+		u32 mSnapshotInterval;
+
+		bool mPlaying;
+		u32 mSpeed;
+		f64 mPending;
+
+		s3d::Grid<Cell> mShownCells;
+		u32 mShownWater;
+		std::string mShownStatus[3];
+		bool mRedrawAll;
+
+		std::string mFrame;
+	};
+
+}
@@ -0,0 +1,467 @@
+//
+// Tour Planner
+//
+
+#include "stdafx.h"
+#include "TourPlanner.h"
+
+#include "Simulator.h"
+#include "TaskPool.h"
+#include "Replay.h"
+#include "FloodModel.h"
+
+namespace {
+
+	static const s32 dx[4] = { 0, 0, -1, 1 };
+	static const s32 dy[4] = { -1, 1, 0, 0 };
+	static const app::Command MOVES[4] = { app::Command::Up, app::Command::Down, app::Command::Left, app::Command::Right };
+
+	// ͂Ȃn_Ԃ̋BoH̍vӂȂxɑ傫
+	static const s64 UNREACHABLE = 1 << 24;
+
+	// Or-opt œԂ̍ő咷
+	static const u32 SEGMENT_MAX = 3;
+
+	//-----------------------------------------------------------------------------
+	//! xorshift64
+	//-----------------------------------------------------------------------------
+	inline u64 nextRandom(u64& x)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Ώۂ
+	//-----------------------------------------------------------------------------
+	inline bool isLambdaSite(app::Cell c)
+	{
+		return c == app::Cell::Lambda || c == app::Cell::HORock;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! cmd ŗׂ̍Kɉ邩
+	//-----------------------------------------------------------------------------
+	inline bool canPushRock(const app::Map& map, app::Command cmd)
+	{
+		s32 dir = 0;
+		if (cmd == app::Command::Left) {
+			dir = -1;
+		} else if (cmd == app::Command::Right) {
+			dir = 1;
+		} else {
+			return false;
+		}
+
+		const app::int2 rock{ map.robotPos.x + dir, map.robotPos.y };
+		const s32 to = rock.x + dir;
+		if (to < 0 || to >= map.cell.width)
+			return false;
+		return app::cellType(map.cell[rock.y][rock.x]) == app::Cell::HORock && map.cell[rock.y][to] == app::Cell::Empty;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+#pragma region PathField
+
+	//-----------------------------------------------------------------------------
+	//! from ̍ŒZoH𕝗DTŋ߂
+	//! pushRock Ȃ牡ɉʂ̂Ƃ
+	//! ʂ͎Ō܂̂ŁA}Xɂ͑ĖhcĂǂ
+	//! ォ璅x͖hcĂ鎞c
+	//-----------------------------------------------------------------------------
+	void PathField::build(const Map& map, int2 from, bool pushRock)
+	{
+		const s32 w = map.cell.width, h = map.cell.height;
+		const FloodModel flood(map);
+		const u32 waterproof = map.info->waterproof;
+
+		width = w;
+		dist.assign(w * h, -1);
+		first.assign(w * h, -1);
+		air.assign(w * h, -1);
+		labels.clear();
+		labels.reserve(w * h);
+
+		const s32 start = from.y * w + from.x;
+		const Label root = { start, 0, map.waterproofCount, -1, 0, true, -1 };
+		dist[start] = 0;
+		first[start] = 0;
+		air[start] = root.air;
+		labels.push_back(root);
+
+		for (size_t head = 0; head < labels.size(); ++head)
+		{
+			const Label cur = labels[head];
+			if (!cur.expand)
+				continue;
+
+			const int2 pos{ cur.index % w, cur.index / w };
+			const u32 time = cur.time + 1;
+
+			for (u32 i = 0; i < 4; ++i)
+			{
+				// ͒E̕ɂi
+				if (cur.shave >= 0 && static_cast<s32>(i) != cur.shave)
+					continue;
+
+				int2 next{ pos.x + dx[i], pos.y + dy[i] };
+				if (next.x < 0 || next.y < 0 || next.x >= w || next.y >= h)
+					continue;
+
+				const Cell lc = map.cell[next.y][next.x];
+				bool expand = true;
+
+				switch (cellType(lc)) {
+				case Cell::Empty:
+				case Cell::Earth:
+				case Cell::Razor:
+				case Cell::Lambda:
+					break;
+				case Cell::Beard:
+				{
+					if (cur.shave >= 0)
+						break;
+					if (map.razor == 0)
+						continue;
+
+					// ̏1肩ĒB}Xɗ܂̂œ͋L^Ȃ
+					u32 shaveAir = waterproof;
+					if (time >= flood.submergeStep(pos.y)) {
+						if (cur.air == 0)
+							continue;
+						shaveAir = cur.air - 1;
+					}
+					const Label label = { cur.index, time, shaveAir, static_cast<s32>(head), charOfCommand(Command::Shave), true, static_cast<s32>(i) };
+					labels.push_back(label);
+					continue;
+				}
+				case Cell::Trampoline:
+					next = map.info->targetPos[map.info->jump[cellLabel(lc)]];
+					break;
+				case Cell::Rock:
+				{
+					// ̐悪󂢂ĂΉ
+					const s32 bx = next.x + dx[i];
+					if (!pushRock || dy[i] != 0 || bx < 0 || bx >= w || map.cell[next.y][bx] != Cell::Empty)
+						continue;
+					break;
+				}
+				case Cell::HORock:
+				case Cell::OpenLift:
+				case Cell::ClosedLift:
+					expand = false;
+					break;
+				default:
+					continue;
+				}
+
+				// Simulator::updateFlooding ƓAȂh1gAȂ疞^ɖ߂
+				u32 nextAir = waterproof;
+				if (time >= flood.submergeStep(next.y)) {
+					if (cur.air == 0)
+						continue;
+					nextAir = cur.air - 1;
+				}
+
+				const s32 index = next.y * w + next.x;
+				if (air[index] >= static_cast<s32>(nextAir))
+					continue;
+
+				air[index] = nextAir;
+				if (dist[index] < 0) {
+					dist[index] = time;
+					first[index] = static_cast<s32>(labels.size());
+				}
+
+				const Label label = { index, time, nextAir, static_cast<s32>(head), charOfCommand(MOVES[i]), expand, -1 };
+				labels.push_back(label);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//! pos ɍŏɒoH̃R}h
+	//-----------------------------------------------------------------------------
+	bool PathField::routeTo(int2 pos, s3d::String& route) const
+	{
+		s32 label = first[pos.y * width + pos.x];
+		if (label < 0)
+			return false;
+
+		route.clear();
+		for (; labels[label].parent >= 0; label = labels[label].parent) {
+			route += labels[label].cmd;
+		}
+		std::reverse(route.begin(), route.end());
+		return true;
+	}
+
+#pragma endregion
+
+
+#pragma region TourPlanner
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//-----------------------------------------------------------------------------
+	TourPlanner::TourPlanner(u32 threadNum, u32 restartNum)
+		: mThreadNum(threadNum)
+		, mRestartNum(std::max(1u, restartNum))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	TourPlanner::~TourPlanner()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! T
+	//! \AςǏTɍsAꂼۂɓ
+	//-----------------------------------------------------------------------------
+	void TourPlanner::solve(const Map& initial, SolverContext& ctx)
+	{
+		ctx.publish(s3d::String(1, charOfCommand(Command::Abort)), finalScore(initial));
+
+		// n_W߂Bǂݍݎ̉͂ŉłȂƕ_͉Ȃ
+		mSites.clear();
+		mSites.push_back(initial.robotPos);
+		for (u32 y = 0; y < initial.cell.height; ++y) {
+			for (u32 x = 0; x < initial.cell.width; ++x) {
+				if (isLambdaSite(cellType(initial.cell[y][x])) && !(initial.info->flagsAt(int2(x, y)) & CELL_DEAD_LAMBDA)) {
+					mSites.push_back(int2(x, y));
+				}
+			}
+		}
+		mSites.push_back(initial.info->liftPos);
+
+		// Sn_Ԃ̋Bg|ƔΏ̂ɂȂ
+		const u32 n = static_cast<u32>(mSites.size());
+		mCost.assign(n * n, UNREACHABLE);
+
+		TaskPool pool(mThreadNum);
+		pool.parallelFor(0, n, [&](u32 i) {
+			PathField field;
+			field.build(initial, mSites[i], true);
+			for (u32 j = 0; j < n; ++j) {
+				const s32 d = field.distanceTo(mSites[j]);
+				if (d >= 0) {
+					mCost[i * n + j] = d;
+				}
+			}
+		});
+
+		std::atomic<u32> done(0);
+		pool.parallelFor(0, mRestartNum, [&](u32 r) {
+			if (ctx.isCancelled())
+				return;
+
+			Tour path(n);
+			for (u32 i = 0; i < n; ++i) {
+				path[i] = i;
+			}
+
+			if (r == 0) {
+				// ŋߖT@
+				for (u32 i = 1; i + 2 < n; ++i) {
+					u32 best = i;
+					for (u32 j = i + 1; j + 1 < n; ++j) {
+						if (mCost[path[i - 1] * n + path[j]] < mCost[path[i - 1] * n + path[best]]) {
+							best = j;
+						}
+					}
+					std::swap(path[i], path[best]);
+				}
+			} else {
+				// [ăVbt
+				u64 random = 0x9E3779B97F4A7C15ull * r;
+				for (u32 i = n - 2; i > 1; --i) {
+					std::swap(path[i], path[1 + nextRandom(random) % i]);
+				}
+			}
+
+			optimize(path);
+			execute(path, initial, ctx);
+			done++;
+		});
+
+		ctx.addNodeNum(done);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! PłȂȂ܂ 2-opt  Or-opt JԂ
+	//-----------------------------------------------------------------------------
+	void TourPlanner::optimize(Tour& path) const
+	{
+		while (twoOpt(path) || orOpt(path))
+			;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 2-opt
+	//! Ώ̂Ȃ̂ŁA]Ԃ̒tɐ
+	//! ݐϘag1̕] O(1)
+	//-----------------------------------------------------------------------------
+	bool TourPlanner::twoOpt(Tour& path) const
+	{
+		const u32 n = static_cast<u32>(mSites.size());
+		const u32 m = static_cast<u32>(path.size());
+		if (m < 4)
+			return false;
+
+		// forward[k]: path[0..k] ɒH钷Abackward[k]: tɒH钷
+		std::vector<s64> forward(m, 0), backward(m, 0);
+		for (u32 k = 1; k < m; ++k) {
+			forward[k] = forward[k - 1] + mCost[path[k - 1] * n + path[k]];
+			backward[k] = backward[k - 1] + mCost[path[k] * n + path[k - 1]];
+		}
+
+		bool improved = false;
+		for (u32 i = 1; i + 2 < m; ++i) {
+			for (u32 j = i + 1; j + 1 < m; ++j)
+			{
+				const u32 a = path[i - 1], b = path[i], c = path[j], d = path[j + 1];
+				const s64 before = mCost[a * n + b] + (forward[j] - forward[i]) + mCost[c * n + d];
+				const s64 after = mCost[a * n + c] + (backward[j] - backward[i]) + mCost[b * n + d];
+				if (after < before) {
+					std::reverse(path.begin() + i, path.begin() + j + 1);
+					for (u32 k = i; k < m; ++k) {
+						forward[k] = forward[k - 1] + mCost[path[k - 1] * n + path[k]];
+						backward[k] = backward[k - 1] + mCost[path[k] * n + path[k - 1]];
+					}
+					improved = true;
+				}
+			}
+		}
+		return improved;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Or-opt
+	//! ZԂςɕʂ̈ʒuֈڂ
+	//-----------------------------------------------------------------------------
+	bool TourPlanner::orOpt(Tour& path) const
+	{
+		const u32 n = static_cast<u32>(mSites.size());
+		const u32 m = static_cast<u32>(path.size());
+
+		bool improved = false;
+		for (u32 len = 1; len <= SEGMENT_MAX; ++len) {
+			for (u32 i = 1; i + len < m; ++i)
+			{
+				//  path[i, i + len) Oɏkޒ
+				const u32 a = path[i - 1], s = path[i], e = path[i + len - 1], b = path[i + len];
+				const s64 removed = mCost[a * n + s] + mCost[e * n + b] - mCost[a * n + b];
+
+				for (u32 k = 0; k + 1 < m; ++k)
+				{
+					if (k + 1 >= i && k < i + len)
+						continue;
+
+					// path[k]  path[k + 1] ̊ԂɓꂽɐLт钷
+					const u32 p = path[k], q = path[k + 1];
+					const s64 added = mCost[p * n + s] + mCost[e * n + q] - mCost[p * n + q];
+					if (added < removed) {
+						if (k < i) {
+							std::rotate(path.begin() + k + 1, path.begin() + i, path.begin() + i + len);
+						} else {
+							std::rotate(path.begin() + i, path.begin() + i + len, path.begin() + k + 1);
+						}
+						improved = true;
+						break;
+					}
+				}
+			}
+		}
+		return improved;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ԂǂɎۂɓ
+	//! ₪̂ŋԂƂɌ݂̔ՖʂŌoHAς݂͂Ȃn_͔΂
+	//! rŎʋԂ͂̒n_ɌO܂Ŗ߂Ĕ΂
+	//! r̍ō_őł؂[go^
+	//-----------------------------------------------------------------------------
+	void TourPlanner::execute(const Tour& path, const Map& initial, SolverContext& ctx) const
+	{
+		Map map = initial, saved;
+		s3d::Grid<Cell> scratch;
+		PathField field;
+		s3d::String route, leg;
+
+		s32 bestScore = finalScore(map);
+		size_t bestLength = 0;
+		bool bestAbort = true;
+
+		for (size_t k = 1; k < path.size() && map.condition == Condition::Playing; ++k)
+		{
+			if (ctx.isCancelled())
+				return;
+
+			const int2 site = mSites[path[k]];
+			const Cell c = cellType(map.cell[site.y][site.x]);
+			const bool lift = k + 1 == path.size();
+			if (!lift && !isLambdaSite(c))
+				continue;
+			if (lift && c != Cell::OpenLift)
+				break;
+
+			// ƌ̌oHǂ₷̂ŁAɍs鎞͂
+			field.build(map, map.robotPos, false);
+			if (!field.routeTo(site, leg)) {
+				field.build(map, map.robotPos, true);
+				if (!field.routeTo(site, leg))
+					continue;
+			}
+
+
+			saved = map;
+			for (u32 i = 0; i < leg.length; ++i) {
+				const Command cmd = commandOfChar(leg[i]);
+
+				// Kɂ͓Ȃ̂ŁAŌ1͉ɉ鎞AȂΗׂŎ~܂
+				if (c == Cell::HORock && i + 1 == leg.length && !canPushRock(map, cmd)) {
+					leg.pop_back();
+					break;
+				}
+
+				Simulator::step(cmd, map, scratch);
+				if (map.condition != Condition::Playing)
+					break;
+			}
+			if (map.condition == Condition::Losing) {
+				map = saved;
+				continue;
+			}
+
+			// Ԃ̏IŖړĨ_̂ŁAԂ̏I肾
+			route += leg;
+			const s32 score = finalScore(map);
+			if (score > bestScore) {
+				bestScore = score;
+				bestLength = route.length;
+				bestAbort = map.condition == Condition::Playing;
+			}
+		}
+
+		if (bestScore > ctx.getBestScore()) {
+			s3d::String best{ route.substr(0, bestLength) };
+			if (bestAbort) {
+				best += charOfCommand(Command::Abort);
+			}
+			ctx.publish(best, bestScore);
+		}
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,81 @@
+//
+// Tour Planner
+//
+
+#pragma once
+
+#include "Map.h"
+#include "Solver.h"
+
+namespace app
+{
+
+	//===================================================================================
+	//! @struct PathField
+	//! 1_̍ŒZoHB͓Ȃ̂ƂAg|̈ړ܂
+	//! _AKAtg͍sɂ͂Ȃ邪AKƃtg͒ʂ蔲Ȃ
+	//! 䓁ΕE͒ĂʂBoH̓rŎg䓁̐E̐Lт͍lȂ
+	//! ^̂}bvł (ʒu, , c̖h) ŒTAMoH͍Ȃ
+	//===================================================================================
+	struct PathField
+	{
+		struct Label
+		{
+			s32 index;
+			u32 time;
+			u32 air;
+			s32 parent;
+			s3d::wchar cmd;
+			bool expand;
+			s32 shave;		// ɐiތBĂȂ-1
+		};
+
+		s32 width;
+		std::vector<s32> dist;		// ŏɒXebv
+		std::vector<s32> first;		// ŏɒx
+		std::vector<s32> air;		// x̒ōłc̖h
+		std::vector<Label> labels;
+
+		void build(const Map& map, int2 from, bool pushRock = false);
+
+		s32 distanceTo(int2 pos) const { return dist[pos.y * width + pos.x]; }
+		bool routeTo(int2 pos, s3d::String& route) const;
+	};
+
+	//===================================================================================
+	//! @class TourPlanner
+	//! _鏇ԂZ[X}Ƃĉ
+	//! Sn_Ԃ̋ɋ߁A_ȏ 2-opt  Or-opt ŉP
+	//! ꂽԂ͎ۂɃV~[^[œĊm߂
+	//===================================================================================
+	class TourPlanner : public Solver
+	{
+	public:
+		explicit TourPlanner(u32 threadNum = 0, u32 restartNum = 64);
+		~TourPlanner();
+
+		const s3d::wchar* getName() const override { return L"tour"; }
+
+		void solve(const Map& map, SolverContext& ctx) override;
+
+		void setRestartNum(u32 num){ mRestartNum = std::max(1u, num); }
+
+	private:
+		using Tour = std::vector<u32>;
+
+		void optimize(Tour& path) const;
+		bool twoOpt(Tour& path) const;
+		bool orOpt(Tour& path) const;
+
+		void execute(const Tour& path, const Map& initial, SolverContext& ctx) const;
+
+	private:
+		u32 mThreadNum;
+		u32 mRestartNum;
+
+		// n_B0{bgAŌオtgÅԂ_ƍK
+		std::vector<int2> mSites;
+		std::vector<s64> mCost;
+	};
+
+}
@@ -0,0 +1,316 @@
+//
+// Transposition Table
+//
+
+#include "stdafx.h"
+#include "TranspositionTable.h"
+
+#include "Map.h"
+
+namespace {
+
+	// R}h3rbgŎB0̓R}hȂ
+	static const s3d::wchar COMMAND_CHARS[] = L"UDLRWSA";
+
+	//-----------------------------------------------------------------------------
+	//! R}h̔ԍ
+	//-----------------------------------------------------------------------------
+	u64 codeOfCommand(s3d::wchar c)
+	{
+		for (u64 i = 0; COMMAND_CHARS[i]; ++i) {
+			if (COMMAND_CHARS[i] == c)
+				return i + 1;
+		}
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! a ̕ǂL^BXRAA_Ȃ班Ȃ萔
+	//-----------------------------------------------------------------------------
+	inline bool isBetter(const app::TranspositionTable::Entry& a, const app::TranspositionTable::Entry& b)
+	{
+		return a.score != b.score ? a.score > b.score : a.depth < b.depth;
+	}
+
+} // unnamed namespace
+
+
+namespace app
+{
+
+	//-----------------------------------------------------------------------------
+	//! ctor
+	//! bytes Ɏ܂ő2ׂ̂̃oPbgmۂ
+	//-----------------------------------------------------------------------------
+	TranspositionTable::TranspositionTable(size_t bytes)
+		: mSlotNum(0)
+		, mBucketMask(0)
+		, mGeneration(0)
+	{
+		const size_t bucketBytes = sizeof(Slot) * BUCKET_SIZE;
+		size_t bucketNum = 1;
+		while (bucketNum * 2 * bucketBytes <= bytes) {
+			bucketNum *= 2;
+		}
+
+		mSlotNum = bucketNum * BUCKET_SIZE;
+		mBucketMask = bucketNum - 1;
+		mpSlots.reset(new Slot[mSlotNum]);
+		mpCounters.reset(new Counters[COUNTER_NUM]);
+		clear();
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dtor
+	//-----------------------------------------------------------------------------
+	TranspositionTable::~TranspositionTable()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ׂĂ̋L^ƓvB̃XbhGĂȂɌĂ
+	//-----------------------------------------------------------------------------
+	void TranspositionTable::clear()
+	{
+		for (size_t i = 0; i < mSlotNum; ++i) {
+			mpSlots[i].key.store(0, std::memory_order_relaxed);
+			mpSlots[i].data.store(0, std::memory_order_relaxed);
+			mpSlots[i].parent.store(0, std::memory_order_relaxed);
+			mpSlots[i].check.store(0, std::memory_order_relaxed);
+		}
+		for (u32 i = 0; i < COUNTER_NUM; ++i) {
+			Counters& c = mpCounters[i];
+			c.probe = 0;
+			c.hit = 0;
+			c.store = 0;
+			c.insert = 0;
+			c.improve = 0;
+			c.collision = 0;
+			c.torn = 0;
+			c.used = 0;
+		}
+		mGeneration = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! L^
+	//-----------------------------------------------------------------------------
+	bool TranspositionTable::probe(u64 hash, Entry& entry) const
+	{
+		const size_t bucket = static_cast<size_t>(hash) & mBucketMask;
+		const Slot* slots = &mpSlots[bucket * BUCKET_SIZE];
+		Counters& counters = countersOf(bucket);
+		counters.probe.fetch_add(1, std::memory_order_relaxed);
+
+		const u64 key = keyOf(hash);
+		u8 generation;
+		for (u32 i = 0; i < BUCKET_SIZE; ++i) {
+			if (slots[i].key.load(std::memory_order_relaxed) == key && read(slots[i], entry, generation)) {
+				counters.hit.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! L^
+	//! ՖʂΗǂcB΋󂫂AݓrŉꂽXbgA
+	//! łÂōłXRA̒ႢL^ǂoē
+	//! Xbg̓nbV̌CASŎ̂ŁAXbg2̃Xbh邱Ƃ͂Ȃ
+	//! 荇ɕoPbg𒲂גAL^ɐi߂
+	//! ǂoL^͒gŌ܂̂ŁAɏΓ\ɂȂ
+	//-----------------------------------------------------------------------------
+	TranspositionTable::StoreResult TranspositionTable::store(const Entry& entry)
+	{
+		const size_t bucket = static_cast<size_t>(entry.hash) & mBucketMask;
+		Slot* slots = &mpSlots[bucket * BUCKET_SIZE];
+		Counters& counters = countersOf(bucket);
+		counters.store.fetch_add(1, std::memory_order_relaxed);
+
+		const u64 key = keyOf(entry.hash);
+
+		for (u32 retry = 0; retry < BUCKET_SIZE; ++retry)
+		{
+			s32 empty = -1, torn = -1, victim = -1;
+			u64 tornKey = 0;
+			Entry victimEntry;
+			u32 victimAge = 0;
+
+			Entry cur;
+			u8 generation;
+			for (u32 i = 0; i < BUCKET_SIZE; ++i)
+			{
+				const u64 k = slots[i].key.load(std::memory_order_acquire);
+				if (k == 0) {
+					if (empty < 0)
+						empty = i;
+					continue;
+				}
+
+				if (!read(slots[i], cur, generation)) {
+					counters.torn.fetch_add(1, std::memory_order_relaxed);
+
+					// ՖʂݓrȂ珑
+					if (k == key) {
+						write(slots[i], key, entry);
+						counters.improve.fetch_add(1, std::memory_order_relaxed);
+						return StoreResult::Improved;
+					}
+					if (torn < 0) {
+						torn = i;
+						tornKey = k;
+					}
+					continue;
+				}
+
+				if (k == key)
+				{
+					if (!isBetter(entry, cur))
+						return StoreResult::Rejected;
+
+					write(slots[i], key, entry);
+					counters.improve.fetch_add(1, std::memory_order_relaxed);
+					return StoreResult::Improved;
+				}
+
+				// ͈̂ŁA̐ォ̍ŌÂ𑪂
+				const u32 age = static_cast<u8>(mGeneration - generation);
+				bool worse = victim < 0 || age > victimAge;
+				if (victim >= 0 && age == victimAge) {
+					if (cur.score != victimEntry.score)
+						worse = cur.score < victimEntry.score;
+					else if (cur.depth != victimEntry.depth)
+						worse = cur.depth > victimEntry.depth;
+					else
+						worse = cur.hash < victimEntry.hash;
+				}
+				if (worse) {
+					victim = i;
+					victimEntry = cur;
+					victimAge = age;
+				}
+			}
+
+			if (empty >= 0) {
+				u64 expected = 0;
+				if (slots[empty].key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+					write(slots[empty], key, entry);
+					counters.used.fetch_add(1, std::memory_order_relaxed);
+					counters.insert.fetch_add(1, std::memory_order_relaxed);
+					return StoreResult::Inserted;
+				}
+				continue;
+			}
+
+			const s32 target = torn >= 0 ? torn : victim;
+			u64 expected = torn >= 0 ? tornKey : keyOf(victimEntry.hash);
+			if (target >= 0 && slots[target].key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+				write(slots[target], key, entry);
+				if (torn < 0) {
+					counters.collision.fetch_add(1, std::memory_order_relaxed);
+				}
+				counters.insert.fetch_add(1, std::memory_order_relaxed);
+				return StoreResult::Inserted;
+			}
+		}
+
+		// ȂAׂĂȂՖʂƂĈ
+		return StoreResult::Inserted;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! vW߂
+	//-----------------------------------------------------------------------------
+	TranspositionTable::Stats TranspositionTable::getStats() const
+	{
+		Stats stats = {};
+		for (u32 i = 0; i < COUNTER_NUM; ++i) {
+			const Counters& c = mpCounters[i];
+			stats.probeNum += c.probe;
+			stats.hitNum += c.hit;
+			stats.storeNum += c.store;
+			stats.insertNum += c.insert;
+			stats.improveNum += c.improve;
+			stats.collisionNum += c.collision;
+			stats.tornNum += c.torn;
+			stats.usedNum += c.used;
+		}
+		stats.slotNum = mSlotNum;
+		return stats;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XRAA萔AR}hA1ɋl߂
+	//-----------------------------------------------------------------------------
+	u64 TranspositionTable::pack(const Entry& entry, u8 generation)
+	{
+		const u64 depth = std::min<u32>(entry.depth, DEPTH_MAX);
+		return static_cast<u64>(static_cast<u32>(entry.score))
+			| (depth << 32)
+			| (codeOfCommand(entry.cmd) << 53)
+			| (static_cast<u64>(generation) << 56);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! pack ̋t
+	//-----------------------------------------------------------------------------
+	void TranspositionTable::unpack(u64 data, Entry& entry, u8& generation)
+	{
+		const u32 code = static_cast<u32>(data >> 53) & 7;
+		entry.score = static_cast<s32>(static_cast<u32>(data));
+		entry.depth = static_cast<u32>(data >> 32) & DEPTH_MAX;
+		entry.cmd = code > 0 ? COMMAND_CHARS[code - 1] : 0;
+		generation = static_cast<u8>(data >> 56);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! 3̃`FbNTB0͏ݒ̈ɎĝŕԂȂ
+	//-----------------------------------------------------------------------------
+	u64 TranspositionTable::checksumOf(u64 key, u64 data, u64 parent)
+	{
+		u64 x = key ^ (data * 0x9E3779B97F4A7C15ull) ^ (parent * 0xC2B2AE3D27D4EB4Full);
+		x ^= x >> 31;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 29;
+		return x != 0 ? x : 1;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! XbgǂށB󂩁ÃXbhݒŌꂪĂȂfalse
+	//! `FbNTǂݒāAǂłԂɏĂȂƂm߂
+	//-----------------------------------------------------------------------------
+	bool TranspositionTable::read(const Slot& slot, Entry& entry, u8& generation) const
+	{
+		const u64 check = slot.check.load(std::memory_order_acquire);
+		if (check == 0)
+			return false;
+
+		const u64 key = slot.key.load(std::memory_order_relaxed);
+		const u64 data = slot.data.load(std::memory_order_relaxed);
+		const u64 parent = slot.parent.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.check.load(std::memory_order_relaxed) != check || checksumOf(key, data, parent) != check)
+			return false;
+
+		entry.hash = key;
+		entry.parent = parent;
+		unpack(data, entry, generation);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Xbgɏ
+	//! Ƀ`FbNTAŌɏ̂ŁAǂݎ͑ĂȂ̂Ă
+	//-----------------------------------------------------------------------------
+	void TranspositionTable::write(Slot& slot, u64 key, const Entry& entry)
+	{
+		const u64 data = pack(entry, mGeneration);
+		slot.check.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.data.store(data, std::memory_order_relaxed);
+		slot.parent.store(entry.parent, std::memory_order_relaxed);
+		slot.check.store(checksumOf(key, data, entry.parent), std::memory_order_release);
+	}
+
+}
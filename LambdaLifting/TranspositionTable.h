@@ -0,0 +1,132 @@
+//
+// Transposition Table
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace app
+{
+
+	//===================================================================================
+	//! @class TranspositionTable
+	//! Ֆʂ̃nbVABō_Ǝ萔Ae̔ՖʂŒTCY̕\
+	//! ǂݏ̓bNȂBXbg͔Ֆʂ̃nbV̌CASŎ荇A
+	//! č̓`FbNTŌ؂āAݓr̒l͖Ƃɂ
+	//! 4Xbg̃oPbg܂AÂAႢXRȀɒǂo
+	//===================================================================================
+	class TranspositionTable
+	{
+	public:
+		//! 1̔Ֆʂ̋L^
+		struct Entry
+		{
+			u64 hash;
+			u64 parent;			// e̔Ֆʂ̃nbVB0
+			s32 score;
+			u32 depth;
+			s3d::wchar cmd;		// ẽR}h
+		};
+
+		enum class StoreResult
+		{
+			Inserted,	// Vꂽ
+			Improved,	// ɂL^ǂ̂Œu
+			Rejected,	// ɓǂL^
+		};
+
+		struct Stats
+		{
+			u64 probeNum;
+			u64 hitNum;
+			u64 storeNum;
+			u64 insertNum;
+			u64 improveNum;
+			u64 collisionNum;	// oPbg̔ՖʂŖ܂ĂĒǂo
+			u64 tornNum;		// ݓr̃Xbgǂ
+			u64 slotNum;
+			u64 usedNum;
+
+			f64 hitRate() const { return probeNum > 0 ? static_cast<f64>(hitNum) / probeNum : 0.0; }
+			f64 load() const { return slotNum > 0 ? static_cast<f64>(usedNum) / slotNum : 0.0; }
+		};
+
+		static const u32 BUCKET_SIZE = 4;
+		static const u32 DEPTH_MAX = (1 << 21) - 1;
+
+		explicit TranspositionTable(size_t bytes = 64 << 20);
+		~TranspositionTable();
+
+		void clear();
+
+		bool probe(u64 hash, Entry& entry) const;
+		StoreResult store(const Entry& entry);
+
+		//! ȍ~ɏL^̐BǂoɌÂォI
+		void setGeneration(u32 generation){ mGeneration = static_cast<u8>(generation); }
+
+		//! LȋL^ׂė񋓂B̃XbhĂȂɌĂ
+		template<class Func>
+		void forEach(Func func) const
+		{
+			Entry entry;
+			u8 generation;
+			for (size_t i = 0; i < mSlotNum; ++i) {
+				if (read(mpSlots[i], entry, generation)) {
+					func(entry);
+				}
+			}
+		}
+
+		size_t getSlotNum() const { return mSlotNum; }
+		Stats getStats() const;
+
+	private:
+		TranspositionTable(const TranspositionTable&) = delete;
+		TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+		struct Slot
+		{
+			std::atomic<u64> key;		// Ֆʂ̃nbVB0͋
+			std::atomic<u64> data;		// score:32 depth:21 cmd:3 generation:8
+			std::atomic<u64> parent;
+			std::atomic<u64> check;		// 3̃`FbNTB0͏ݒ
+		};
+
+		//! vBXbhԂœLbVCDȂ悤oPbgƂɎU炷
+		struct Counters
+		{
+			std::atomic<u64> probe;
+			std::atomic<u64> hit;
+			std::atomic<u64> store;
+			std::atomic<u64> insert;
+			std::atomic<u64> improve;
+			std::atomic<u64> collision;
+			std::atomic<u64> torn;
+			std::atomic<u64> used;
+		};
+		static const u32 COUNTER_NUM = 16;
+
+		static u64 pack(const Entry& entry, u8 generation);
+		static void unpack(u64 data, Entry& entry, u8& generation);
+
+		static u64 keyOf(u64 hash) { return hash != 0 ? hash : 1; }
+		static u64 checksumOf(u64 key, u64 data, u64 parent);
+
+		bool read(const Slot& slot, Entry& entry, u8& generation) const;
+		void write(Slot& slot, u64 key, const Entry& entry);
+
+		Counters& countersOf(size_t bucket) const { return mpCounters[bucket % COUNTER_NUM]; }
+
+	private:
+		std::unique_ptr<Slot[]> mpSlots;
+		size_t mSlotNum;
+		size_t mBucketMask;
+		u8 mGeneration;
+
+		std::unique_ptr<Counters[]> mpCounters;
+	};
+
+}
@@ -0,0 +1,509 @@
+//
+// Lambda Lifting Python Module
+//
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <vector>
+
+#include "../LambdaLifting/LambdaLiftingAPI.h"
+
+namespace {
+
+	static const Py_ssize_t STATE_NUM = sizeof(LLState) / sizeof(int32_t);
+
+	//===================================================================================
+	//! @struct MapObject
+	//===================================================================================
+	struct MapObject
+	{
+		PyObject_HEAD
+		LLMap* map;
+		Py_ssize_t shape[2];
+		Py_ssize_t strides[2];
+		Py_ssize_t exports;		// Z̃obt@݂Ă鐔
+		bool busy;				// GILOĎs
+	};
+
+	//===================================================================================
+	//! @struct StateObject
+	//! LLState ̂܂ int32 ̔zƂČ
+	//===================================================================================
+	struct StateObject
+	{
+		PyObject_HEAD
+		MapObject* owner;
+	};
+
+	extern PyTypeObject MapType;
+	extern PyTypeObject StateType;
+
+#pragma region Map
+
+	//-----------------------------------------------------------------------------
+	//! LLMap bv
+	//-----------------------------------------------------------------------------
+	PyObject* wrapMap(LLMap* map)
+	{
+		if (!map) {
+			PyErr_SetString(PyExc_ValueError, "failed to load map");
+			return nullptr;
+		}
+
+		MapObject* self = PyObject_New(MapObject, &MapType);
+		if (!self) {
+			llFreeMap(map);
+			return nullptr;
+		}
+		self->map = map;
+		self->exports = 0;
+		self->busy = false;
+		return reinterpret_cast<PyObject*>(self);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! ̃XbhsłȂ
+	//-----------------------------------------------------------------------------
+	bool checkIdle(MapObject* self)
+	{
+		if (self->busy) {
+			PyErr_SetString(PyExc_RuntimeError, "map is being stepped by another thread");
+			return false;
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! dealloc
+	//-----------------------------------------------------------------------------
+	void mapDealloc(MapObject* self)
+	{
+		llFreeMap(self->map);
+		PyObject_Del(self);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.clone()
+	//-----------------------------------------------------------------------------
+	PyObject* mapClone(MapObject* self, PyObject*)
+	{
+		if (!checkIdle(self))
+			return nullptr;
+
+		return wrapMap(llCloneMap(self->map));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.copy_from(other)
+	//! 傫ႤƃZĊmۂ̂ŁAobt@݂ĂԂ͋ۂ
+	//-----------------------------------------------------------------------------
+	PyObject* mapCopyFrom(MapObject* self, PyObject* arg)
+	{
+		if (!PyObject_TypeCheck(arg, &MapType)) {
+			PyErr_SetString(PyExc_TypeError, "expected Map");
+			return nullptr;
+		}
+		MapObject* other = reinterpret_cast<MapObject*>(arg);
+		if (!checkIdle(self) || !checkIdle(other))
+			return nullptr;
+
+		uint32_t w0, h0, w1, h1;
+		llGetCells(self->map, &w0, &h0);
+		llGetCells(other->map, &w1, &h1);
+		if (self->exports > 0 && (w0 != w1 || h0 != h1)) {
+			PyErr_SetString(PyExc_BufferError, "cells are exported and the map size differs");
+			return nullptr;
+		}
+
+		llCopyMap(self->map, other->map);
+		Py_RETURN_NONE;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.step(cmd)
+	//! 1R}hȂGILO葬̂ŕێ܂܎s
+	//-----------------------------------------------------------------------------
+	PyObject* mapStep(MapObject* self, PyObject* arg)
+	{
+		if (!PyUnicode_Check(arg) || PyUnicode_GET_LENGTH(arg) != 1) {
+			PyErr_SetString(PyExc_TypeError, "expected a single command character");
+			return nullptr;
+		}
+		if (!checkIdle(self))
+			return nullptr;
+
+		const Py_UCS4 c = PyUnicode_READ_CHAR(arg, 0);
+		return PyLong_FromLong(llStep(self->map, c < 0x80 ? static_cast<char>(c) : '?'));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.run(cmds)
+	//! GILOĎs
+	//! s͂̃}bvւ̑̑r[̎擾ۂ
+	//! 擾ς݂̃r[͏r̔ՖʂŵŁAI܂œǂ܂Ȃ
+	//-----------------------------------------------------------------------------
+	PyObject* mapRun(MapObject* self, PyObject* arg)
+	{
+		Py_ssize_t length = 0;
+		const char* cmds = PyUnicode_Check(arg) ? PyUnicode_AsUTF8AndSize(arg, &length) : nullptr;
+		if (!cmds) {
+			if (!PyErr_Occurred())
+				PyErr_SetString(PyExc_TypeError, "expected str");
+			return nullptr;
+		}
+		if (!checkIdle(self))
+			return nullptr;
+
+		// cmds  arg ĂԂ͗L
+		self->busy = true;
+		uint32_t count;
+		Py_BEGIN_ALLOW_THREADS
+		count = llRun(self->map, cmds, static_cast<size_t>(length));
+		Py_END_ALLOW_THREADS
+		self->busy = false;
+
+		return PyLong_FromUnsignedLong(count);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.score()
+	//-----------------------------------------------------------------------------
+	PyObject* mapScore(MapObject* self, PyObject*)
+	{
+		if (!checkIdle(self))
+			return nullptr;
+
+		return PyLong_FromLong(llScore(self->map));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.cells
+	//! (height, width)  uint16 r[
+	//-----------------------------------------------------------------------------
+	PyObject* mapGetCells(MapObject* self, void*)
+	{
+		return PyMemoryView_FromObject(reinterpret_cast<PyObject*>(self));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.state
+	//! STATE_FIELDS  int32 r[
+	//-----------------------------------------------------------------------------
+	PyObject* mapGetState(MapObject* self, void*)
+	{
+		StateObject* state = PyObject_New(StateObject, &StateType);
+		if (!state)
+			return nullptr;
+		Py_INCREF(self);
+		state->owner = self;
+
+		PyObject* view = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(state));
+		Py_DECREF(state);
+		return view;
+	}
+
+	//-----------------------------------------------------------------------------
+	//! Map.width / Map.height
+	//-----------------------------------------------------------------------------
+	PyObject* mapGetWidth(MapObject* self, void*)
+	{
+		uint32_t w;
+		llGetCells(self->map, &w, nullptr);
+		return PyLong_FromUnsignedLong(w);
+	}
+
+	PyObject* mapGetHeight(MapObject* self, void*)
+	{
+		uint32_t h;
+		llGetCells(self->map, nullptr, &h);
+		return PyLong_FromUnsignedLong(h);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! obt@vgR
+	//! Z Map ̐̂œǂݎp
+	//-----------------------------------------------------------------------------
+	int mapGetBuffer(MapObject* self, Py_buffer* view, int flags)
+	{
+		if (flags & PyBUF_WRITABLE) {
+			PyErr_SetString(PyExc_BufferError, "cells are read-only");
+			view->obj = nullptr;
+			return -1;
+		}
+		if (!checkIdle(self)) {
+			view->obj = nullptr;
+			return -1;
+		}
+
+		uint32_t w, h;
+		const uint16_t* cells = llGetCells(self->map, &w, &h);
+
+		self->shape[0] = h;
+		self->shape[1] = w;
+		self->strides[0] = static_cast<Py_ssize_t>(w * sizeof(uint16_t));
+		self->strides[1] = sizeof(uint16_t);
+
+		view->buf = const_cast<uint16_t*>(cells);
+		view->obj = reinterpret_cast<PyObject*>(self);
+		view->len = static_cast<Py_ssize_t>(w) * h * sizeof(uint16_t);
+		view->readonly = 1;
+		view->itemsize = sizeof(uint16_t);
+		view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("H") : nullptr;
+		view->ndim = 2;
+		view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+		view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : nullptr;
+		view->suboffsets = nullptr;
+		view->internal = nullptr;
+
+		Py_INCREF(self);
+		self->exports++;
+		return 0;
+	}
+
+	void mapReleaseBuffer(MapObject* self, Py_buffer*)
+	{
+		self->exports--;
+	}
+
+	PyMethodDef mapMethods[] = {
+		{ "clone", reinterpret_cast<PyCFunction>(mapClone), METH_NOARGS, "Return an independent copy of the map." },
+		{ "copy_from", reinterpret_cast<PyCFunction>(mapCopyFrom), METH_O, "Overwrite this map with another one." },
+		{ "step", reinterpret_cast<PyCFunction>(mapStep), METH_O, "Apply one command. Returns 1 if changed, 0 if not, -1 if invalid." },
+		{ "run", reinterpret_cast<PyCFunction>(mapRun), METH_O, "Apply commands without holding the GIL. Returns the number of changes." },
+		{ "score", reinterpret_cast<PyCFunction>(mapScore), METH_NOARGS, "Final score, aborting if still playing." },
+		{ nullptr, nullptr, 0, nullptr },
+	};
+
+	PyGetSetDef mapGetSet[] = {
+		{ const_cast<char*>("cells"), reinterpret_cast<getter>(mapGetCells), nullptr, const_cast<char*>("Zero-copy (height, width) uint16 view of the cells."), nullptr },
+		{ const_cast<char*>("state"), reinterpret_cast<getter>(mapGetState), nullptr, const_cast<char*>("Zero-copy int32 view of the counters."), nullptr },
+		{ const_cast<char*>("width"), reinterpret_cast<getter>(mapGetWidth), nullptr, nullptr, nullptr },
+		{ const_cast<char*>("height"), reinterpret_cast<getter>(mapGetHeight), nullptr, nullptr, nullptr },
+		{ nullptr, nullptr, nullptr, nullptr, nullptr },
+	};
+
+	PyBufferProcs mapBuffer = {
+		reinterpret_cast<getbufferproc>(mapGetBuffer),
+		reinterpret_cast<releasebufferproc>(mapReleaseBuffer),
+	};
+
+#pragma endregion
+
+
+#pragma region State
+
+	//-----------------------------------------------------------------------------
+	//! dealloc
+	//-----------------------------------------------------------------------------
+	void stateDealloc(StateObject* self)
+	{
+		Py_XDECREF(self->owner);
+		PyObject_Del(self);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! obt@vgR
+	//-----------------------------------------------------------------------------
+	int stateGetBuffer(StateObject* self, Py_buffer* view, int flags)
+	{
+		static Py_ssize_t shape[1] = { STATE_NUM };
+		static Py_ssize_t strides[1] = { sizeof(int32_t) };
+
+		if (flags & PyBUF_WRITABLE) {
+			PyErr_SetString(PyExc_BufferError, "state is read-only");
+			view->obj = nullptr;
+			return -1;
+		}
+		if (!checkIdle(self->owner)) {
+			view->obj = nullptr;
+			return -1;
+		}
+
+		view->buf = const_cast<LLState*>(llGetState(self->owner->map));
+		view->obj = reinterpret_cast<PyObject*>(self);
+		view->len = sizeof(LLState);
+		view->readonly = 1;
+		view->itemsize = sizeof(int32_t);
+		view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("i") : nullptr;
+		view->ndim = 1;
+		view->shape = (flags & PyBUF_ND) ? shape : nullptr;
+		view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? strides : nullptr;
+		view->suboffsets = nullptr;
+		view->internal = nullptr;
+
+		Py_INCREF(self);
+		return 0;
+	}
+
+	PyBufferProcs stateBuffer = {
+		reinterpret_cast<getbufferproc>(stateGetBuffer),
+		nullptr,
+	};
+
+#pragma endregion
+
+
+#pragma region Module
+
+	//-----------------------------------------------------------------------------
+	//! load(path)
+	//-----------------------------------------------------------------------------
+	PyObject* moduleLoad(PyObject*, PyObject* arg)
+	{
+		wchar_t* path = PyUnicode_Check(arg) ? PyUnicode_AsWideCharString(arg, nullptr) : nullptr;
+		if (!path) {
+			if (!PyErr_Occurred())
+				PyErr_SetString(PyExc_TypeError, "expected str");
+			return nullptr;
+		}
+
+		LLMap* map;
+		Py_BEGIN_ALLOW_THREADS
+		map = llLoadMap(path);
+		Py_END_ALLOW_THREADS
+		PyMem_Free(path);
+
+		return wrapMap(map);
+	}
+
+	//-----------------------------------------------------------------------------
+	//! parse(text)
+	//-----------------------------------------------------------------------------
+	PyObject* moduleParse(PyObject*, PyObject* arg)
+	{
+		Py_ssize_t length = 0;
+		const char* text = PyUnicode_Check(arg) ? PyUnicode_AsUTF8AndSize(arg, &length) : nullptr;
+		if (!text) {
+			if (!PyErr_Occurred())
+				PyErr_SetString(PyExc_TypeError, "expected str");
+			return nullptr;
+		}
+		return wrapMap(llParseMap(text, static_cast<size_t>(length)));
+	}
+
+	//-----------------------------------------------------------------------------
+	//! step_batch(maps, cmds)
+	//! maps[i]  cmds[i] KpBGILOĎs
+	//-----------------------------------------------------------------------------
+	PyObject* moduleStepBatch(PyObject*, PyObject* args)
+	{
+		PyObject* seq;
+		const char* cmds;
+		Py_ssize_t length;
+		if (!PyArg_ParseTuple(args, "Os#", &seq, &cmds, &length))
+			return nullptr;
+
+		PyObject* fast = PySequence_Fast(seq, "expected a sequence of Map");
+		if (!fast)
+			return nullptr;
+
+		const Py_ssize_t count = PySequence_Fast_GET_SIZE(fast);
+		if (count != length) {
+			Py_DECREF(fast);
+			PyErr_SetString(PyExc_ValueError, "maps and cmds must have the same length");
+			return nullptr;
+		}
+
+		PyObject** items = PySequence_Fast_ITEMS(fast);
+		std::vector<LLMap*> maps(static_cast<size_t>(count));
+		for (Py_ssize_t i = 0; i < count; ++i) {
+			if (!PyObject_TypeCheck(items[i], &MapType)) {
+				Py_DECREF(fast);
+				PyErr_SetString(PyExc_TypeError, "expected a sequence of Map");
+				return nullptr;
+			}
+			MapObject* m = reinterpret_cast<MapObject*>(items[i]);
+			if (!checkIdle(m)) {
+				Py_DECREF(fast);
+				return nullptr;
+			}
+			maps[i] = m->map;
+		}
+
+		for (Py_ssize_t i = 0; i < count; ++i)
+			reinterpret_cast<MapObject*>(items[i])->busy = true;
+
+		std::vector<int32_t> results(static_cast<size_t>(count));
+		Py_BEGIN_ALLOW_THREADS
+		llStepBatch(maps.data(), cmds, static_cast<size_t>(count), results.data());
+		Py_END_ALLOW_THREADS
+
+		for (Py_ssize_t i = 0; i < count; ++i)
+			reinterpret_cast<MapObject*>(items[i])->busy = false;
+		Py_DECREF(fast);
+
+		PyObject* list = PyList_New(count);
+		if (!list)
+			return nullptr;
+		for (Py_ssize_t i = 0; i < count; ++i)
+			PyList_SET_ITEM(list, i, PyLong_FromLong(results[i]));
+		return list;
+	}
+
+	PyMethodDef moduleMethods[] = {
+		{ "load", moduleLoad, METH_O, "Load a map file." },
+		{ "parse", moduleParse, METH_O, "Parse a map from text." },
+		{ "step_batch", moduleStepBatch, METH_VARARGS, "Apply cmds[i] to maps[i] without holding the GIL." },
+		{ nullptr, nullptr, 0, nullptr },
+	};
+
+	PyModuleDef moduleDef = {
+		PyModuleDef_HEAD_INIT,
+		"lambdalifting",
+		"Lambda Lifting simulator.",
+		-1,
+		moduleMethods,
+	};
+
+#pragma endregion
+
+	PyTypeObject MapType = { PyVarObject_HEAD_INIT(nullptr, 0) "lambdalifting.Map" };
+	PyTypeObject StateType = { PyVarObject_HEAD_INIT(nullptr, 0) "lambdalifting._State" };
+
+} // unnamed namespace
+
+
+//-----------------------------------------------------------------------------
+//! W[
+//-----------------------------------------------------------------------------
+PyMODINIT_FUNC PyInit_lambdalifting(void)
+{
+	if (llVersion() != LL_API_VERSION) {
+		PyErr_SetString(PyExc_ImportError, "LambdaLifting API version mismatch");
+		return nullptr;
+	}
+
+	MapType.tp_basicsize = sizeof(MapObject);
+	MapType.tp_dealloc = reinterpret_cast<destructor>(mapDealloc);
+	MapType.tp_flags = Py_TPFLAGS_DEFAULT;
+	MapType.tp_doc = "Simulator state. Create with load() or parse().";
+	MapType.tp_methods = mapMethods;
+	MapType.tp_getset = mapGetSet;
+	MapType.tp_as_buffer = &mapBuffer;
+
+	StateType.tp_basicsize = sizeof(StateObject);
+	StateType.tp_dealloc = reinterpret_cast<destructor>(stateDealloc);
+	StateType.tp_flags = Py_TPFLAGS_DEFAULT;
+	StateType.tp_as_buffer = &stateBuffer;
+
+	if (PyType_Ready(&MapType) < 0 || PyType_Ready(&StateType) < 0)
+		return nullptr;
+
+	PyObject* module = PyModule_Create(&moduleDef);
+	if (!module)
+		return nullptr;
+
+	PyObject* fields = Py_BuildValue("(sssssssssssss)",
+		"robot_x", "robot_y", "lambda", "lambda_collected", "step_count", "score", "condition",
+		"water", "flooding_count", "waterproof_count", "growth_count", "razor", "beard");
+	if (PyModule_AddObject(module, "STATE_FIELDS", fields) < 0) {
+		Py_XDECREF(fields);
+		Py_DECREF(module);
+		return nullptr;
+	}
+
+	Py_INCREF(&MapType);
+	PyModule_AddObject(module, "Map", reinterpret_cast<PyObject*>(&MapType));
+	return module;
+}